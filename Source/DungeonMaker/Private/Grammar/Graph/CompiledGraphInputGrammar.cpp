@@ -0,0 +1,142 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CompiledGraphInputGrammar.h"
+#include "DungeonMaker.h"
+#include "GraphInputGrammar.h"
+#include "GraphEdge.h"
+#include "DungeonMissionEdge.h"
+
+bool FCompiledGraphInputGrammar::Compile(const UGraphInputGrammar* StartState)
+{
+	Reset();
+	if (StartState == NULL)
+	{
+		return false;
+	}
+
+	// Number every reachable state, and gather up the edges leaving each one
+	TArray<const UGraphInputGrammar*> states;
+	TMap<const UStateMachineState*, int32> stateIndices;
+	TArray<TArray<const UGraphEdge*>> stateEdges;
+	TArray<const UStateMachineSymbol*> columnSymbols;
+	states.Add(StartState);
+	stateIndices.Add(StartState, 0);
+	for (int32 i = 0; i < states.Num(); i++)
+	{
+		const UGraphInputGrammar* state = states[i];
+		TArray<const UGraphEdge*>& edges = stateEdges[stateEdges.AddDefaulted()];
+
+		TArray<UStateMachineBranch*> branches;
+		branches.Append(state->InstancedBranches);
+		branches.Append(state->SharedBranches);
+		for (const UStateMachineBranch* branch : branches)
+		{
+			// Subclasses could override how a branch is taken, which a table can't capture
+			if (branch == NULL || (branch->GetClass() != UGraphEdge::StaticClass() && branch->GetClass() != UDungeonMissionEdge::StaticClass()))
+			{
+				UE_LOG(LogStateMachine, Verbose, TEXT("Could not compile %s: %s is not a plain graph edge."), *StartState->GetName(), *GetNameSafe(branch));
+				Reset();
+				return false;
+			}
+			const UGraphEdge* edge = (const UGraphEdge*)branch;
+
+			const UStateMachineState* destination = edge->DestinationState;
+			if (destination != NULL && !stateIndices.Contains(destination))
+			{
+				if (!destination->IsA<UGraphInputGrammar>())
+				{
+					UE_LOG(LogStateMachine, Verbose, TEXT("Could not compile %s: %s is not a graph input grammar."), *StartState->GetName(), *destination->GetName());
+					Reset();
+					return false;
+				}
+				stateIndices.Add(destination, states.Num());
+				states.Add((const UGraphInputGrammar*)destination);
+			}
+
+			for (const UStateMachineSymbol* symbol : edge->GetAcceptableInputs())
+			{
+				if (!SymbolColumns.Contains(symbol))
+				{
+					SymbolColumns.Add(symbol, columnSymbols.Num());
+					columnSymbols.Add(symbol);
+				}
+			}
+			edges.Add(edge);
+		}
+	}
+
+	States.SetNum(states.Num());
+	for (int32 i = 0; i < states.Num(); i++)
+	{
+		States[i].State = states[i];
+		States[i].CompletionType = states[i]->GetCompletionType();
+		States[i].bTerminateImmediately = states[i]->ShouldTerminateImmediately();
+	}
+
+	ColumnCount = columnSymbols.Num() + 1;
+	Transitions.Init(NO_STATE, States.Num() * ColumnCount * CouplingCount);
+	for (int32 stateIndex = 0; stateIndex < States.Num(); stateIndex++)
+	{
+		for (int32 column = 0; column < ColumnCount; column++)
+		{
+			for (int32 coupling = 0; coupling < CouplingCount; coupling++)
+			{
+				// Mirrors UGraphEdge::TryCoupledBranch; the first edge to pass wins
+				for (const UGraphEdge* edge : stateEdges[stateIndex])
+				{
+					bool bPasses;
+					if (coupling != NoNextLink && (coupling == TightlyCoupled) != edge->bIsTightlyCoupled)
+					{
+						bPasses = edge->bReverseInputTest;
+					}
+					else
+					{
+						bool bAccepted = columnSymbols.IsValidIndex(column) && edge->AcceptsInput(columnSymbols[column]);
+						bPasses = bAccepted != edge->bReverseInputTest;
+					}
+
+					if (bPasses && edge->DestinationState != NULL)
+					{
+						Transitions[GetTransitionIndex(stateIndex, column, (ENextLinkCoupling)coupling)] = stateIndices[edge->DestinationState];
+						break;
+					}
+				}
+			}
+		}
+	}
+	return true;
+}
+
+FStateMachineResult FCompiledGraphInputGrammar::Run(const TArray<FGraphLink>& DataSource) const
+{
+	check(IsCompiled());
+	int32 stateIndex = 0;
+	int32 dataIndex = 0;
+	while (!States[stateIndex].bTerminateImmediately && DataSource.IsValidIndex(dataIndex))
+	{
+		const int32* symbolColumn = SymbolColumns.Find(DataSource[dataIndex].Symbol.Symbol);
+		int32 column = symbolColumn == NULL ? ColumnCount - 1 : *symbolColumn;
+
+		int32 nextState = Transitions[GetTransitionIndex(stateIndex, column, GetNextLinkCoupling(DataSource, dataIndex))];
+		if (nextState == NO_STATE)
+		{
+			break;
+		}
+		stateIndex = nextState;
+		dataIndex++;
+	}
+
+	const FCompiledState& finalState = States[stateIndex];
+	return FStateMachineResult(finalState.State, dataIndex, finalState.CompletionType);
+}
+
+bool FCompiledGraphInputGrammar::MightAcceptColumn(int32 Column, ENextLinkCoupling Coupling) const
+{
+	check(IsCompiled());
+	const FCompiledState& startState = States[0];
+	if (startState.bTerminateImmediately)
+	{
+		return startState.CompletionType == EStateMachineCompletionType::Accepted;
+	}
+	return startState.CompletionType == EStateMachineCompletionType::Accepted || Transitions[GetTransitionIndex(0, Column, Coupling)] != NO_STATE;
+}
@@ -3,33 +3,22 @@
 
 UGraphInputGrammar* UGraphEdge::TryCoupledBranch(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource, int32 DataIndex, int32& OutDataIndex)
 {
-	if (DataSource.IsValidIndex(DataIndex + 1))
+	OutDataIndex = DataIndex + 1;
+	// Check to see if the child should be tightly coupled to the parent
+	if (DataSource.IsValidIndex(DataIndex + 1) && DataSource[DataIndex + 1].bIsTightlyCoupled != bIsTightlyCoupled)
 	{
-		// Check to see if the child should be tightly coupled to the parent
-		if (DataSource[DataIndex + 1].bIsTightlyCoupled == bIsTightlyCoupled)
-		{
-			TArray<UStateMachineSymbol*> dataSource;
-			for (int i = 0; i < DataSource.Num(); i++)
-			{
-				dataSource.Add(DataSource[i].Symbol.Symbol);
-			}
-			return (UGraphInputGrammar*)TryBranch(ReferenceObject, dataSource, DataIndex, OutDataIndex);
-		}
-		else
-		{
-			UE_LOG(LogStateMachine, Verbose, TEXT("%s does not accept input %s due to coupling mismatch!"), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription());
-			OutDataIndex = DataIndex + 1;
-			return bReverseInputTest ? (UGraphInputGrammar*)DestinationState : NULL;
-		}
+		UE_LOG(LogStateMachine, Verbose, TEXT("%s does not accept input %s due to coupling mismatch!"), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription());
+		return bReverseInputTest ? (UGraphInputGrammar*)DestinationState : NULL;
+	}
+
+	if (DataSource.IsValidIndex(DataIndex) && AcceptsInput(DataSource[DataIndex].Symbol.Symbol))
+	{
+		UE_LOG(LogStateMachine, Verbose, TEXT("%s accepts input %s!"), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription());
+		return bReverseInputTest ? NULL : (UGraphInputGrammar*)DestinationState;
 	}
 	else
 	{
-		// No children to check for tight coupling
-		TArray<UStateMachineSymbol*> dataSource;
-		for (int i = 0; i < DataSource.Num(); i++)
-		{
-			dataSource.Add(DataSource[i].Symbol.Symbol);
-		}
-		return (UGraphInputGrammar*)TryBranch(ReferenceObject, dataSource, DataIndex, OutDataIndex);
+		UE_LOG(LogStateMachine, Verbose, TEXT("%s does not accept input %s!"), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription());
+		return bReverseInputTest ? (UGraphInputGrammar*)DestinationState : NULL;
 	}
 }
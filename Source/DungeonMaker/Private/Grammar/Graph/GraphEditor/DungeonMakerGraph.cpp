@@ -53,65 +53,31 @@ int32 UDungeonMakerGraph::UpdateNodeID(UDungeonMakerNode* NodeToUpdate, int32 In
 
 void UDungeonMakerGraph::Print(bool ToConsole /*= true*/, bool ToScreen /*= true*/)
 {
-	int Level = 0;
-	TArray<UDungeonMakerNode*> CurrLevelNodes = RootNodes;
-	TArray<UDungeonMakerNode*> NextLevelNodes;
-
-	while (CurrLevelNodes.Num() != 0)
+	FDungeonMakerGraphAnalysis::ForEachBreadthFirst(RootNodes, [ToConsole, ToScreen](UDungeonMakerNode* Node, int32 Level)
 	{
-		for (int i = 0; i < CurrLevelNodes.Num(); ++i)
-		{
-			UDungeonMakerNode* Node = CurrLevelNodes[i];
-			check(Node != nullptr);
-
-			FString Message = FString::Printf(TEXT("%s, Level %d"), *Node->GetNodeTitle(), Level);
-
-			if (ToConsole)
-			{
-				LOG_WARNING(TEXT("%s"), *Message);
-			}
-
-			if (ToScreen && GEngine != nullptr)
-			{
-				GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Red, Message);
-			}
+		FString Message = FString::Printf(TEXT("%s, Level %d"), *Node->GetNodeTitle(), Level);
 
-			for (int j = 0; j < Node->ChildrenNodes.Num(); ++j)
-			{
-				NextLevelNodes.Add(Node->ChildrenNodes[j]);
-			}
+		if (ToConsole)
+		{
+			LOG_WARNING(TEXT("%s"), *Message);
 		}
 
-		CurrLevelNodes = NextLevelNodes;
-		NextLevelNodes.Reset();
-		++Level;
-	}
+		if (ToScreen && GEngine != nullptr)
+		{
+			GEngine->AddOnScreenDebugMessage(-1, 15.f, FColor::Red, Message);
+		}
+	});
 }
 
 int UDungeonMakerGraph::GetLevelNum()
 {
+	// The number of levels is the number of nodes on the longest path down from any root
 	int Level = 0;
-	TArray<UDungeonMakerNode*> CurrLevelNodes = RootNodes;
-	TArray<UDungeonMakerNode*> NextLevelNodes;
-
-	while (CurrLevelNodes.Num() != 0)
+	for (UDungeonMakerNode* Node : RootNodes)
 	{
-		for (int i = 0; i < CurrLevelNodes.Num(); ++i)
-		{
-			UDungeonMakerNode* Node = CurrLevelNodes[i];
-			check(Node != nullptr);
-
-			for (int j = 0; j < Node->ChildrenNodes.Num(); ++j)
-			{
-				NextLevelNodes.Add(Node->ChildrenNodes[j]);
-			}
-		}
-
-		CurrLevelNodes = NextLevelNodes;
-		NextLevelNodes.Reset();
-		++Level;
+		check(Node != nullptr);
+		Level = FMath::Max(Level, Node->GetGraphAnalysis().GetLevelCount(Node));
 	}
-
 	return Level;
 }
 
@@ -119,6 +85,7 @@ void UDungeonMakerGraph::GetNodesByLevel(int Level, TArray<UDungeonMakerNode*>&
 {
 	int CurrLEvel = 0;
 	TArray<UDungeonMakerNode*> NextLevelNodes;
+	TSet<UDungeonMakerNode*> NextLevelSet;
 
 	Nodes = RootNodes;
 
@@ -134,12 +101,19 @@ void UDungeonMakerGraph::GetNodesByLevel(int Level, TArray<UDungeonMakerNode*>&
 
 			for (int j = 0; j < Node->ChildrenNodes.Num(); ++j)
 			{
-				NextLevelNodes.Add(Node->ChildrenNodes[j]);
+				// Nodes reachable along several paths only need to be looked at once per level
+				UDungeonMakerNode* Child = Node->ChildrenNodes[j];
+				if (!NextLevelSet.Contains(Child))
+				{
+					NextLevelSet.Add(Child);
+					NextLevelNodes.Add(Child);
+				}
 			}
 		}
 
-		Nodes = NextLevelNodes;
+		Swap(Nodes, NextLevelNodes);
 		NextLevelNodes.Reset();
+		NextLevelSet.Reset();
 		++CurrLEvel;
 	}
 }
@@ -150,6 +124,7 @@ void UDungeonMakerGraph::ClearGraph()
 	{
 		UDungeonMakerNode* Node = AllNodes[i];
 
+		Node->InvalidateGraphAnalysis();
 		Node->ParentNodes.Reset();
 		Node->ChildrenNodes.Reset();
 	}
@@ -0,0 +1,135 @@
+#include "DungeonMakerGraphAnalysis.h"
+#include "DungeonMakerNode.h"
+
+void FDungeonMakerGraphAnalysis::Build(const UDungeonMakerNode* StartNode)
+{
+	Nodes.Reset();
+	NodeIndices.Reset();
+	Depths.Reset();
+	LevelCounts.Reset();
+	Ancestors.Reset();
+	bIsValid = true;
+	if (StartNode == NULL)
+	{
+		return;
+	}
+
+	// Find everything connected to the start node, in either direction
+	TArray<const UDungeonMakerNode*> connected;
+	TSet<const UDungeonMakerNode*> found;
+	connected.Add(StartNode);
+	found.Add(StartNode);
+	for (int32 i = 0; i < connected.Num(); i++)
+	{
+		TArray<UDungeonMakerNode*> links = connected[i]->ChildrenNodes;
+		links.Append(connected[i]->ParentNodes);
+		for (const UDungeonMakerNode* node : links)
+		{
+			if (node != NULL && !found.Contains(node))
+			{
+				found.Add(node);
+				connected.Add(node);
+			}
+		}
+	}
+
+	// Sort them so every node comes after all of its parents
+	TMap<const UDungeonMakerNode*, int32> remainingParents;
+	for (const UDungeonMakerNode* node : connected)
+	{
+		int32 parentCount = 0;
+		for (const UDungeonMakerNode* parent : node->ParentNodes)
+		{
+			parentCount += parent != NULL;
+		}
+		remainingParents.Add(node, parentCount);
+		if (parentCount == 0)
+		{
+			Nodes.Add(node);
+		}
+	}
+	for (int32 i = 0; i < Nodes.Num(); i++)
+	{
+		for (const UDungeonMakerNode* child : Nodes[i]->ChildrenNodes)
+		{
+			int32* parentCount = remainingParents.Find(child);
+			// Only count links which the child agrees with
+			if (parentCount != NULL && *parentCount > 0 && child->ParentNodes.Contains(Nodes[i]))
+			{
+				(*parentCount)--;
+				if (*parentCount == 0)
+				{
+					Nodes.Add(child);
+				}
+			}
+		}
+	}
+	if (Nodes.Num() < connected.Num())
+	{
+		// Anything left over is part of a cycle; those go last, in the order they were found
+		for (const UDungeonMakerNode* node : connected)
+		{
+			if (remainingParents[node] > 0)
+			{
+				Nodes.Add(node);
+			}
+		}
+	}
+
+	for (int32 i = 0; i < Nodes.Num(); i++)
+	{
+		NodeIndices.Add(Nodes[i], i);
+	}
+	Depths.SetNumZeroed(Nodes.Num());
+	LevelCounts.Init(1, Nodes.Num());
+	Ancestors.Init(TBitArray<>(false, Nodes.Num()), Nodes.Num());
+
+	// With no cycles, one pass in order settles everything; a second pass just confirms it.
+	// Cycles need more passes, and are capped so they don't go on forever.
+	bool bChanged = true;
+	for (int32 pass = 0; bChanged && pass <= Nodes.Num(); pass++)
+	{
+		bChanged = false;
+		for (int32 i = 0; i < Nodes.Num(); i++)
+		{
+			for (const UDungeonMakerNode* parent : Nodes[i]->ParentNodes)
+			{
+				const int32* parentIndex = NodeIndices.Find(parent);
+				if (parentIndex == NULL)
+				{
+					continue;
+				}
+				if (Depths[*parentIndex] + 1 > Depths[i] && Depths[*parentIndex] < Nodes.Num())
+				{
+					Depths[i] = Depths[*parentIndex] + 1;
+					bChanged = true;
+				}
+				if (!Ancestors[i][*parentIndex])
+				{
+					Ancestors[i][*parentIndex] = true;
+					bChanged = true;
+				}
+				for (TConstSetBitIterator<> it(Ancestors[*parentIndex]); it; ++it)
+				{
+					if (!Ancestors[i][it.GetIndex()])
+					{
+						Ancestors[i][it.GetIndex()] = true;
+						bChanged = true;
+					}
+				}
+			}
+		}
+		for (int32 i = Nodes.Num() - 1; i >= 0; i--)
+		{
+			for (const UDungeonMakerNode* child : Nodes[i]->ChildrenNodes)
+			{
+				const int32* childIndex = NodeIndices.Find(child);
+				if (childIndex != NULL && LevelCounts[*childIndex] + 1 > LevelCounts[i] && LevelCounts[*childIndex] <= Nodes.Num())
+				{
+					LevelCounts[i] = LevelCounts[*childIndex] + 1;
+					bChanged = true;
+				}
+			}
+		}
+	}
+}
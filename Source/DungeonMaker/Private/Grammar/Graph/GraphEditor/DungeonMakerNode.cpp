@@ -70,19 +70,34 @@ FString UDungeonMakerNode::ToString(int32 IndentLevel, bool bPrintChildren)
 
 bool UDungeonMakerNode::IsChildOf(UDungeonMakerNode* ParentSymbol) const
 {
-	for (UDungeonMakerNode* parent : ParentNodes)
+	if (ParentSymbol == NULL || ParentNodes.Num() == 0)
 	{
-		if (parent == ParentSymbol)
-		{
-			return true;
-		}
-		// If our parent is a child of this symbol, so are we
-		if (parent->IsChildOf(ParentSymbol))
+		return false;
+	}
+	return GetGraphAnalysis().IsAncestorOf(ParentSymbol, this);
+}
+
+const FDungeonMakerGraphAnalysis& UDungeonMakerNode::GetGraphAnalysis() const
+{
+	if (!GraphAnalysis.IsValid() || !GraphAnalysis->IsValid())
+	{
+		TSharedPtr<FDungeonMakerGraphAnalysis> analysis = MakeShareable(new FDungeonMakerGraphAnalysis());
+		analysis->Build(this);
+		for (const UDungeonMakerNode* node : analysis->GetTopologicalOrder())
 		{
-			return true;
+			node->GraphAnalysis = analysis;
 		}
 	}
-	return false;
+	return *GraphAnalysis;
+}
+
+void UDungeonMakerNode::InvalidateGraphAnalysis()
+{
+	if (GraphAnalysis.IsValid())
+	{
+		GraphAnalysis->Invalidate();
+		GraphAnalysis.Reset();
+	}
 }
 
 FNumberedGraphSymbol UDungeonMakerNode::ToGraphSymbol() const
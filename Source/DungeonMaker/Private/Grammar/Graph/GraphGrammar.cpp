@@ -4,7 +4,7 @@
 
 EGrammarResultType UGraphGrammar::MatchesGrammar(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource) const
 {
-	FStateMachineResult result = ((UGraphInputGrammar*)RuleInput)->RunCoupledState(ReferenceObject, DataSource, TArray<UStateMachineBranch*>(), 0, -1);
+	FStateMachineResult result = ((UGraphInputGrammar*)RuleInput)->RunCoupledState(ReferenceObject, DataSource);
 	
 	if (result.CompletionType == EStateMachineCompletionType::Accepted)
 	{
@@ -2,64 +2,42 @@
 #include "GraphEdge.h"
 
 FStateMachineResult UGraphInputGrammar::RunCoupledState(const UObject* ReferenceObject,
-	const TArray<FGraphLink>& DataSource, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps)
+	const TArray<FGraphLink>& DataSource, int32 DataIndex, int32 RemainingSteps) const
 {
-	TArray<UStateMachineBranch*> branches;
-	if (InstancedBranches.Num() > 0)
+	const UGraphInputGrammar* currentState = this;
+	while (true)
 	{
-		branches.Append(InstancedBranches);
-	}
-	if (SharedBranches.Num() > 0)
-	{
-		branches.Append(SharedBranches);
-	}
-	return RunCoupledStateWithBranches(ReferenceObject, DataSource, branches, TakenBranches, DataIndex, RemainingSteps);
-}
-
-FStateMachineResult UGraphInputGrammar::RunCoupledStateWithBranches(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource,
-	TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps)
-{
-	bool bMustEndNow = (bTerminateImmediately || !DataSource.IsValidIndex(DataIndex));
-
-#if !UE_BUILD_SHIPPING
-	if (DataSource.IsValidIndex(DataIndex))
-	{
-//		UE_LOG(LogStateMachine, Log, TEXT("Running state machine %s for %s (Chain Length: %d)."), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription(), DataSource.Num());
-	}
-#endif
+		bool bMustEndNow = (currentState->bTerminateImmediately || !DataSource.IsValidIndex(DataIndex));
+		if (RemainingSteps == 0 || bMustEndNow)
+		{
+			return FStateMachineResult(currentState, DataIndex, bMustEndNow ? currentState->CompletionType : EStateMachineCompletionType::OutOfSteps);
+		}
 
-	if (RemainingSteps != 0 && !bMustEndNow)
-	{
-		UGraphInputGrammar* destinationState = NULL;
 		int32 destinationDataIndex = DataIndex;
-		for (int32 i = 0; i < Branches.Num(); i++)
+		UGraphInputGrammar* destinationState = currentState->TryCoupledBranches(ReferenceObject, DataSource, DataIndex, destinationDataIndex);
+		if (destinationState == NULL)
 		{
-			// Make sure the branch isn't null
-			check(Branches[i]);
-			UGraphEdge* edge = (UGraphEdge*)Branches[i];
-			destinationState = edge->TryCoupledBranch(ReferenceObject, DataSource, DataIndex, destinationDataIndex);
-			if (destinationState != NULL)
-			{
-				TakenBranches.Add(edge);
-				return destinationState->RunCoupledState(ReferenceObject, DataSource, TakenBranches, destinationDataIndex, RemainingSteps - 1);
-			}
+			return FStateMachineResult(currentState, DataIndex, currentState->CompletionType);
 		}
-		bMustEndNow = true;
+		currentState = destinationState;
+		DataIndex = destinationDataIndex;
+		RemainingSteps--;
 	}
+}
 
-	UStateMachineState* finishedState = this;
-	EStateMachineCompletionType completion = bMustEndNow ? this->CompletionType : EStateMachineCompletionType::OutOfSteps;
-
-/*#if !UE_BUILD_SHIPPING
-	if (DataSource.IsValidIndex(DataIndex))
-	{
-		UE_LOG(LogStateMachine, Log, TEXT("Finished running state machine %s for %s. Result: %d"), *GetName(), *DataSource[DataIndex].Symbol.GetSymbolDescription(), (int32)completion);
-	}
-	else
+UGraphInputGrammar* UGraphInputGrammar::TryCoupledBranches(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource,
+	int32 DataIndex, int32& OutDataIndex) const
+{
+	for (int32 i = 0; i < InstancedBranches.Num() + SharedBranches.Num(); i++)
 	{
-		UE_LOG(LogStateMachine, Log, TEXT("State machine %s had invalid data index. Result: %d"), *GetName(), (uint8)completion);
+		UStateMachineBranch* branch = i < InstancedBranches.Num() ? InstancedBranches[i] : SharedBranches[i - InstancedBranches.Num()];
+		// Make sure the branch isn't null
+		check(branch);
+		UGraphInputGrammar* destinationState = ((UGraphEdge*)branch)->TryCoupledBranch(ReferenceObject, DataSource, DataIndex, OutDataIndex);
+		if (destinationState != NULL)
+		{
+			return destinationState;
+		}
 	}
-#endif*/
-
-	return FStateMachineResult(finishedState, DataIndex, completion);
-}
\ No newline at end of file
+	return NULL;
+}
@@ -0,0 +1,169 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "CompiledMissionGrammar.h"
+#include "DungeonMissionGrammar.h"
+#include "GraphInputGrammar.h"
+#include "DungeonMaker.h"
+
+// Copies the nodes of a graph, working out node IDs the same way UDungeonMakerGraph::UpdateIDs does without writing them back
+static void CompileGraphNodes(const UDungeonMakerGraph* Graph, TArray<FCompiledOutputNode>& OutNodes, TMap<int32, int32>& OutNodeIDs, TArray<int32>& OutRootNodes)
+{
+	TMap<const UDungeonMakerNode*, int32> nodeIndices;
+	for (int32 i = 0; i < Graph->AllNodes.Num(); i++)
+	{
+		const UDungeonMakerNode* node = Graph->AllNodes[i];
+		nodeIndices.Add(node, i);
+
+		FCompiledOutputNode& outputNode = OutNodes[OutNodes.AddDefaulted()];
+		outputNode.NodeType = node->NodeType;
+		outputNode.bTightlyCoupledToParent = node->bTightlyCoupledToParent;
+
+		int32 nextID = i + 1;
+		if (node->InputNodeID > 0)
+		{
+			// Whoever already has the ID we're replacing gets the ID we would have had
+			if (OutNodeIDs.Contains(node->InputNodeID))
+			{
+				int32 displacedNode = OutNodeIDs[node->InputNodeID];
+				OutNodes[displacedNode].NodeID = nextID;
+				OutNodeIDs.Add(nextID, displacedNode);
+			}
+			nextID = node->InputNodeID;
+		}
+		outputNode.NodeID = nextID;
+		OutNodeIDs.Add(nextID, i);
+	}
+
+	for (int32 i = 0; i < Graph->AllNodes.Num(); i++)
+	{
+		for (const UDungeonMakerNode* child : Graph->AllNodes[i]->ChildrenNodes)
+		{
+			const int32* childIndex = nodeIndices.Find(child);
+			if (childIndex != NULL)
+			{
+				OutNodes[i].Children.Add(*childIndex);
+			}
+		}
+	}
+	for (const UDungeonMakerNode* root : Graph->RootNodes)
+	{
+		const int32* rootIndex = nodeIndices.Find(root);
+		if (rootIndex != NULL)
+		{
+			OutRootNodes.Add(*rootIndex);
+		}
+	}
+}
+
+FCompiledMissionGrammar::FCompiledMissionGrammar(const UDungeonMissionGrammar* SourceGrammar)
+{
+	check(SourceGrammar != NULL);
+	Grammar = SourceGrammar;
+	Weight = SourceGrammar->Weight;
+	bHasInputGraph = SourceGrammar->InputGraph != NULL;
+	if (bHasInputGraph)
+	{
+		TArray<FCompiledOutputNode> inputNodes;
+		TMap<int32, int32> inputNodeIDs;
+		TArray<int32> inputRootNodes;
+		CompileGraphNodes(SourceGrammar->InputGraph, inputNodes, inputNodeIDs, inputRootNodes);
+		if (!InputPattern.Compile(inputNodes))
+		{
+			UE_LOG(LogMissionGen, Warning, TEXT("%s has an input graph where some nodes can't be reached from node 1, so it will never match."), *SourceGrammar->GetName());
+		}
+	}
+	else if (SourceGrammar->RuleInput != NULL && SourceGrammar->RuleInput->IsA<UGraphInputGrammar>())
+	{
+		RuleInput.Compile((const UGraphInputGrammar*)SourceGrammar->RuleInput);
+	}
+
+	const UDungeonMakerGraph* graph = SourceGrammar->OutputGraph;
+	if (graph == NULL)
+	{
+		// Nothing would take over the matched nodes
+		InputPattern.Reset();
+		return;
+	}
+	CompileGraphNodes(graph, OutputNodes, OutputNodeIDs, OutputRootNodes);
+
+	// Any matched node which no output node takes over would get dropped, along with everything hanging off of it
+	for (int32 i = 0; i < InputPattern.Num(); i++)
+	{
+		if (!OutputNodeIDs.Contains(InputPattern.GetNodeID(i)))
+		{
+			UE_LOG(LogMissionGen, Warning, TEXT("%s has no output node replacing input node %d, so it will never match."), *SourceGrammar->GetName(), InputPattern.GetNodeID(i));
+			InputPattern.Reset();
+			break;
+		}
+	}
+
+	// Describe each level of the graph in turn
+	TArray<int32> currentLevel = OutputRootNodes;
+	TArray<int32> nextLevel;
+	while (currentLevel.Num() != 0)
+	{
+		for (int32 i = 0; i < currentLevel.Num(); i++)
+		{
+			const UDungeonMakerNode* node = graph->AllNodes[currentLevel[i]];
+			const FCompiledOutputNode& outputNode = OutputNodes[currentLevel[i]];
+			if (!node->CustomNodeTitle.IsEmpty())
+			{
+				OutputDescription.Append(node->CustomNodeTitle);
+			}
+			else if (outputNode.NodeType == NULL)
+			{
+				OutputDescription.Append("Null Node");
+			}
+			else
+			{
+				OutputDescription.Append(outputNode.NodeType->Description.ToString() + " (");
+				OutputDescription.AppendInt(outputNode.NodeID);
+				OutputDescription.AppendChar(')');
+			}
+			if (i + 1 < currentLevel.Num())
+			{
+				OutputDescription.Append(", ");
+			}
+			nextLevel.Append(outputNode.Children);
+		}
+		OutputDescription.Append("\n");
+		currentLevel = nextLevel;
+		nextLevel.Reset();
+	}
+}
+
+EGrammarResultType FCompiledMissionGrammar::MatchesGrammar(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource) const
+{
+	if (bHasInputGraph)
+	{
+		// Input graphs are matched as a whole by FMissionSubgraphPattern::Match, never link by link
+		return EGrammarResultType::Rejected;
+	}
+
+	FStateMachineResult result;
+	if (RuleInput.IsCompiled())
+	{
+		result = RuleInput.Run(DataSource);
+	}
+	else if (Grammar->RuleInput != NULL && Grammar->RuleInput->IsA<UGraphInputGrammar>())
+	{
+		result = ((const UGraphInputGrammar*)Grammar->RuleInput)->RunCoupledState(ReferenceObject, DataSource);
+	}
+	else
+	{
+		return EGrammarResultType::Rejected;
+	}
+
+	if (result.CompletionType == EStateMachineCompletionType::Accepted)
+	{
+		return EGrammarResultType::Accepted;
+	}
+	else if (result.CompletionType == EStateMachineCompletionType::NotAccepted)
+	{
+		return EGrammarResultType::InProgress;
+	}
+	else
+	{
+		return EGrammarResultType::Rejected;
+	}
+}
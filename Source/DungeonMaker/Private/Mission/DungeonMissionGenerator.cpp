@@ -5,6 +5,7 @@
 #include "Runtime/Core/Public/Containers/Queue.h"
 #include "Grammar/Grammar.h"
 #include "DrawDebugHelpers.h"
+#include "Async/ParallelFor.h"
 
 // Sets default values for this component's properties
 UDungeonMissionGenerator::UDungeonMissionGenerator()
@@ -12,43 +13,70 @@ UDungeonMissionGenerator::UDungeonMissionGenerator()
 	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
 	// off to improve performance if you don't need them.
 	PrimaryComponentTick.bCanEverTick = false;
+	CandidateCount = 1;
+	bBatchRewrites = false;
 }
 
 void UDungeonMissionGenerator::TryToCreateDungeon(FRandomStream& Stream)
 {
-	Head = NewObject<UDungeonMissionNode>();
-	Head->NodeType = HeadSymbol.Symbol;
-	Head->NodeID = HeadSymbol.SymbolID;
-	Head->bTightlyCoupledToParent = false;
-	UE_LOG(LogSpaceGen, Log, TEXT("Started with head node %s."), *Head->GetSymbolDescription());
-	DungeonSize = 0;
+#if WITH_EDITOR
+	// Input states and output graphs are separate assets, and may have been edited since the grammars were compiled
+	for (const UDungeonMissionGrammar* grammar : Grammars)
+	{
+		if (grammar != NULL)
+		{
+			grammar->CompileMissionGrammar();
+		}
+	}
+#endif
 
-	GrammarUsageCount.Empty();
-	TryToCreateDungeon(Head, Grammars, Stream, 255);
+	// From here on, grammars are only read through their compiled copies
+	GrammarIndex.Build(Grammars);
 
-	// Relabel all the node IDs with their (hopefully final) IDs
-	int32 currentID = 1;
-	TArray<UDungeonMissionNode*> nodes;
-	nodes.Add(Head);
-	TSet<UDungeonMissionNode*> processed;
-	while (nodes.Num() > 0)
+	int32 candidateCount = FMath::Max(CandidateCount, 1);
+	Candidates.SetNum(candidateCount);
+	if (candidateCount == 1)
+	{
+		CreateCandidate(Candidates[0], Stream);
+	}
+	else
 	{
-		UDungeonMissionNode* current = nodes[0];
-		nodes.RemoveAt(0);
-		if (processed.Contains(current))
+		// Every candidate gets its own stream, seeded in order, so the results don't depend on which thread finishes first
+		TArray<FRandomStream> candidateStreams;
+		for (int32 i = 0; i < candidateCount; i++)
 		{
-			continue;
+			candidateStreams.Add(FRandomStream(Stream.RandHelper(MAX_int32)));
 		}
+		ParallelFor(candidateCount, [this, &candidateStreams](int32 Index)
+		{
+			CreateCandidate(Candidates[Index], candidateStreams[Index]);
+		});
+	}
 
-		current->NodeID = currentID;
-		currentID++;
-		for (UDungeonMakerNode* node : current->ChildrenNodes)
+	// Keep the best candidate; ties go to whichever came first
+	int32 bestCandidate = 0;
+	for (int32 i = 0; i < candidateCount; i++)
+	{
+		Candidates[i].Score = ScoreCandidate(Candidates[i]);
+		if (Candidates[i].Score > Candidates[bestCandidate].Score)
 		{
-			nodes.Add((UDungeonMissionNode*)node);
+			bestCandidate = i;
+		}
+	}
+	const FMissionCandidate& chosen = Candidates[bestCandidate];
+	UE_LOG(LogMissionGen, Log, TEXT("Picked mission candidate %d of %d, with %d nodes and a score of %f."), bestCandidate + 1, candidateCount, chosen.NodeCount, chosen.Score);
+	DungeonSize = chosen.NodeCount;
+
+	// Only now that the mission is done do we need any objects for it
+	TArray<UDungeonMissionNode*> missionNodes;
+	Head = chosen.Graph.CreateMissionNodes(chosen.HeadNode, missionNodes);
+	UnresolvedHooks.Reset();
+	for (int32 hook : chosen.UnresolvedHookNodes)
+	{
+		if (missionNodes[hook] != NULL)
+		{
+			UnresolvedHooks.Add(missionNodes[hook]);
 		}
-		processed.Add(current);
-
-		DungeonSize++;
 	}
 
 #if !UE_BUILD_SHIPPING
@@ -57,116 +85,215 @@ void UDungeonMissionGenerator::TryToCreateDungeon(FRandomStream& Stream)
 #endif
 }
 
-void UDungeonMissionGenerator::FindNodeMatches(TArray<const UDungeonMissionGrammar*>& AllowedGrammars, 
-	UDungeonMissionNode* StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars)
+void UDungeonMissionGenerator::CreateCandidate(FMissionCandidate& Candidate, FRandomStream& Rng) const
+{
+	// The whole mission gets built in the candidate's graph, reusing whatever memory the last attempt used
+	Candidate.Graph.Reset();
+	Candidate.UnresolvedHookNodes.Reset();
+	Candidate.HeadNode = Candidate.Graph.AddNode(HeadSymbol.Symbol, HeadSymbol.SymbolID);
+	UE_LOG(LogSpaceGen, Log, TEXT("Started with head node %s."), *Candidate.Graph.GetSymbolDescription(Candidate.HeadNode));
+	Candidate.NodeCount = 0;
+	Candidate.Score = 0.0f;
+
+	Candidate.GrammarUsageCount.Init(0, GrammarIndex.NumOutputGraphs());
+	if (bBatchRewrites)
+	{
+		TryToCreateDungeonInBatches(Candidate, Candidate.HeadNode, GrammarIndex, Rng, 255);
+	}
+	else
+	{
+		TryToCreateDungeon(Candidate, Candidate.HeadNode, GrammarIndex, Rng, 255);
+	}
+
+	// Relabel all the node IDs with their (hopefully final) IDs
+	int32 currentID = 1;
+	TArray<int32> nodes;
+	nodes.Add(Candidate.HeadNode);
+	TArray<bool> processed;
+	processed.Init(false, Candidate.Graph.Num());
+	for (int32 i = 0; i < nodes.Num(); i++)
+	{
+		int32 current = nodes[i];
+		if (processed[current])
+		{
+			continue;
+		}
+
+		Candidate.Graph.GetNode(current).NodeID = currentID;
+		currentID++;
+		Candidate.Graph.GetChildren(current, nodes);
+		processed[current] = true;
+
+		Candidate.NodeCount++;
+	}
+}
+
+float UDungeonMissionGenerator::ScoreCandidate(const FMissionCandidate& Candidate) const
+{
+	float score = 0.0f;
+	for (const UMissionCandidateMetric* metric : CandidateMetrics)
+	{
+		if (metric != NULL)
+		{
+			score += metric->Weight * metric->ScoreCandidate(Candidate);
+		}
+	}
+	return score;
+}
+
+void UDungeonMissionGenerator::FindNodeMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars, 
+	int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const
 {
 	bool bFoundMatches = OutAcceptableGrammars.Num() > 0;
 	FGraphLink us;
-	us.Symbol = StartingLocation->ToGraphSymbol();
-	us.bIsTightlyCoupled = StartingLocation->bTightlyCoupledToParent;
+	us.Symbol = Candidate.Graph.ToGraphSymbol(StartingLocation);
+	us.bIsTightlyCoupled = Candidate.Graph.GetNode(StartingLocation).bTightlyCoupledToParent;
 
 	// We're only checking if us by ourselves is valid, so the array just needs to contain us.
-	TArray<FGraphLink> links;
+	TArray<FGraphLink>& links = Candidate.MatchLinks;
+	links.Reset();
 	links.Add(us);
 
 	UE_LOG(LogMissionGen, Verbose, TEXT("Checking if %s is a valid input."), *us.Symbol.GetSymbolDescription());
 
-	CheckGrammarMatches(AllowedGrammars, links, StartingLocation, bFoundMatches, OutAcceptableGrammars);
+	CheckGrammarMatches(Candidate, AllowedGrammars, links, StartingLocation, bFoundMatches, OutAcceptableGrammars);
 }
 
-void UDungeonMissionGenerator::FindMatchesWithChildren(TArray<const UDungeonMissionGrammar*>& AllowedGrammars, 
-	UDungeonMissionNode* StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars)
+void UDungeonMissionGenerator::FindMatchesWithChildren(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars, 
+	int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const
 {
 	// We have children; we should check to see if we have a grammar which accepts us and our children
 	// Define us first
 	FGraphLink us;
-	us.Symbol = StartingLocation->ToGraphSymbol();
-	us.bIsTightlyCoupled = StartingLocation->bTightlyCoupledToParent;
+	us.Symbol = Candidate.Graph.ToGraphSymbol(StartingLocation);
+	us.bIsTightlyCoupled = Candidate.Graph.GetNode(StartingLocation).bTightlyCoupledToParent;
 
 	UE_LOG(LogMissionGen, Verbose, TEXT("Trying to match childen of %s!"), *us.Symbol.GetSymbolDescription());
 
 	// Iterate over each child
-	for (UDungeonMakerNode* nextNode : StartingLocation->ChildrenNodes)
+	Candidate.Graph.ForEachChild(StartingLocation, [&](int32 nextNode)
 	{
 		// Add ourselves to the array
-		TArray<FGraphLink> links;
+		TArray<FGraphLink>& links = Candidate.MatchLinks;
+		links.Reset();
 		links.Add(us);
 
 		FGraphLink next;
-		next.Symbol = nextNode->ToGraphSymbol();
-		next.bIsTightlyCoupled = nextNode->bTightlyCoupledToParent;
+		next.Symbol = Candidate.Graph.ToGraphSymbol(nextNode);
+		next.bIsTightlyCoupled = Candidate.Graph.GetNode(nextNode).bTightlyCoupledToParent;
 
 		links.Add(next);
 
 		UE_LOG(LogMissionGen, Verbose, TEXT("Checking coupling %s->%s"), *us.Symbol.GetSymbolDescription(), *next.Symbol.GetSymbolDescription());
 
-		CheckGrammarMatches(AllowedGrammars, links, StartingLocation, false, OutAcceptableGrammars);
-	}
+		CheckGrammarMatches(Candidate, AllowedGrammars, links, StartingLocation, false, OutAcceptableGrammars);
+	});
 
 #if !UE_BUILD_SHIPPING
 	if (OutAcceptableGrammars.Num() == 0)
 	{
-		UE_LOG(LogMissionGen, Warning, TEXT("No symbols matched any child combination of %s."), *StartingLocation->GetSymbolDescription());
+		UE_LOG(LogMissionGen, Warning, TEXT("No symbols matched any child combination of %s."), *Candidate.Graph.GetSymbolDescription(StartingLocation));
 	}
 #endif
 }
 
-void UDungeonMissionGenerator::CheckGrammarMatches(TArray<const UDungeonMissionGrammar*>& AllowedGrammars,
-	const TArray<FGraphLink>& Links, UDungeonMissionNode* StartingLocation, bool bFoundMatches, 
-	TArray<FGraphOutput>& OutAcceptableGrammars)
+void UDungeonMissionGenerator::CheckGrammarMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+	const TArray<FGraphLink>& Links, int32 StartingLocation, bool bFoundMatches, 
+	TArray<FGraphOutput>& OutAcceptableGrammars) const
 {
-	for (int i = 0; i < AllowedGrammars.Num(); i++)
+	// Only grammars which could start with our symbol need to be run
+	const TArray<FIndexedMissionGrammar>& candidateGrammars = AllowedGrammars.GetCandidates(Links);
+	for (int i = 0; i < candidateGrammars.Num(); i++)
 	{
-		// Iterate over all grammars
-		const UDungeonMissionGrammar* grammar = AllowedGrammars[i];
+		const FCompiledMissionGrammar* grammar = candidateGrammars[i].Grammar;
 
 		EGrammarResultType resultType = grammar->MatchesGrammar(this, Links);
 		if (resultType == EGrammarResultType::Accepted)
 		{
 			// We can replace ourselves with a new symbol!
 
-			UDungeonMakerGraph* graph = ((UGraphGrammar*)grammar)->OutputGraph;
 #if !UE_BUILD_SHIPPING
-			FString linkString = "";
-			for (int i = 0; i < Links.Num(); i++)
+			if (UE_LOG_ACTIVE(LogMissionGen, Verbose))
 			{
-				linkString.Append(Links[i].Symbol.GetSymbolDescription());
-				if (i + 1 < Links.Num())
+				FString linkString = "";
+				for (int i = 0; i < Links.Num(); i++)
 				{
-					if (Links[i + 1].bIsTightlyCoupled)
+					linkString.Append(Links[i].Symbol.GetSymbolDescription());
+					if (i + 1 < Links.Num())
 					{
-						linkString.Append("=>");
-					}
-					else
-					{
-						linkString.Append("->");
+						if (Links[i + 1].bIsTightlyCoupled)
+						{
+							linkString.Append("=>");
+						}
+						else
+						{
+							linkString.Append("->");
+						}
 					}
 				}
+				UE_LOG(LogMissionGen, Verbose, TEXT("Matching grammar found! %s can be replaced by %s."), *linkString, *grammar->GetOutputDescription());
 			}
-			UE_LOG(LogMissionGen, Verbose, TEXT("Matching grammar found! %s can be replaced by %s."), *linkString, *graph->ToString());
 #endif
-			// Make us less likely to be chosen if we've been chosen a lot before
-			float weightModifier = 1.0f;
-			FString outputString = graph->ToString();
-			if (GrammarUsageCount.Contains(outputString))
-			{
-				weightModifier /= GrammarUsageCount[outputString];
-			}
-			if (bFoundMatches)
-			{
-				// We already have good matches which match more nodes, so it should be less likely to match these ones
-				weightModifier *= 0.25f;
-			}
-			FGraphOutput replaceResult;
-			replaceResult.Graph = graph;
-			replaceResult.Weight = grammar->Weight * weightModifier;
-			replaceResult.MatchedLinks = Links;
 			// Add it to the list of things we can do to ourselves
-			OutAcceptableGrammars.Add(replaceResult);
+			FGraphOutput& replaceResult = AddAcceptableGrammar(Candidate, candidateGrammars[i], bFoundMatches, OutAcceptableGrammars);
+			replaceResult.FirstMatchedLink = Candidate.MatchedLinkPool.Num();
+			replaceResult.MatchedLinkCount = Links.Num();
+			Candidate.MatchedLinkPool.Append(Links);
 		}
 	}
 }
 
+void UDungeonMissionGenerator::FindPatternMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+	int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const
+{
+	// Only input graphs rooted at our symbol can match
+	const TArray<FIndexedMissionGrammar>* candidateGrammars = AllowedGrammars.GetPatternCandidates(Candidate.Graph.GetNode(StartingLocation).NodeType);
+	if (candidateGrammars == NULL)
+	{
+		return;
+	}
+
+	for (const FIndexedMissionGrammar& candidateGrammar : *candidateGrammars)
+	{
+		const FCompiledMissionGrammar* grammar = candidateGrammar.Grammar;
+		if (!grammar->GetInputPattern().Match(Candidate.Graph, StartingLocation, Candidate.MatchNodes))
+		{
+			continue;
+		}
+
+		UE_LOG(LogMissionGen, Verbose, TEXT("Matching input graph found! %d nodes from %s can be replaced by %s."), 
+			Candidate.MatchNodes.Num(), *Candidate.Graph.GetSymbolDescription(StartingLocation), *grammar->GetOutputDescription());
+
+		FGraphOutput& replaceResult = AddAcceptableGrammar(Candidate, candidateGrammar, false, OutAcceptableGrammars);
+		replaceResult.FirstMatchedNode = Candidate.MatchedNodePool.Num();
+		replaceResult.MatchedNodeCount = Candidate.MatchNodes.Num();
+		Candidate.MatchedNodePool.Append(Candidate.MatchNodes);
+	}
+}
+
+FGraphOutput& UDungeonMissionGenerator::AddAcceptableGrammar(const FMissionCandidate& Candidate, const FIndexedMissionGrammar& Grammar,
+	bool bFoundMatches, TArray<FGraphOutput>& OutAcceptableGrammars) const
+{
+	// Make us less likely to be chosen if we've been chosen a lot before
+	float weightModifier = 1.0f;
+	int32 graphID = Grammar.OutputGraphID;
+	if (Candidate.GrammarUsageCount.IsValidIndex(graphID) && Candidate.GrammarUsageCount[graphID] > 0)
+	{
+		weightModifier /= Candidate.GrammarUsageCount[graphID];
+	}
+	if (bFoundMatches)
+	{
+		// We already have good matches which match more nodes, so it should be less likely to match these ones
+		weightModifier *= 0.25f;
+	}
+	FGraphOutput& replaceResult = OutAcceptableGrammars[OutAcceptableGrammars.AddDefaulted()];
+	replaceResult.Graph = Grammar.Grammar->GetGrammar()->OutputGraph;
+	replaceResult.CompiledGrammar = Grammar.Grammar;
+	replaceResult.Weight = Grammar.Grammar->GetWeight() * weightModifier;
+	replaceResult.GraphID = graphID;
+	return replaceResult;
+}
+
 void UDungeonMissionGenerator::DrawDebugDungeon()
 {
 	check(Head != NULL && Head->NodeType != NULL);
@@ -245,258 +372,521 @@ void UDungeonMissionGenerator::PrintDebugDungeon()
 	UE_LOG(LogMissionGen, Log, TEXT("%s"), *Head->ToString(0));
 }
 
-void UDungeonMissionGenerator::TryToCreateDungeon(UDungeonMissionNode* StartingLocation, 
-	TArray<const UDungeonMissionGrammar*> AllowedGrammars, FRandomStream& Rng, int32 RemainingMaxStepCount)
+void UDungeonMissionGenerator::TryToCreateDungeon(FMissionCandidate& Candidate, int32 StartingLocation, 
+	const FDungeonMissionGrammarIndex& AllowedGrammars, FRandomStream& Rng, int32 RemainingMaxStepCount) const
 {
-	checkf(StartingLocation != NULL, TEXT("Starting node for dungeon generation was null!"));
-	checkf(StartingLocation->IsValidLowLevel(), TEXT("Starting node for dungeon generation was invalid!"));
-	checkf(StartingLocation->NodeType != NULL, TEXT("Starting node for dungeon generation had no symbols!"));
 	checkf(AllowedGrammars.Num() > 0, TEXT("There were no allowed grammars for dungeon generation!"));
-	checkf(RemainingMaxStepCount >= 0, TEXT("Dungeon generation ran out of steps! You have an overflow issue."));
 
-	if (StartingLocation->NodeType->bIsTerminalNode)
+	// Nodes waiting to be rewritten, along with how many more steps they can take.
+	// The next node to process is always at the end, so the dungeon is built depth-first.
+	TArray<TPair<int32, int32>> worklist;
+	worklist.Add(TPair<int32, int32>(StartingLocation, RemainingMaxStepCount));
+
+	TArray<FGraphOutput> acceptableGrammars;
+	TArray<int32> children;
+	while (worklist.Num() > 0)
 	{
-		// This node has already been processed completely and turned into a terminal node
-		for (UDungeonMakerNode* node : StartingLocation->ChildrenNodes)
+		TPair<int32, int32> next = worklist.Pop(false);
+		int32 current = next.Key;
+		int32 remainingSteps = next.Value;
+		checkf(Candidate.Graph.IsValidNode(current), TEXT("Starting node for dungeon generation was invalid!"));
+		checkf(Candidate.Graph.GetNode(current).NodeType != NULL, TEXT("Starting node for dungeon generation had no symbols!"));
+
+		bool bProcessChildren = false;
+		if (Candidate.Graph.GetNode(current).NodeType->bIsTerminalNode)
 		{
-			// Try and process each child
-			TryToCreateDungeon((UDungeonMissionNode*)node, AllowedGrammars, Rng, RemainingMaxStepCount - 1);
+			// This node has already been processed completely and turned into a terminal node
+			bProcessChildren = true;
+		}
+		else if (remainingSteps < 0)
+		{
+			UE_LOG(LogMissionGen, Error, TEXT("Dungeon generation ran out of steps at %s! You may have grammars which replace each other forever."), *Candidate.Graph.GetSymbolDescription(current));
+			Candidate.UnresolvedHookNodes.Add(current);
+			bProcessChildren = true;
+		}
+		else
+		{
+			UE_LOG(LogMissionGen, Log, TEXT("Trying to create a dungeon starting from %s."), *Candidate.Graph.GetSymbolDescription(current));
+
+			acceptableGrammars.Reset();
+			Candidate.ResetMatches();
+			FindPatternMatches(Candidate, AllowedGrammars, current, acceptableGrammars);
+			if (Candidate.Graph.HasChildren(current))
+			{
+				FindMatchesWithChildren(Candidate, AllowedGrammars, current, acceptableGrammars);
+			}
+
+			// Try to see if we have a grammar that accepts only us
+			FindNodeMatches(Candidate, AllowedGrammars, current, acceptableGrammars);
+
+			UE_LOG(LogMissionGen, Verbose, TEXT("Found %d acceptable grammars for %s."), acceptableGrammars.Num(), *Candidate.Graph.GetSymbolDescription(current));
+
+			// Replace and look again
+			if (ReplaceDungeonNodes(Candidate, current, acceptableGrammars, Rng))
+			{
+				worklist.Add(TPair<int32, int32>(current, remainingSteps - 1));
+			}
+			else
+			{
+				// No matching grammars; turn into a hook
+				UE_LOG(LogMissionGen, Error, TEXT("%s had no matching grammars."), *Candidate.Graph.GetSymbolDescription(current));
+				Candidate.UnresolvedHookNodes.Add(current);
+				bProcessChildren = true;
+			}
+		}
+
+		if (bProcessChildren)
+		{
+			// Push the children backwards, so the first child gets processed first
+			children.Reset();
+			Candidate.Graph.GetChildren(current, children);
+			for (int32 i = children.Num() - 1; i >= 0; i--)
+			{
+				worklist.Add(TPair<int32, int32>(children[i], remainingSteps - 1));
+			}
 		}
-		return;
 	}
+}
+
+void UDungeonMissionGenerator::TryToCreateDungeonInBatches(FMissionCandidate& Candidate, int32 StartingLocation,
+	const FDungeonMissionGrammarIndex& AllowedGrammars, FRandomStream& Rng, int32 MaxPassCount) const
+{
+	checkf(AllowedGrammars.Num() > 0, TEXT("There were no allowed grammars for dungeon generation!"));
+	checkf(Candidate.Graph.IsValidNode(StartingLocation), TEXT("Starting node for dungeon generation was invalid!"));
 
-	UE_LOG(LogMissionGen, Log, TEXT("Trying to create a dungeon starting from %s."), *StartingLocation->GetSymbolDescription());
+	struct FPendingRewrite
+	{
+		int32 Node;
+		int32 MatchedChild;
+		FGraphOutput Output;
+	};
+
+	// Finds every node which still needs to be rewritten, parents first
+	TArray<int32> nonTerminalNodes;
+	TArray<int32> nodes;
+	TArray<bool> visited;
+	auto findNonTerminalNodes = [&Candidate, StartingLocation, &nonTerminalNodes, &nodes, &visited]()
+	{
+		nonTerminalNodes.Reset();
+		nodes.Reset();
+		nodes.Add(StartingLocation);
+		visited.Init(false, Candidate.Graph.Num());
+		for (int32 i = 0; i < nodes.Num(); i++)
+		{
+			int32 current = nodes[i];
+			if (visited[current])
+			{
+				continue;
+			}
+			visited[current] = true;
+			checkf(Candidate.Graph.GetNode(current).NodeType != NULL, TEXT("Node in dungeon generation had no symbols!"));
+			if (!Candidate.Graph.GetNode(current).NodeType->bIsTerminalNode)
+			{
+				nonTerminalNodes.Add(current);
+			}
+			Candidate.Graph.GetChildren(current, nodes);
+		}
+	};
 
+	TArray<FPendingRewrite> rewrites;
 	TArray<FGraphOutput> acceptableGrammars;
-	if (StartingLocation->ChildrenNodes.Num() > 0)
+	TArray<bool> claimed;
+	int32 passCount = 0;
+	for (; passCount < MaxPassCount; passCount++)
 	{
-		FindMatchesWithChildren(AllowedGrammars, StartingLocation, acceptableGrammars);
-	}
+		findNonTerminalNodes();
 
-	// Try to see if we have a grammar that accepts only us
-	FindNodeMatches(AllowedGrammars, StartingLocation, acceptableGrammars);
+		// Pick a rewrite for every node, all against the mission as it was at the start of the pass
+		// Rewrites point into the matched pools until they're applied, so those are only reset once per pass
+		rewrites.Reset();
+		Candidate.ResetMatches();
+		for (int32 current : nonTerminalNodes)
+		{
+			acceptableGrammars.Reset();
+			FindPatternMatches(Candidate, AllowedGrammars, current, acceptableGrammars);
+			if (Candidate.Graph.HasChildren(current))
+			{
+				FindMatchesWithChildren(Candidate, AllowedGrammars, current, acceptableGrammars);
+			}
+			FindNodeMatches(Candidate, AllowedGrammars, current, acceptableGrammars);
 
-	UE_LOG(LogMissionGen, Verbose, TEXT("Found %d acceptable grammars for %s."), acceptableGrammars.Num(), *StartingLocation->GetSymbolDescription());
+			int32 chosenIndex = ChooseGrammar(acceptableGrammars, Rng);
+			if (chosenIndex == INDEX_NONE)
+			{
+				continue;
+			}
+			FPendingRewrite& rewrite = rewrites[rewrites.AddDefaulted()];
+			rewrite.Node = current;
+			rewrite.Output = acceptableGrammars[chosenIndex];
+			rewrite.MatchedChild = FMissionGraph::NO_NODE;
+			if (rewrite.Output.MatchedLinkCount > 1)
+			{
+				rewrite.MatchedChild = Candidate.Graph.FindChildNodeFromSymbol(current, Candidate.GetMatchedLinks(rewrite.Output)[1].Symbol);
+			}
+		}
+		if (rewrites.Num() == 0)
+		{
+			// Nothing left can change
+			break;
+		}
 
-	// Replace and look again
-	if (acceptableGrammars.Num() > 0)
-	{
-		ReplaceDungeonNodes(StartingLocation, acceptableGrammars, Rng);
-		TryToCreateDungeon(StartingLocation, AllowedGrammars, Rng, RemainingMaxStepCount - 1);
+		// Rewrites which share a node can't both happen; shuffling decides which one wins
+		for (int32 i = rewrites.Num() - 1; i > 0; i--)
+		{
+			rewrites.Swap(i, Rng.RandRange(0, i));
+		}
+		claimed.Init(false, Candidate.Graph.Num());
+		int32 appliedCount = 0;
+		for (const FPendingRewrite& rewrite : rewrites)
+		{
+			bool bConflicts = claimed[rewrite.Node] || (rewrite.MatchedChild != FMissionGraph::NO_NODE && claimed[rewrite.MatchedChild]);
+			for (int32 matchedNode : Candidate.GetMatchedNodes(rewrite.Output))
+			{
+				bConflicts |= claimed[matchedNode];
+			}
+			if (bConflicts)
+			{
+				// Try again next pass
+				continue;
+			}
+			claimed[rewrite.Node] = true;
+			if (rewrite.MatchedChild != FMissionGraph::NO_NODE)
+			{
+				claimed[rewrite.MatchedChild] = true;
+			}
+			for (int32 matchedNode : Candidate.GetMatchedNodes(rewrite.Output))
+			{
+				claimed[matchedNode] = true;
+			}
+
+			if (Candidate.GrammarUsageCount.IsValidIndex(rewrite.Output.GraphID))
+			{
+				Candidate.GrammarUsageCount[rewrite.Output.GraphID] += 1;
+			}
+			if (rewrite.Output.MatchedNodeCount > 0)
+			{
+				ReplaceSubgraph(Candidate, rewrite.Output);
+			}
+			else
+			{
+				ReplaceNodes(Candidate, rewrite.Node, rewrite.MatchedChild, rewrite.Output);
+			}
+			appliedCount++;
+		}
+		UE_LOG(LogMissionGen, Log, TEXT("Pass %d applied %d of %d rewrites."), passCount + 1, appliedCount, rewrites.Num());
 	}
-	else
+
+	// Anything which still isn't terminal is a hook
+	findNonTerminalNodes();
+	for (int32 current : nonTerminalNodes)
 	{
-		// No matching grammars; turn into a hook
-		UE_LOG(LogMissionGen, Error, TEXT("%s had no matching grammars."), *StartingLocation->GetSymbolDescription());
-		UnresolvedHooks.Add(StartingLocation);
-		for (UDungeonMakerNode* node : StartingLocation->ChildrenNodes)
+		if (passCount >= MaxPassCount)
 		{
-			// Try and process each child
-			TryToCreateDungeon((UDungeonMissionNode*)node, AllowedGrammars, Rng, RemainingMaxStepCount - 1);
+			UE_LOG(LogMissionGen, Error, TEXT("Dungeon generation ran out of steps at %s! You may have grammars which replace each other forever."), *Candidate.Graph.GetSymbolDescription(current));
 		}
+		else
+		{
+			UE_LOG(LogMissionGen, Error, TEXT("%s had no matching grammars."), *Candidate.Graph.GetSymbolDescription(current));
+		}
+		Candidate.UnresolvedHookNodes.Add(current);
 	}
 }
 
-void UDungeonMissionGenerator::ReplaceDungeonNodes(UDungeonMissionNode* StartingLocation, 
-	TArray<FGraphOutput> AcceptableGrammars, FRandomStream& Rng)
+int32 UDungeonMissionGenerator::ChooseGrammar(const TArray<FGraphOutput>& AcceptableGrammars, FRandomStream& Rng) const
 {
-	checkf(AcceptableGrammars.Num() > 0, TEXT("There weren't any accepted grammars!"));
-	int32 index = Rng.RandRange(0, AcceptableGrammars.Num() - 1);
-	FGraphOutput grammarReplaceResult = AcceptableGrammars[index];
-	if (grammarReplaceResult.Weight <= 0.0f)
+	// Grammars get picked with a chance proportional to Weight / (Weight + 1).
+	// Higher weights are more likely, but no single grammar can crowd out the rest.
+	// Anything with no weight is never picked.
+	float totalWeight = 0.0f;
+	for (const FGraphOutput& grammar : AcceptableGrammars)
 	{
-		AcceptableGrammars.RemoveAt(index);
-		ReplaceDungeonNodes(StartingLocation, AcceptableGrammars, Rng);
-		return;
+		if (grammar.Weight > 0.0f)
+		{
+			totalWeight += grammar.Weight / (grammar.Weight + 1.0f);
+		}
 	}
-	else if(AcceptableGrammars.Num() > 1)
+	if (totalWeight <= 0.0f)
+	{
+		return INDEX_NONE;
+	}
+
+	// Walk the running total until we pass the chosen point
+	float chosenWeight = Rng.GetFraction() * totalWeight;
+	int32 chosenIndex = INDEX_NONE;
+	float runningWeight = 0.0f;
+	for (int32 i = 0; i < AcceptableGrammars.Num(); i++)
 	{
-		// Higher weights are more likely to be kept
-		float replaceChance = 1.0f / (grammarReplaceResult.Weight + 1);
-		float rngAmount = Rng.GetFraction();
-		if (rngAmount < replaceChance)
+		float weight = AcceptableGrammars[i].Weight;
+		if (weight <= 0.0f)
 		{
-			// Toss it back and get a new one
-			ReplaceDungeonNodes(StartingLocation, AcceptableGrammars, Rng);
-			return;
+			continue;
+		}
+		// Always land on something, even if rounding leaves the total just short of chosenWeight
+		chosenIndex = i;
+		runningWeight += weight / (weight + 1.0f);
+		if (chosenWeight < runningWeight)
+		{
+			break;
 		}
 	}
+	return chosenIndex;
+}
 
-	FString grammarString = grammarReplaceResult.Graph->ToString();
-	if (GrammarUsageCount.Contains(grammarString))
+bool UDungeonMissionGenerator::ReplaceDungeonNodes(FMissionCandidate& Candidate, int32 StartingLocation, 
+	const TArray<FGraphOutput>& AcceptableGrammars, FRandomStream& Rng) const
+{
+	int32 chosenIndex = ChooseGrammar(AcceptableGrammars, Rng);
+	if (chosenIndex == INDEX_NONE)
 	{
-		GrammarUsageCount[grammarString] += 1;
+		return false;
 	}
-	else
+	const FGraphOutput& grammarReplaceResult = AcceptableGrammars[chosenIndex];
+
+	if (Candidate.GrammarUsageCount.IsValidIndex(grammarReplaceResult.GraphID))
 	{
-		GrammarUsageCount.Add(grammarString, 1);
+		Candidate.GrammarUsageCount[grammarReplaceResult.GraphID] += 1;
 	}
 
 	// Actually do the replacement
-	ReplaceNodes(StartingLocation, grammarReplaceResult);
+	if (grammarReplaceResult.MatchedNodeCount > 0)
+	{
+		ReplaceSubgraph(Candidate, grammarReplaceResult);
+		return true;
+	}
+	int32 matchedChild = FMissionGraph::NO_NODE;
+	if (grammarReplaceResult.MatchedLinkCount > 1)
+	{
+		matchedChild = Candidate.Graph.FindChildNodeFromSymbol(StartingLocation, Candidate.GetMatchedLinks(grammarReplaceResult)[1].Symbol);
+	}
+	ReplaceNodes(Candidate, StartingLocation, matchedChild, grammarReplaceResult);
+	return true;
 }
 
-void UDungeonMissionGenerator::ReplaceNodes(UDungeonMissionNode* StartingLocation, 
-	const FGraphOutput& GrammarReplaceResult)
+void UDungeonMissionGenerator::ReplaceNodes(FMissionCandidate& Candidate, int32 StartingLocation, int32 MatchedChild,
+	const FGraphOutput& GrammarReplaceResult) const
 {
-	// Find the matched nodes
-	UDungeonMissionNode* startLocation = StartingLocation;
-	UDungeonMissionNode* replaceLocation = NULL;
-	if (GrammarReplaceResult.MatchedLinks.Num() > 1)
-	{
-		replaceLocation = (UDungeonMissionNode*)StartingLocation->FindChildNodeFromSymbol(GrammarReplaceResult.MatchedLinks[1].Symbol);
-	}
+	int32 startLocation = StartingLocation;
+	int32 replaceLocation = MatchedChild;
 
 	// Number the nodes
-	startLocation->NodeID = 1;
-	if (replaceLocation != NULL)
+	Candidate.Graph.GetNode(startLocation).NodeID = 1;
+	if (replaceLocation != FMissionGraph::NO_NODE)
 	{
-		replaceLocation->NodeID = 2;
+		Candidate.Graph.GetNode(replaceLocation).NodeID = 2;
 	}
 
-	FString initialShape = startLocation->GetSymbolDescription();
-	if (replaceLocation != NULL)
+	FString initialShape = Candidate.Graph.GetSymbolDescription(startLocation);
+	if (replaceLocation != FMissionGraph::NO_NODE)
 	{
 		initialShape.Append("->");
-		initialShape.Append(replaceLocation->GetSymbolDescription());
+		initialShape.Append(Candidate.Graph.GetSymbolDescription(replaceLocation));
 	}
 
-	TMap<int32, UDungeonMissionNode*> nodeMap;
+	TMap<int32, int32> nodeMap;
 	nodeMap.Add(1, startLocation);
-	if (replaceLocation != NULL)
+	if (replaceLocation != FMissionGraph::NO_NODE)
 	{
 		nodeMap.Add(2, replaceLocation);
 	}
 
 	// Break their parent-child link
-	UDungeonMakerGraph* graph = GrammarReplaceResult.Graph;
-	if (graph->GetLevelNum() == 0)
+	const FCompiledMissionGrammar* grammar = GrammarReplaceResult.CompiledGrammar;
+	checkf(grammar != NULL, TEXT("Replacement for %s didn't come from a compiled grammar!"), *initialShape);
+	if (!grammar->HasOutput())
 	{
 		UE_LOG(LogMissionGen, Error, TEXT("Replacement grammar was null! Nodes that were to be replaced: %s"), *initialShape);
 		return;
 	}
 
-	graph->UpdateIDs();
-
-	FString grammarChain = graph->ToString();
-	UE_LOG(LogMissionGen, Log, TEXT("Replacing %s with %s (Total Length: %d)."), *initialShape, *grammarChain, graph->Num());
+	const FString& grammarChain = grammar->GetOutputDescription();
+	UE_LOG(LogMissionGen, Log, TEXT("Replacing %s with %s (Total Length: %d)."), *initialShape, *grammarChain, grammar->NumOutputNodes());
 
-	TArray<UDungeonMakerNode*> toProcess;
-	if (!graph->NodeIDLookup.Contains(1))
+	int32 head = grammar->FindOutputNode(1);
+	if (head == INDEX_NONE)
 	{
 		UE_LOG(LogMissionGen, Error, TEXT("No root symbol found when replacing %s with %s."), *initialShape, *grammarChain);
 		return;
 	}
-	UDungeonMakerNode* head = graph->NodeIDLookup[1];
-	if (head->NodeType == NULL)
+	if (grammar->GetOutputNode(head).NodeType == NULL)
 	{
 		UE_LOG(LogMissionGen, Error, TEXT("Encounted a null head symbol replacing %s with %s."), *initialShape, *grammarChain);
 		return;
 	}
 
-	if (!startLocation->NodeType->bIsTerminalNode)
+	FMissionGraphNode& startNode = Candidate.Graph.GetNode(startLocation);
+	if (!startNode.NodeType->bIsTerminalNode)
 	{
-		if (startLocation->NodeType == NULL)
-		{
-			UE_LOG(LogMissionGen, Log, TEXT("Changing head node %s into %s."), *startLocation->NodeType->Description.ToString(), *head->NodeType->Description.ToString());
-		}
-		startLocation->NodeType = head->NodeType;
+		startNode.NodeType = grammar->GetOutputNode(head).NodeType;
 	}
 
-	if (graph->Num() == 2 && replaceLocation != NULL)
+	if (grammar->NumOutputNodes() == 2 && replaceLocation != FMissionGraph::NO_NODE)
 	{
-		if (replaceLocation->NodeType != NULL)
+		const FCompiledOutputNode& outputNode = grammar->GetOutputNode(1);
+		FMissionGraphNode& replaceNode = Candidate.Graph.GetNode(replaceLocation);
+		if (replaceNode.NodeType != NULL)
 		{
-			UE_LOG(LogMissionGen, Log, TEXT("Changing %s into %s."), *replaceLocation->NodeType->Description.ToString(), *graph->AllNodes[1]->NodeType->Description.ToString());
+			UE_LOG(LogMissionGen, Log, TEXT("Changing %s into %s."), *replaceNode.NodeType->Description.ToString(), *outputNode.NodeType->Description.ToString());
 		}
-		replaceLocation->NodeType = graph->AllNodes[1]->NodeType;
-		replaceLocation->bTightlyCoupledToParent = graph->AllNodes[1]->bTightlyCoupledToParent;
+		replaceNode.NodeType = outputNode.NodeType;
+		replaceNode.bTightlyCoupledToParent = outputNode.bTightlyCoupledToParent;
 	}
-	else if(graph->Num() > 2)
+	else if(grammar->NumOutputNodes() > 2)
 	{
-		if (replaceLocation != NULL)
+		if (replaceLocation != FMissionGraph::NO_NODE)
 		{
-			startLocation->BreakLinkWithNode(replaceLocation);
+			Candidate.Graph.BreakLinkWithNode(startLocation, replaceLocation);
 		}
 
-		toProcess.Add(head);
+		AddOutputNodes(Candidate, grammar, head, nodeMap, initialShape);
 
-		// Process the head and all its children
-		while (toProcess.Num() > 0)
+		if (replaceLocation != FMissionGraph::NO_NODE && nodeMap.Contains(2))
 		{
-			UDungeonMakerNode* node = toProcess[0];
-			toProcess.RemoveAt(0);
-
-			FNumberedGraphSymbol fromSymbol = node->ToGraphSymbol();
-			if (fromSymbol.Symbol == NULL)
+			if (nodeMap[2] != replaceLocation)
 			{
-				UE_LOG(LogMissionGen, Error, TEXT("Encounted a null symbol when replacing %s with %s."), *initialShape, *grammarChain);
-				continue;
+				Candidate.Graph.AddLinkToNode(nodeMap[2], replaceLocation, Candidate.Graph.GetNode(replaceLocation).bTightlyCoupledToParent);
 			}
-			checkf(nodeMap.Contains(fromSymbol.SymbolID), TEXT("Shape did not contain symbol ID %d! Did you remember to add it to the output grammar?"), fromSymbol.SymbolID);
+		}
+	}
 
-			// It is assumed that the from node is already in the map
-			// It is also assumed that the from node has already replaced its symbol
-			UDungeonMissionNode* fromNode = nodeMap[fromSymbol.SymbolID];
+#if !UE_BUILD_SHIPPING
+	UE_LOG(LogMissionGen, Log, TEXT("Dungeon after replacement:"));
+	UE_LOG(LogMissionGen, Log, TEXT("%s"), *Candidate.Graph.ToString(Candidate.HeadNode, 0));
+#endif
+}
 
-			TArray<UDungeonMakerNode*> children = node->ChildrenNodes;
-			UE_LOG(LogMissionGen, Verbose, TEXT("Processing %s, with %d children."), *fromNode->ToString(0, false), children.Num());
+void UDungeonMissionGenerator::ReplaceSubgraph(FMissionCandidate& Candidate, const FGraphOutput& GrammarReplaceResult) const
+{
+	const FCompiledMissionGrammar* grammar = GrammarReplaceResult.CompiledGrammar;
+	checkf(grammar != NULL, TEXT("Replacement for a subgraph didn't come from a compiled grammar!"));
+	const FMissionSubgraphPattern& pattern = grammar->GetInputPattern();
+	TArrayView<const int32> matchedNodes = Candidate.GetMatchedNodes(GrammarReplaceResult);
+	check(matchedNodes.Num() == pattern.Num());
+
+	// Number the nodes the way the input graph does
+	TMap<int32, int32> nodeMap;
+	FString initialShape;
+	for (int32 i = 0; i < matchedNodes.Num(); i++)
+	{
+		Candidate.Graph.GetNode(matchedNodes[i]).NodeID = pattern.GetNodeID(i);
+		nodeMap.Add(pattern.GetNodeID(i), matchedNodes[i]);
+		if (i > 0)
+		{
+			initialShape.Append(", ");
+		}
+		initialShape.Append(Candidate.Graph.GetSymbolDescription(matchedNodes[i]));
+	}
 
-			for (int i = 0; i < children.Num(); i++)
-			{
-				UDungeonMakerNode* child = children[i];
-				if (child->NodeType == NULL)
-				{
-					UE_LOG(LogMissionGen, Error, TEXT("%s had a null child symbol."), *fromSymbol.GetSymbolDescription());
-					continue;
-				}
+	if (!grammar->HasOutput())
+	{
+		UE_LOG(LogMissionGen, Error, TEXT("Replacement grammar was null! Nodes that were to be replaced: %s"), *initialShape);
+		return;
+	}
+	const FString& grammarChain = grammar->GetOutputDescription();
+	UE_LOG(LogMissionGen, Log, TEXT("Replacing %s with %s (Total Length: %d)."), *initialShape, *grammarChain, grammar->NumOutputNodes());
+
+	int32 head = grammar->FindOutputNode(1);
+	if (head == INDEX_NONE)
+	{
+		UE_LOG(LogMissionGen, Error, TEXT("No root symbol found when replacing %s with %s."), *initialShape, *grammarChain);
+		return;
+	}
+	if (grammar->GetOutputNode(head).NodeType == NULL)
+	{
+		UE_LOG(LogMissionGen, Error, TEXT("Encounted a null head symbol replacing %s with %s."), *initialShape, *grammarChain);
+		return;
+	}
+
+	// The output decides how the matched nodes are linked now; links to anything outside the match stay
+	for (int32 i = 0; i < matchedNodes.Num(); i++)
+	{
+		for (int32 child : pattern.GetChildren(i))
+		{
+			Candidate.Graph.BreakLinkWithNode(matchedNodes[i], matchedNodes[child]);
+		}
+	}
+
+	FMissionGraphNode& startNode = Candidate.Graph.GetNode(nodeMap[1]);
+	if (!startNode.NodeType->bIsTerminalNode)
+	{
+		startNode.NodeType = grammar->GetOutputNode(head).NodeType;
+	}
+	AddOutputNodes(Candidate, grammar, head, nodeMap, initialShape);
 
-				// Create nodes for all children of this node
-				UDungeonMissionNode* toNode;
-				FNumberedGraphSymbol childSymbol = child->ToGraphSymbol();
-				if (nodeMap.Contains(childSymbol.SymbolID))
-				{
-					toNode = nodeMap[childSymbol.SymbolID];
-				}
-				else
-				{
-					// Create a new node
-					toNode = NewObject<UDungeonMissionNode>();
-					UE_LOG(LogMissionGen, Log, TEXT("Adding node: %s"), *childSymbol.GetSymbolDescription());
-				}
-				// Change the symbol on the node
-				if (toNode->NodeType == NULL || !toNode->NodeType->bIsTerminalNode)
-				{
 #if !UE_BUILD_SHIPPING
-					if (toNode->NodeType != NULL)
-					{
-						UE_LOG(LogMissionGen, Log, TEXT("Converting %s (%d) into %s."), *toNode->NodeType->Description.ToString(), toNode->NodeID, *childSymbol.GetSymbolDescription());
-					}
+	UE_LOG(LogMissionGen, Log, TEXT("Dungeon after replacement:"));
+	UE_LOG(LogMissionGen, Log, TEXT("%s"), *Candidate.Graph.ToString(Candidate.HeadNode, 0));
 #endif
-					toNode->NodeType = childSymbol.Symbol;
-					toNode->NodeID = childSymbol.SymbolID;
-				}
+}
+
+void UDungeonMissionGenerator::AddOutputNodes(FMissionCandidate& Candidate, const FCompiledMissionGrammar* Grammar, int32 Head,
+	TMap<int32, int32>& NodeMap, const FString& InitialShape) const
+{
+	const FString& grammarChain = Grammar->GetOutputDescription();
+	TArray<int32> toProcess;
+	toProcess.Add(Head);
 
-				fromNode->AddLinkToNode(toNode, child->bTightlyCoupledToParent);
+	// Process the head and all its children
+	// Walk the array instead of popping off the front of it, so nothing gets shifted around
+	for (int32 processIndex = 0; processIndex < toProcess.Num(); processIndex++)
+	{
+		const FCompiledOutputNode& node = Grammar->GetOutputNode(toProcess[processIndex]);
 
-				// Update the node lookup
-				nodeMap.Add(child->NodeID, toNode);
-				// Add this child to our list of nodes to process for more children
-				toProcess.Add(child);
-			}
+		FNumberedGraphSymbol fromSymbol = node.ToGraphSymbol();
+		if (fromSymbol.Symbol == NULL)
+		{
+			UE_LOG(LogMissionGen, Error, TEXT("Encounted a null symbol when replacing %s with %s."), *InitialShape, *grammarChain);
+			continue;
 		}
+		checkf(NodeMap.Contains(fromSymbol.SymbolID), TEXT("Shape did not contain symbol ID %d! Did you remember to add it to the output grammar?"), fromSymbol.SymbolID);
+
+		// It is assumed that the from node is already in the map
+		// It is also assumed that the from node has already replaced its symbol
+		int32 fromNode = NodeMap[fromSymbol.SymbolID];
 
-		if (replaceLocation != NULL && nodeMap.Contains(2))
+		UE_LOG(LogMissionGen, Verbose, TEXT("Processing %s, with %d children."), *Candidate.Graph.ToString(fromNode, 0, false), node.Children.Num());
+
+		for (int32 childIndex : node.Children)
 		{
-			if (nodeMap[2] != replaceLocation)
+			const FCompiledOutputNode& child = Grammar->GetOutputNode(childIndex);
+			if (child.NodeType == NULL)
 			{
-				nodeMap[2]->AddLinkToNode(replaceLocation, replaceLocation->bTightlyCoupledToParent);
+				UE_LOG(LogMissionGen, Error, TEXT("%s had a null child symbol."), *fromSymbol.GetSymbolDescription());
+				continue;
 			}
-		}
-	}
 
+			// Create nodes for all children of this node
+			int32 toNode;
+			FNumberedGraphSymbol childSymbol = child.ToGraphSymbol();
+			if (NodeMap.Contains(childSymbol.SymbolID))
+			{
+				toNode = NodeMap[childSymbol.SymbolID];
+			}
+			else
+			{
+				// Create a new node
+				toNode = Candidate.Graph.AddNode(NULL, 0);
+				UE_LOG(LogMissionGen, Log, TEXT("Adding node: %s"), *childSymbol.GetSymbolDescription());
+			}
+			// Change the symbol on the node
+			FMissionGraphNode& newNode = Candidate.Graph.GetNode(toNode);
+			if (newNode.NodeType == NULL || !newNode.NodeType->bIsTerminalNode)
+			{
 #if !UE_BUILD_SHIPPING
-	UE_LOG(LogMissionGen, Log, TEXT("Dungeon after replacement:"));
-	PrintDebugDungeon();
+				if (newNode.NodeType != NULL)
+				{
+					UE_LOG(LogMissionGen, Log, TEXT("Converting %s (%d) into %s."), *newNode.NodeType->Description.ToString(), newNode.NodeID, *childSymbol.GetSymbolDescription());
+				}
 #endif
+				newNode.NodeType = childSymbol.Symbol;
+				newNode.NodeID = childSymbol.SymbolID;
+			}
+
+			Candidate.Graph.AddLinkToNode(fromNode, toNode, child.bTightlyCoupledToParent);
+
+			// Update the node lookup
+			NodeMap.Add(child.NodeID, toNode);
+			// Add this child to our list of nodes to process for more children
+			toProcess.Add(childIndex);
+		}
+	}
 }
@@ -1 +1,29 @@
-#include "DungeonMissionGrammar.h"
\ No newline at end of file
+#include "DungeonMissionGrammar.h"
+
+FCompiledMissionGrammarPtr UDungeonMissionGrammar::GetCompiledGrammar() const
+{
+	if (!CompiledGrammar.IsValid())
+	{
+		CompileMissionGrammar();
+	}
+	return CompiledGrammar;
+}
+
+void UDungeonMissionGrammar::CompileMissionGrammar() const
+{
+	CompiledGrammar = MakeShareable(new FCompiledMissionGrammar(this));
+}
+
+void UDungeonMissionGrammar::PostLoad()
+{
+	Super::PostLoad();
+	CompileMissionGrammar();
+}
+
+#if WITH_EDITOR
+void UDungeonMissionGrammar::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	CompileMissionGrammar();
+}
+#endif
@@ -0,0 +1,121 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonMissionGrammarIndex.h"
+#include "DungeonMaker.h"
+
+void FDungeonMissionGrammarIndex::Build(const TArray<const UDungeonMissionGrammar*>& Grammars)
+{
+	GrammarCount = Grammars.Num();
+	OutputGraphCount = 0;
+	SymbolCandidates.Empty();
+	UnknownSymbolCandidates = FCandidateGrammars();
+	PatternCandidates.Empty();
+	CompiledGrammars.Reset();
+
+	// Everything after this only looks at the compiled grammars
+	TArray<const FCompiledMissionGrammar*> grammars;
+	for (const UDungeonMissionGrammar* grammar : Grammars)
+	{
+		if (grammar == NULL)
+		{
+			continue;
+		}
+		FCompiledMissionGrammarPtr compiled = grammar->GetCompiledGrammar();
+		CompiledGrammars.Add(compiled);
+		grammars.Add(compiled.Get());
+	}
+
+	// Graphs are told apart by their shape
+	TMap<FString, int32> graphShapeIDs;
+	TMap<const FCompiledMissionGrammar*, int32> outputGraphIDs;
+	for (const FCompiledMissionGrammar* grammar : grammars)
+	{
+		if (outputGraphIDs.Contains(grammar))
+		{
+			continue;
+		}
+		int32 graphID = INDEX_NONE;
+		if (grammar->HasOutput())
+		{
+			const FString& graphShape = grammar->GetOutputDescription();
+			if (graphShapeIDs.Contains(graphShape))
+			{
+				graphID = graphShapeIDs[graphShape];
+			}
+			else
+			{
+				graphID = OutputGraphCount;
+				graphShapeIDs.Add(graphShape, OutputGraphCount);
+				OutputGraphCount++;
+			}
+		}
+		outputGraphIDs.Add(grammar, graphID);
+	}
+
+	for (const FCompiledMissionGrammar* grammar : grammars)
+	{
+		if (grammar->HasInputGraph() || !grammar->GetRuleInput().IsCompiled())
+		{
+			continue;
+		}
+		TArray<const UStateMachineSymbol*> symbols;
+		grammar->GetRuleInput().GetKnownSymbols(symbols);
+		for (const UStateMachineSymbol* symbol : symbols)
+		{
+			if (!SymbolCandidates.Contains(symbol))
+			{
+				SymbolCandidates.Add(symbol, FCandidateGrammars());
+			}
+		}
+	}
+
+	for (const FCompiledMissionGrammar* grammar : grammars)
+	{
+		FIndexedMissionGrammar indexedGrammar;
+		indexedGrammar.Grammar = grammar;
+		indexedGrammar.OutputGraphID = outputGraphIDs[grammar];
+
+		if (grammar->HasInputGraph())
+		{
+			// Input graphs can only match nodes with the same symbol as their root
+			const FMissionSubgraphPattern& pattern = grammar->GetInputPattern();
+			if (pattern.IsValid())
+			{
+				PatternCandidates.FindOrAdd(pattern.GetRootSymbol()).Add(indexedGrammar);
+			}
+			continue;
+		}
+
+		const FCompiledGraphInputGrammar& compiled = grammar->GetRuleInput();
+		bool bCanMatchAnything = !compiled.IsCompiled();
+		for (int32 i = 0; i < FCompiledGraphInputGrammar::CouplingCount; i++)
+		{
+			FCompiledGraphInputGrammar::ENextLinkCoupling coupling = (FCompiledGraphInputGrammar::ENextLinkCoupling)i;
+			if (bCanMatchAnything || compiled.MightAcceptUnknownSymbol(coupling))
+			{
+				UnknownSymbolCandidates.Grammars[i].Add(indexedGrammar);
+			}
+			for (TPair<const UStateMachineSymbol*, FCandidateGrammars>& candidates : SymbolCandidates)
+			{
+				if (bCanMatchAnything || compiled.MightAccept(candidates.Key, coupling))
+				{
+					candidates.Value.Grammars[i].Add(indexedGrammar);
+				}
+			}
+		}
+	}
+
+	UE_LOG(LogMissionGen, Verbose, TEXT("Indexed %d grammars across %d leading symbols, %d input graph roots and %d output graphs."), GrammarCount, SymbolCandidates.Num(), PatternCandidates.Num(), OutputGraphCount);
+}
+
+const TArray<FIndexedMissionGrammar>& FDungeonMissionGrammarIndex::GetCandidates(const TArray<FGraphLink>& Links) const
+{
+	check(Links.Num() > 0);
+	FCompiledGraphInputGrammar::ENextLinkCoupling coupling = FCompiledGraphInputGrammar::GetNextLinkCoupling(Links, 0);
+	const FCandidateGrammars* candidates = SymbolCandidates.Find(Links[0].Symbol.Symbol);
+	if (candidates == NULL)
+	{
+		candidates = &UnknownSymbolCandidates;
+	}
+	return candidates->Grammars[coupling];
+}
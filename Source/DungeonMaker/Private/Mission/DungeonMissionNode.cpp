@@ -29,6 +29,8 @@ void UDungeonMissionNode::BreakLinkWithNode(const UDungeonMissionNode* Child)
 	{
 		if (node == Child)
 		{
+			InvalidateGraphAnalysis();
+			node->InvalidateGraphAnalysis();
 			ChildrenNodes.Remove(node);
 			node->ParentNodes.Remove(this);
 			FString ourName = ToString(0);
@@ -45,6 +47,8 @@ void UDungeonMissionNode::AddLinkToNode(UDungeonMissionNode* NewChild, bool bTig
 	{
 		return;
 	}
+	InvalidateGraphAnalysis();
+	NewChild->InvalidateGraphAnalysis();
 
 	bool bAlreadyHasChild = false;
 	for (int i = 0; i < ChildrenNodes.Num(); i++)
@@ -93,16 +97,7 @@ void UDungeonMissionNode::AddLinkToNode(UDungeonMissionNode* NewChild, bool bTig
 
 int32 UDungeonMissionNode::GetLevelCount()
 {
-	int32 biggest = 0;
-	for (UDungeonMakerNode* node : ChildrenNodes)
-	{
-		int32 nextNodeLevelCount = ((UDungeonMissionNode*)node)->GetLevelCount();
-		if (nextNodeLevelCount > biggest)
-		{
-			biggest = nextNodeLevelCount;
-		}
-	}
-	return biggest + 1;
+	return GetGraphAnalysis().GetLevelCount(this);
 }
 
 FString UDungeonMissionNode::GetSymbolDescription()
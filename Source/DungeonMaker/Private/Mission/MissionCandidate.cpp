@@ -0,0 +1,73 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MissionCandidate.h"
+
+UMissionCandidateMetric::UMissionCandidateMetric()
+{
+	Weight = 1.0f;
+}
+
+float UMissionCandidateMetric::ScoreCandidate(const FMissionCandidate& Candidate) const
+{
+	return 0.0f;
+}
+
+UMissionSizeMetric::UMissionSizeMetric()
+{
+	TargetNodeCount = 20;
+	OverTargetPenalty = 2.0f;
+}
+
+float UMissionSizeMetric::ScoreCandidate(const FMissionCandidate& Candidate) const
+{
+	int32 target = FMath::Max(TargetNodeCount, 1);
+	float difference = (float)(Candidate.NodeCount - target) / target;
+	if (difference > 0.0f)
+	{
+		return -difference * OverTargetPenalty;
+	}
+	return difference;
+}
+
+UMissionBranchingMetric::UMissionBranchingMetric()
+{
+	MaxChildren = 4;
+}
+
+float UMissionBranchingMetric::ScoreCandidate(const FMissionCandidate& Candidate) const
+{
+	if (!Candidate.Graph.IsValidNode(Candidate.HeadNode))
+	{
+		return 0.0f;
+	}
+
+	// Only count nodes which are actually part of the mission
+	float score = 0.0f;
+	TArray<int32> nodes;
+	nodes.Add(Candidate.HeadNode);
+	TArray<bool> visited;
+	visited.Init(false, Candidate.Graph.Num());
+	for (int32 i = 0; i < nodes.Num(); i++)
+	{
+		int32 current = nodes[i];
+		if (visited[current])
+		{
+			continue;
+		}
+		visited[current] = true;
+
+		int32 childCount = nodes.Num();
+		Candidate.Graph.GetChildren(current, nodes);
+		childCount = nodes.Num() - childCount;
+		if (childCount > MaxChildren)
+		{
+			score -= childCount - MaxChildren;
+		}
+	}
+	return score;
+}
+
+float UMissionUnresolvedHookMetric::ScoreCandidate(const FMissionCandidate& Candidate) const
+{
+	return -Candidate.UnresolvedHookNodes.Num();
+}
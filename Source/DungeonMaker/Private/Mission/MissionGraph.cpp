@@ -0,0 +1,238 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MissionGraph.h"
+#include "DungeonMaker.h"
+#include "DungeonMissionNode.h"
+
+int32 FMissionGraph::AddNode(UGraphNode* NodeType, int32 NodeID)
+{
+	FMissionGraphNode node;
+	node.NodeType = NodeType;
+	node.NodeID = NodeID;
+	node.bTightlyCoupledToParent = false;
+	node.FirstChild = NO_NODE;
+	node.LastChild = NO_NODE;
+	node.FirstParent = NO_NODE;
+	node.LastParent = NO_NODE;
+	return Nodes.Add(node);
+}
+
+int32 FMissionGraph::AllocateLink(int32 Node)
+{
+	int32 link = FirstFreeLink;
+	if (link != NO_NODE)
+	{
+		FirstFreeLink = Links[link].Next;
+	}
+	else
+	{
+		link = Links.AddUninitialized();
+	}
+	Links[link].Node = Node;
+	Links[link].Next = NO_NODE;
+	return link;
+}
+
+void FMissionGraph::AppendLink(int32& First, int32& Last, int32 Node)
+{
+	int32 link = AllocateLink(Node);
+	if (Last == NO_NODE)
+	{
+		First = link;
+	}
+	else
+	{
+		Links[Last].Next = link;
+	}
+	Last = link;
+}
+
+bool FMissionGraph::RemoveLink(int32& First, int32& Last, int32 Node)
+{
+	int32 previous = NO_NODE;
+	for (int32 link = First; link != NO_NODE; link = Links[link].Next)
+	{
+		if (Links[link].Node != Node)
+		{
+			previous = link;
+			continue;
+		}
+
+		int32 next = Links[link].Next;
+		if (previous == NO_NODE)
+		{
+			First = next;
+		}
+		else
+		{
+			Links[previous].Next = next;
+		}
+		if (Last == link)
+		{
+			Last = previous;
+		}
+
+		Links[link].Next = FirstFreeLink;
+		FirstFreeLink = link;
+		return true;
+	}
+	return false;
+}
+
+int32 FMissionGraph::FindChildNodeFromSymbol(int32 Parent, const FNumberedGraphSymbol& ChildSymbol) const
+{
+	for (int32 link = Nodes[Parent].FirstChild; link != NO_NODE; link = Links[link].Next)
+	{
+		const FMissionGraphNode& child = Nodes[Links[link].Node];
+		if (child.NodeType == ChildSymbol.Symbol && child.NodeID == ChildSymbol.SymbolID)
+		{
+			return Links[link].Node;
+		}
+	}
+	return NO_NODE;
+}
+
+void FMissionGraph::AddLinkToNode(int32 Parent, int32 NewChild, bool bTightlyCoupled)
+{
+	if (NewChild == NO_NODE)
+	{
+		return;
+	}
+
+	bool bAlreadyHasChild = false;
+	ForEachChild(Parent, [this, NewChild, &bAlreadyHasChild](int32 Child)
+	{
+		bAlreadyHasChild |= Nodes[Child].NodeID == Nodes[NewChild].NodeID && Nodes[Child].NodeType == Nodes[NewChild].NodeType;
+	});
+	if (!bAlreadyHasChild)
+	{
+		AppendLink(Nodes[Parent].FirstChild, Nodes[Parent].LastChild, NewChild);
+	}
+
+	bool bAlreadyHasParent = false;
+	ForEachParent(NewChild, [this, Parent, &bAlreadyHasParent](int32 OtherParent)
+	{
+		bAlreadyHasParent |= Nodes[OtherParent].NodeID == Nodes[Parent].NodeID && Nodes[OtherParent].NodeType == Nodes[Parent].NodeType;
+	});
+	if (!bAlreadyHasParent)
+	{
+		Nodes[NewChild].bTightlyCoupledToParent = bTightlyCoupled;
+		AppendLink(Nodes[NewChild].FirstParent, Nodes[NewChild].LastParent, Parent);
+	}
+
+#if !UE_BUILD_SHIPPING
+	if (Nodes[NewChild].bTightlyCoupledToParent)
+	{
+		UE_LOG(LogMissionGen, Verbose, TEXT("Parenting %s => %s"), *ToString(Parent, 0), *ToString(NewChild, 0));
+	}
+	else
+	{
+		UE_LOG(LogMissionGen, Verbose, TEXT("Parenting %s -> %s"), *ToString(Parent, 0), *ToString(NewChild, 0));
+	}
+#endif
+}
+
+void FMissionGraph::BreakLinkWithNode(int32 Parent, int32 Child)
+{
+	if (Child == NO_NODE)
+	{
+		return;
+	}
+	FMissionGraphNode& parentNode = Nodes[Parent];
+	if (RemoveLink(parentNode.FirstChild, parentNode.LastChild, Child))
+	{
+		FMissionGraphNode& childNode = Nodes[Child];
+		RemoveLink(childNode.FirstParent, childNode.LastParent, Parent);
+		UE_LOG(LogMissionGen, Verbose, TEXT("Breaking link between %s and %s."), *ToString(Parent, 0), *ToString(Child, 0));
+	}
+}
+
+FString FMissionGraph::GetSymbolDescription(int32 Node) const
+{
+	if (Nodes[Node].NodeType == NULL)
+	{
+		return "";
+	}
+	return Nodes[Node].NodeType->Description.ToString();
+}
+
+FString FMissionGraph::ToString(int32 Node, int32 IndentLevel, bool bPrintChildren) const
+{
+	FString output;
+#if !UE_BUILD_SHIPPING
+	const FMissionGraphNode& node = Nodes[Node];
+	for (int i = 0; i < IndentLevel; i++)
+	{
+		output.AppendChar(' ');
+	}
+	if (node.bTightlyCoupledToParent)
+	{
+		output.Append("=>");
+	}
+	else
+	{
+		output.Append("->");
+	}
+	output.Append(node.NodeType->Description.ToString());
+	output.Append(" (");
+	output.AppendInt(node.NodeID);
+	output.AppendChar(')');
+
+	if (bPrintChildren)
+	{
+		ForEachChild(Node, [this, &output, IndentLevel](int32 Child)
+		{
+			output.Append("\n");
+			output.Append(ToString(Child, IndentLevel + 4));
+		});
+	}
+#endif
+	return output;
+}
+
+UDungeonMissionNode* FMissionGraph::CreateMissionNodes(int32 Head, TArray<UDungeonMissionNode*>& OutNodes) const
+{
+	check(IsValidNode(Head));
+	OutNodes.Init(NULL, Nodes.Num());
+
+	// Create an object for everything reachable
+	TArray<int32> toCreate;
+	toCreate.Add(Head);
+	while (toCreate.Num() > 0)
+	{
+		int32 next = toCreate.Pop(false);
+		if (OutNodes[next] != NULL)
+		{
+			continue;
+		}
+
+		UDungeonMissionNode* missionNode = NewObject<UDungeonMissionNode>();
+		missionNode->NodeType = Nodes[next].NodeType;
+		missionNode->NodeID = Nodes[next].NodeID;
+		missionNode->bTightlyCoupledToParent = Nodes[next].bTightlyCoupledToParent;
+		OutNodes[next] = missionNode;
+		GetChildren(next, toCreate);
+	}
+
+	// Link them together, keeping the order of every child and parent list
+	for (int32 i = 0; i < Nodes.Num(); i++)
+	{
+		UDungeonMissionNode* missionNode = OutNodes[i];
+		if (missionNode == NULL)
+		{
+			continue;
+		}
+		ForEachChild(i, [&OutNodes, missionNode](int32 Child)
+		{
+			missionNode->ChildrenNodes.Add(OutNodes[Child]);
+		});
+		ForEachParent(i, [&OutNodes, missionNode](int32 Parent)
+		{
+			if (OutNodes[Parent] != NULL)
+			{
+				missionNode->ParentNodes.Add(OutNodes[Parent]);
+			}
+		});
+	}
+	return OutNodes[Head];
+}
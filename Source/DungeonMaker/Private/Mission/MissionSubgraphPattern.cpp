@@ -0,0 +1,143 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "MissionSubgraphPattern.h"
+#include "CompiledMissionGrammar.h"
+
+bool FMissionSubgraphPattern::Compile(const TArray<FCompiledOutputNode>& GraphNodes)
+{
+	Reset();
+	int32 root = INDEX_NONE;
+	for (int32 i = 0; i < GraphNodes.Num(); i++)
+	{
+		FPatternNode& node = Nodes[Nodes.AddDefaulted()];
+		node.NodeType = GraphNodes[i].NodeType;
+		node.NodeID = GraphNodes[i].NodeID;
+		node.bTightlyCoupledToParent = GraphNodes[i].bTightlyCoupledToParent;
+		node.Children = GraphNodes[i].Children;
+		if (node.NodeID == 1)
+		{
+			root = i;
+		}
+	}
+	for (int32 i = 0; i < Nodes.Num(); i++)
+	{
+		for (int32 child : Nodes[i].Children)
+		{
+			Nodes[child].Parents.AddUnique(i);
+		}
+	}
+	if (root == INDEX_NONE)
+	{
+		Reset();
+		return false;
+	}
+
+	// Match closest nodes first, so every node's parent is matched before it
+	TArray<bool> visited;
+	visited.Init(false, Nodes.Num());
+	visited[root] = true;
+	MatchOrder.Add(root);
+	MatchParents.Add(INDEX_NONE);
+	for (int32 i = 0; i < MatchOrder.Num(); i++)
+	{
+		for (int32 child : Nodes[MatchOrder[i]].Children)
+		{
+			if (!visited[child])
+			{
+				visited[child] = true;
+				MatchOrder.Add(child);
+				MatchParents.Add(MatchOrder[i]);
+			}
+		}
+	}
+	if (MatchOrder.Num() < Nodes.Num())
+	{
+		Reset();
+		return false;
+	}
+	return true;
+}
+
+bool FMissionSubgraphPattern::CanMatch(const FMissionGraph& Graph, int32 PatternNode, int32 Node, const TArray<int32>& MatchedNodes) const
+{
+	const FPatternNode& patternNode = Nodes[PatternNode];
+	const FMissionGraphNode& node = Graph.GetNode(Node);
+	if (node.NodeType != patternNode.NodeType)
+	{
+		return false;
+	}
+	// The root's coupling is to a parent outside the pattern, so only check nodes with parents inside it
+	if (patternNode.Parents.Num() > 0 && node.bTightlyCoupledToParent != patternNode.bTightlyCoupledToParent)
+	{
+		return false;
+	}
+	if (Graph.NumChildren(Node) < patternNode.Children.Num() || Graph.NumParents(Node) < patternNode.Parents.Num())
+	{
+		return false;
+	}
+	if (MatchedNodes.Contains(Node))
+	{
+		return false;
+	}
+
+	for (int32 child : patternNode.Children)
+	{
+		if (MatchedNodes[child] != FMissionGraph::NO_NODE && !Graph.HasChild(Node, MatchedNodes[child]))
+		{
+			return false;
+		}
+	}
+	for (int32 parent : patternNode.Parents)
+	{
+		if (MatchedNodes[parent] != FMissionGraph::NO_NODE && !Graph.HasChild(MatchedNodes[parent], Node))
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool FMissionSubgraphPattern::MatchFrom(const FMissionGraph& Graph, int32 Step, TArray<int32>& MatchedNodes) const
+{
+	if (Step == MatchOrder.Num())
+	{
+		return true;
+	}
+
+	int32 patternNode = MatchOrder[Step];
+	bool bMatched = false;
+	Graph.ForEachChild(MatchedNodes[MatchParents[Step]], [&](int32 Child)
+	{
+		if (bMatched || !CanMatch(Graph, patternNode, Child, MatchedNodes))
+		{
+			return;
+		}
+		MatchedNodes[patternNode] = Child;
+		bMatched = MatchFrom(Graph, Step + 1, MatchedNodes);
+		if (!bMatched)
+		{
+			MatchedNodes[patternNode] = FMissionGraph::NO_NODE;
+		}
+	});
+	return bMatched;
+}
+
+bool FMissionSubgraphPattern::Match(const FMissionGraph& Graph, int32 Root, TArray<int32>& OutMatchedNodes) const
+{
+	if (!IsValid())
+	{
+		return false;
+	}
+	// Not Init, which would give up the memory if the last pattern was a different size
+	OutMatchedNodes.SetNumUninitialized(Nodes.Num(), false);
+	for (int32& matchedNode : OutMatchedNodes)
+	{
+		matchedNode = FMissionGraph::NO_NODE;
+	}
+	if (!CanMatch(Graph, MatchOrder[0], Root, OutMatchedNodes))
+	{
+		return false;
+	}
+	OutMatchedNodes[MatchOrder[0]] = Root;
+	return MatchFrom(Graph, 1, OutMatchedNodes);
+}
@@ -10,82 +10,73 @@ void UDungeonMissionSpaceHandler::InitializeDungeonFloor(UDungeonSpaceGenerator*
 {
 	DungeonSpaceGenerator = SpaceGenerator;
 
-	DungeonSpaceGenerator->DungeonSpace = FDungeonSpace(LevelSizes, RoomSize);
+	FDungeonSpace& dungeonSpace = DungeonSpaceGenerator->DungeonSpace;
+	if (dungeonSpace.HasLayout(LevelSizes, RoomSize) && !dungeonSpace.HasAnyRooms())
+	{
+		// Failed attempts roll themselves back, so we can reuse the space we already have
+		UE_LOG(LogSpaceGen, Verbose, TEXT("Reusing existing dungeon space instead of reallocating it."));
+		return;
+	}
+	dungeonSpace = FDungeonSpace(LevelSizes, RoomSize);
 }
 
 bool UDungeonMissionSpaceHandler::CreateDungeonSpace(UDungeonMissionNode* Head, FIntVector StartLocation,
 	int32 SymbolCount, FRandomStream& Rng)
 {
 	bool bMadeDungeonSuccessfully = false;
+	FDungeonSpace& dungeonSpace = DungeonSpaceGenerator->DungeonSpace;
+	// Journal everything we place, so a failed attempt can be undone in place
+	int32 savepoint = dungeonSpace.CreateSavepoint();
+
 	// Create space for each room on the DungeonFloor
 	RoomCount = 0;
 	GenerateDungeonRooms(Head, StartLocation, Rng, SymbolCount);
 	bMadeDungeonSuccessfully = RoomCount == SymbolCount;
 	if (bMadeDungeonSuccessfully)
 	{
+		dungeonSpace.CommitJournal();
 		ProcessRoomNeighbors();
 	}
 	else
 	{
-		TArray<int32> levelSizes;
-		for (int i = 0; i < DungeonSpaceGenerator->DungeonSpace.Num(); i++)
-		{
-			levelSizes.Add(DungeonSpaceGenerator->DungeonSpace.GetLowRes(i).XSize());
-		}
-		InitializeDungeonFloor(DungeonSpaceGenerator, levelSizes);
+		UE_LOG(LogSpaceGen, Log, TEXT("Only placed %d of %d rooms; rolling back."), RoomCount, SymbolCount);
+		dungeonSpace.RollbackToSavepoint(savepoint);
+		dungeonSpace.CommitJournal();
 	}
 	
 	return bMadeDungeonSuccessfully;
 }
 
-bool UDungeonMissionSpaceHandler::CheckInputIsValid(TMap<FIntVector, FIntVector> &AvailableRooms, bool bIsTightCoupling, UDungeonMissionNode* Node, FMissionSpaceHelper &SpaceHelper)
+EMissionSpaceFeasibility UDungeonMissionSpaceHandler::CheckMissionFeasibility(UDungeonMissionNode* Head, int32 SymbolCount) const
 {
-	if (AvailableRooms.Num() == 0 && bIsTightCoupling)
+	// Floors are added until every symbol fits, so the only real limit is the room cap
+	int32 maxRooms = DungeonSpaceGenerator->MaxGeneratedRooms;
+	if (maxRooms >= 0 && SymbolCount > maxRooms)
 	{
-		// Out of leaves to process
-		UE_LOG(LogSpaceGen, Warning, TEXT("%s is tightly coupled to its parent, but ran out of leaves to process."), *Node->GetSymbolDescription());
-		return false;
+		UE_LOG(LogSpaceGen, Log, TEXT("Mission has %d nodes, but only %d rooms can be generated."), SymbolCount, maxRooms);
+		return EMissionSpaceFeasibility::NotEnoughRooms;
 	}
-	if (!SpaceHelper.HasOpenRooms() && !bIsTightCoupling)
-	{
-		UE_LOG(LogSpaceGen, Warning, TEXT("%s is loosely coupled to its parent, but ran out of leaves to process."), *Node->GetSymbolDescription());
-		return false;
-	}
-	return true;
-}
 
-bool UDungeonMissionSpaceHandler::CheckCanSkipProcessing(UDungeonMissionNode* Node, FMissionSpaceHelper &SpaceHelper)
-{
-	if (Node == NULL)
+	if (Head == NULL)
 	{
-		// No rooms to pair
-		UE_LOG(LogSpaceGen, Error, TEXT("Null node was provided to the Mission Space Handler!"));
-		return true;
+		return EMissionSpaceFeasibility::Feasible;
 	}
-	if (SpaceHelper.HasProcessed(Node))
+	for (const UDungeonMakerNode* node : Head->GetGraphAnalysis().GetTopologicalOrder())
 	{
-		// Already processed this node
-		return true;
-	}
-
-	if (((UDungeonMissionSymbol*)Node->NodeType)->RoomTypes.Num() == 0)
-	{
-		UE_LOG(LogSpaceGen, Error, TEXT("Mission Space Handler tried handling %s, which had no room types defined!"), *Node->GetNodeTitle());
-		return true;
-	}
-
-	for (int i = 0; i < Node->ParentNodes.Num(); i++)
-	{
-		if (!SpaceHelper.HasProcessed((UDungeonMissionNode*)Node->ParentNodes[i]))
+		// Nodes without room types get skipped, so we'd always come up short
+		const UDungeonMissionSymbol* symbol = Cast<UDungeonMissionSymbol>(node->NodeType);
+		if (symbol == NULL)
+		{
+			UE_LOG(LogSpaceGen, Log, TEXT("Mission node %d has no mission symbol."), node->NodeID);
+			return EMissionSpaceFeasibility::MissingRoomType;
+		}
+		if (symbol->RoomTypes.Num() == 0)
 		{
-			// We haven't processed all our parent nodes yet!
-			// We should be processed further on down the line, once our next parent node
-			// finishes being processed.
-			UE_LOG(LogSpaceGen, Log, TEXT("Deferring processing of %s because not all its parents have been processed yet."), *Node->GetSymbolDescription());
-			return true;
+			UE_LOG(LogSpaceGen, Log, TEXT("Mission node %s has no room types."), *symbol->Description.ToString());
+			return EMissionSpaceFeasibility::MissingRoomType;
 		}
 	}
-	return false;
+	return EMissionSpaceFeasibility::Feasible;
 }
 
 void UDungeonMissionSpaceHandler::DrawDebugSpace()
@@ -97,7 +88,7 @@ void UDungeonMissionSpaceHandler::DrawDebugSpace()
 }
 
 TSet<FIntVector> UDungeonMissionSpaceHandler::GetAvailableLocations(FIntVector Location, 
-	TSet<FIntVector> IgnoredLocations /*= TSet<FIntVector>()*/)
+	const TSet<FIntVector>& IgnoredLocations /*= TSet<FIntVector>()*/)
 {
 	TSet<FIntVector> availableLocations;
 
@@ -187,6 +178,21 @@ void UDungeonMissionSpaceHandler::SetRoom(FFloorRoom Room, bool bShouldIncrement
 	}
 }
 
+FMissionSpaceRoomSavepoint UDungeonMissionSpaceHandler::CreateRoomSavepoint()
+{
+	checkf(DungeonSpaceGenerator->DungeonSpace.IsJournaling(), TEXT("Room savepoints can only be made while the dungeon space is journaling!"));
+	FMissionSpaceRoomSavepoint savepoint;
+	savepoint.SpaceSavepoint = DungeonSpaceGenerator->DungeonSpace.CreateSavepoint();
+	savepoint.RoomCount = RoomCount;
+	return savepoint;
+}
+
+void UDungeonMissionSpaceHandler::RollbackRooms(const FMissionSpaceRoomSavepoint& Savepoint)
+{
+	DungeonSpaceGenerator->DungeonSpace.RollbackToSavepoint(Savepoint.SpaceSavepoint);
+	RoomCount = Savepoint.RoomCount;
+}
+
 void UDungeonMissionSpaceHandler::GenerateDungeonRooms(UDungeonMissionNode* Head, FIntVector StartLocation, FRandomStream &Rng, int32 SymbolCount)
 {
 	// Empty
@@ -200,21 +206,24 @@ void UDungeonMissionSpaceHandler::ProcessRoomNeighbors()
 		{
 			for (int x = 0; x < DungeonSpaceGenerator->DungeonSpace.GetLowRes(z).XSize(); x++)
 			{
-				for (FIntVector neighbor : DungeonSpaceGenerator->DungeonSpace.GetLowRes(z)[y][x].NeighboringRooms)
+				FDungeonSpace& dungeonSpace = DungeonSpaceGenerator->DungeonSpace;
+				FIntVector location = FIntVector(x, y, z);
+				const FFloorRoom& room = dungeonSpace.GetLowRes(location);
+				room.ForEachNeighbor(false, [&dungeonSpace, &location](const FIntVector& Neighbor)
 				{
-					DungeonSpaceGenerator->DungeonSpace.GetLowRes(neighbor.Z)[neighbor.Y][neighbor.X].NeighboringRooms.Add(FIntVector(x, y, z));
-				}
-				for (FIntVector neighbor : DungeonSpaceGenerator->DungeonSpace.GetLowRes(z)[y][x].NeighboringTightlyCoupledRooms)
+					dungeonSpace.AddNeighbor(Neighbor, location, false);
+				});
+				room.ForEachNeighbor(true, [&dungeonSpace, &location](const FIntVector& Neighbor)
 				{
-					DungeonSpaceGenerator->DungeonSpace.GetLowRes(neighbor.Z)[neighbor.Y][neighbor.X].NeighboringTightlyCoupledRooms.Add(FIntVector(x, y, z));
-				}
+					dungeonSpace.AddNeighbor(Neighbor, location, true);
+				});
 			}
 		}
 	}
 }
 
 FRoomPairing UDungeonMissionSpaceHandler::GetOpenRoom(UDungeonMissionNode* Node,
-	TMap<FIntVector, FIntVector>& AvailableRooms, FMissionSpaceHelper& SpaceHelper)
+	const TMap<FIntVector, FIntVector>& AvailableRooms, TSet<FIntVector>& TriedRooms, FMissionSpaceHelper& SpaceHelper)
 {
 	TSet<UDungeonMissionNode*> nodesToCheck;
 	// If this node has a tightly-coupled child, ensure that there's room to place the child as well
@@ -226,23 +235,33 @@ FRoomPairing UDungeonMissionSpaceHandler::GetOpenRoom(UDungeonMissionNode* Node,
 		}
 	}
 
+	TArray<FIntVector> untriedRooms;
+	untriedRooms.Reserve(AvailableRooms.Num());
+	for (const TPair<FIntVector, FIntVector>& kvp : AvailableRooms)
+	{
+		if (!TriedRooms.Contains(kvp.Key))
+		{
+			untriedRooms.Add(kvp.Key);
+		}
+	}
+
 	// Initialize our starting location to an invalid location
 	FIntVector roomLocation = INVALID_LOCATION;
 	FIntVector parentLocation = INVALID_LOCATION;
 	do
 	{
-		if (AvailableRooms.Num() == 0)
+		if (untriedRooms.Num() == 0)
 		{
 			// Out of rooms; return an invalid input
-			UE_LOG(LogSpaceGen, Warning, TEXT("Ran out of rooms when trying to place %s"), *Node->ToString(0, false));
+			// This is expected while backtracking, so it's not worth a warning
+			UE_LOG(LogSpaceGen, Verbose, TEXT("Ran out of rooms when trying to place %s"), *Node->ToString(0, false));
 			return FRoomPairing();
 		}
-		int32 leafIndex = SpaceHelper.Rng.RandRange(0, AvailableRooms.Num() - 1);
-		TArray<FIntVector> allAvailableRooms;
-		AvailableRooms.GetKeys(allAvailableRooms);
-		roomLocation = allAvailableRooms[leafIndex];
+		int32 leafIndex = SpaceHelper.Rng.RandRange(0, untriedRooms.Num() - 1);
+		roomLocation = untriedRooms[leafIndex];
 		parentLocation = AvailableRooms[roomLocation];
-		AvailableRooms.Remove(roomLocation);
+		untriedRooms.RemoveAtSwap(leafIndex, 1, false);
+		TriedRooms.Add(roomLocation);
 
 		if (SpaceHelper.HasProcessed(roomLocation))
 		{
@@ -276,8 +295,9 @@ FRoomPairing UDungeonMissionSpaceHandler::GetOpenRoom(UDungeonMissionNode* Node,
 						if (SpaceHelper.Rng.GetFraction() <= skipChance)
 						{
 							// Skip
-							// This room is technically still valid, so we re-insert it into the map
-							AvailableRooms.Add(roomLocation, parentLocation);
+							// This room is technically still valid, so we put it back
+							untriedRooms.Add(roomLocation);
+							TriedRooms.Remove(roomLocation);
 							roomLocation = INVALID_LOCATION;
 							parentLocation = INVALID_LOCATION;
 							UE_LOG(LogSpaceGen, Log, TEXT("Skipping room as it has the same symbol as our parent."));
@@ -301,15 +321,7 @@ void UDungeonMissionSpaceHandler::UpdateNeighbors(const FRoomPairing& RoomPairin
 	if (DungeonSpaceGenerator->IsLocationValid(childRoom) && DungeonSpaceGenerator->IsLocationValid(parentRoom))
 	{
 		// Link the children
-		if (bIsTightCoupling)
-		{
-			DungeonSpaceGenerator->DungeonSpace.GetLowRes(childRoom.Z)[childRoom.Y][childRoom.X].NeighboringTightlyCoupledRooms.Add(parentRoom);
-			DungeonSpaceGenerator->DungeonSpace.GetLowRes(parentRoom.Z)[parentRoom.Y][parentRoom.X].NeighboringTightlyCoupledRooms.Add(childRoom);
-		}
-		else
-		{
-			DungeonSpaceGenerator->DungeonSpace.GetLowRes(childRoom.Z)[childRoom.Y][childRoom.X].NeighboringRooms.Add(parentRoom);
-			DungeonSpaceGenerator->DungeonSpace.GetLowRes(parentRoom.Z)[parentRoom.Y][parentRoom.X].NeighboringRooms.Add(childRoom);
-		}
+		DungeonSpaceGenerator->DungeonSpace.AddNeighbor(childRoom, parentRoom, bIsTightCoupling);
+		DungeonSpaceGenerator->DungeonSpace.AddNeighbor(parentRoom, childRoom, bIsTightCoupling);
 	}
 }
\ No newline at end of file
@@ -11,204 +11,251 @@
 void UNeighboringMissionSpaceHandler::GenerateDungeonRooms(UDungeonMissionNode* Head, FIntVector StartLocation, FRandomStream &Rng, int32 SymbolCount)
 {
 	FMissionSpaceHelper spaceHelper = FMissionSpaceHelper(Rng, StartLocation);
-	TMap<FIntVector, FIntVector> availableRooms;
-	availableRooms.Add(StartLocation, INVALID_LOCATION);
-	PairNodesToRooms(Head, availableRooms, spaceHelper, false, SymbolCount);
-}
-
-bool UNeighboringMissionSpaceHandler::PairNodesToRooms(UDungeonMissionNode* Node, TMap<FIntVector, FIntVector>& AvailableRooms,
-	FMissionSpaceHelper& SpaceHelper, bool bIsTightCoupling, int32 TotalSymbolCount)
-{
-	// This is the real "meat and potatoes" of mapping the Dungeon Mission to the Dungeon Space.
-	// It will take a given node and assign it to a room. It also will go and check all children
-	// of that node, assigning them to rooms as well, if needed.
-	
-	// Check input
-	if (CheckCanSkipProcessing(Node, SpaceHelper))
-	{
-		UE_LOG(LogSpaceGen, Verbose, TEXT("Skipping processing for %s."), *Node->GetSymbolDescription());
-		return true;
-	}
-	if (!CheckInputIsValid(AvailableRooms, bIsTightCoupling, Node, SpaceHelper))
-	{
-		UE_LOG(LogSpaceGen, Warning, TEXT("Could not place %s due to invalid input."), *Node->GetSymbolDescription());
-		return false;
-	}
-
-	// Input valid; let's go
-
-	UE_LOG(LogSpaceGen, Log, TEXT("Creating room for %s! Rooms available: %d, Room Children: %d"), *Node->GetSymbolDescription(), AvailableRooms.Num(), Node->ChildrenNodes.Num());
-	// Find an open room to add this to
-	FRoomPairing roomLocation;
-	if (bIsTightCoupling)
-	{
-		// A tightly-coupled room must be placed adjacent to the last room we placed.
-		roomLocation = GetOpenRoom(Node, AvailableRooms, SpaceHelper);
-	}
-	else
-	{
-		// This room can be placed alongside any room we have already placed.
-		roomLocation = GetOpenRoom(Node, SpaceHelper.OpenRooms, SpaceHelper);
-	}
+	TArray<FPlacementStep> steps;
+	BuildPlacementOrder(Head, steps);
 
-	// The key of the roomLocation is where the next room will be placed
-	// The value is what room is adjacent to it
-
-	// Mark the next room location as invalid
-	// That way, we don't reuse it if something goes wrong
-	FIntVector nextLocation = roomLocation.ChildRoom;
-	SpaceHelper.MarkAsProcessed(nextLocation);
-	// Mark this node as processed ahead of time
-	// If we go recursive depth-first instead of breadth-first, it will
-	// mess with things if we haven't been marked as processed
-	SpaceHelper.MarkAsProcessed(Node);
-
-	// Grab all our neighbor rooms, excluding those which have already been processed
-	TMap<FIntVector, FIntVector> roomNeighborMap = GetRoomNeighbors(nextLocation, SpaceHelper);
-
-	// Process all our child nodes
-	TArray<UDungeonMissionNode*> nextToProcess;
-	for (UDungeonMakerNode* childNode : Node->ChildrenNodes)
+	// Place one node at a time. When a node has nowhere to go, back up one step and move
+	// that room somewhere else instead, undoing only the rooms placed since then.
+	TArray<FPlacementFrame> frames;
+	frames.SetNum(steps.Num());
+	TArray<FOpenRoomChange> undoLog;
+	int32 backtrackCount = 0;
+	int32 current = 0;
+	bool bIsNewStep = true;
+	while (current < steps.Num())
 	{
-		if (childNode->bTightlyCoupledToParent)
+		const FPlacementStep& step = steps[current];
+		FPlacementFrame& frame = frames[current];
+		if (bIsNewStep)
 		{
-			// If we're tightly coupled to our parent, ensure we get added to a neighboring leaf
-			// We do this by going depth-first
-			UE_LOG(LogSpaceGen, Verbose, TEXT("Placing tightly-coupled room %s next to parent %s."), *childNode->GetNodeTitle(), *Node->GetNodeTitle());
-			bool bSuccesfullyPairedChild = PairNodesToRooms((UDungeonMissionNode*)childNode, roomNeighborMap, SpaceHelper, true, TotalSymbolCount);
-			if (!bSuccesfullyPairedChild)
+			frame.CandidateRooms.Reset();
+			frame.TriedRooms.Reset();
+			if (step.AnchorStep != INDEX_NONE)
 			{
-				// Failed to find a child leaf; back out of our current node
-				SpaceHelper.MarkAsUnprocessed(Node);
-				// Restart processing our current node -- now that the leaf we tried has been
-				// marked as invalid, we're guaranteed to choose a different leaf next time
-				UE_LOG(LogSpaceGen, Warning, TEXT("Restarting processing for %s because we couldn't find enough child rooms to match our tightly-coupled rooms."), *Node->GetSymbolDescription());
-				return PairNodesToRooms(Node, AvailableRooms, SpaceHelper, bIsTightCoupling, TotalSymbolCount);
+				// A tightly-coupled room must be placed adjacent to its parent
+				GetRoomNeighbors(frames[step.AnchorStep].Room.ChildRoom, spaceHelper, frame.CandidateRooms);
 			}
 		}
-		else
+
+		// A loose room can be placed alongside any room we have already placed. Undoing later steps
+		// puts the open rooms back the way they were, so they don't need copying for when we come back here.
+		const TMap<FIntVector, FIntVector>& candidateRooms = step.AnchorStep != INDEX_NONE ? frame.CandidateRooms : spaceHelper.OpenRooms;
+		FRoomPairing room = GetOpenRoom(step.Node, candidateRooms, frame.TriedRooms, spaceHelper);
+		if (room.ChildRoom != INVALID_LOCATION)
 		{
-			// Doesn't matter where we get placed
-			// Add our child to the list of nodes to process next
-			// These will be processed breadth-first in the next step
-			nextToProcess.Add((UDungeonMissionNode*)childNode);
+			PlaceRoom(step, frame, room, spaceHelper, undoLog, SymbolCount);
+			current++;
+			bIsNewStep = true;
+			continue;
 		}
-	}
 
-	// If we're allowed to have children, mark our neighbors as available
-	if (((UDungeonMissionSymbol*)Node->NodeType)->bAllowedToHaveChildren)
-	{
-		AvailableRooms.Append(roomNeighborMap);
+		if (current == 0 || backtrackCount >= MaxBacktrackCount)
+		{
+			// CreateDungeonSpace will see we came up short and roll back everything we placed
+			UE_LOG(LogSpaceGen, Warning, TEXT("Could not find a room for %s after backtracking %d times."), *step.Node->GetSymbolDescription(), backtrackCount);
+			break;
+		}
+		backtrackCount++;
+		current--;
+		UE_LOG(LogSpaceGen, Verbose, TEXT("Ran out of rooms for %s; moving %s somewhere else."), *step.Node->GetSymbolDescription(), *steps[current].Node->GetSymbolDescription());
+		UndoPlacement(steps[current], frames[current], spaceHelper, undoLog);
+		bIsNewStep = false;
 	}
-	// List all the rooms we have open
-	SpaceHelper.AddOpenRooms(AvailableRooms);
+	UE_LOG(LogSpaceGen, Log, TEXT("Placed %d of %d mission nodes, backtracking %d times."), current, steps.Num(), backtrackCount);
+}
 
+void UNeighboringMissionSpaceHandler::BuildPlacementOrder(UDungeonMissionNode* Head, TArray<FPlacementStep>& OutSteps) const
+{
+	TMap<const UDungeonMissionNode*, int32> stepIndices;
+	TArray<FPlacementStep> toVisit;
+	FPlacementStep headStep;
+	headStep.Node = Head;
+	headStep.AnchorStep = INDEX_NONE;
+	toVisit.Add(headStep);
 
-	// Step 2: Process all non-tightly coupled nodes
-	TArray<UDungeonMissionNode*> deferredNodes;
-	UE_LOG(LogSpaceGen, Verbose, TEXT("%s has %d children to process."), *Node->GetNodeTitle(), nextToProcess.Num());
-	for (int i = 0; i < nextToProcess.Num(); i++)
+	TArray<UDungeonMissionNode*> readyChildren;
+	while (toVisit.Num() > 0)
 	{
-		// If we're not tightly coupled, ensure that we have all our required parents generated
-		bool bDeferProcessing = false;
-		for (int j = 0; j < nextToProcess[i]->ParentNodes.Num(); j++)
+		FPlacementStep next = toVisit.Pop(false);
+		if (next.Node == NULL || stepIndices.Contains(next.Node))
 		{
-			if (!SpaceHelper.HasProcessed((UDungeonMissionNode*)nextToProcess[i]->ParentNodes[j]))
-			{
-				bDeferProcessing = true;
-				break;
-			}
+			continue;
 		}
-		if (bDeferProcessing)
+		if (((UDungeonMissionSymbol*)next.Node->NodeType)->RoomTypes.Num() == 0)
 		{
-			// Defer processing a bit
-			deferredNodes.Add(nextToProcess[i]);
+			UE_LOG(LogSpaceGen, Error, TEXT("Mission Space Handler tried handling %s, which had no room types defined!"), *next.Node->GetNodeTitle());
 			continue;
 		}
+		int32 stepIndex = OutSteps.Add(next);
+		stepIndices.Add(next.Node, stepIndex);
 
-		UE_LOG(LogSpaceGen, Verbose, TEXT("Placing loosely-coupled room %s. Parent: %s."), *nextToProcess[i]->GetNodeTitle(), *Node->GetNodeTitle());
-		bool bSuccesfullyPairedChild = PairNodesToRooms(nextToProcess[i], AvailableRooms, SpaceHelper, false, TotalSymbolCount);
-		if (!bSuccesfullyPairedChild)
+		// Children are only ready once all their parents have been placed
+		readyChildren.Reset();
+		for (UDungeonMakerNode* child : next.Node->ChildrenNodes)
 		{
-			// Failed to find a child leaf; back out
-			SpaceHelper.MarkAsUnprocessed(Node);
-			// Restart -- next time, we'll select a different leaf
-			UE_LOG(LogSpaceGen, Warning, TEXT("Restarting processing for %s because we couldn't find enough child leaves."), *Node->GetSymbolDescription());
-			return PairNodesToRooms(Node, AvailableRooms, SpaceHelper, bIsTightCoupling, TotalSymbolCount);
+			bool bIsReady = child != NULL;
+			for (int32 i = 0; bIsReady && i < child->ParentNodes.Num(); i++)
+			{
+				bIsReady = child->ParentNodes[i] == NULL || stepIndices.Contains((UDungeonMissionNode*)child->ParentNodes[i]);
+			}
+			if (bIsReady)
+			{
+				readyChildren.Add((UDungeonMissionNode*)child);
+			}
+		}
+		// Push loosely-coupled children first, so tightly-coupled ones get placed first; both go backwards to keep their order
+		for (int32 pass = 0; pass < 2; pass++)
+		{
+			bool bTightPass = pass == 1;
+			for (int32 i = readyChildren.Num() - 1; i >= 0; i--)
+			{
+				if (readyChildren[i]->bTightlyCoupledToParent == bTightPass)
+				{
+					FPlacementStep childStep;
+					childStep.Node = readyChildren[i];
+					childStep.AnchorStep = bTightPass ? stepIndex : INDEX_NONE;
+					toVisit.Add(childStep);
+				}
+			}
 		}
 	}
+}
+
+void UNeighboringMissionSpaceHandler::PlaceRoom(const FPlacementStep& Step, FPlacementFrame& Frame, const FRoomPairing& Room,
+	FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog, int32 TotalSymbolCount)
+{
+	UE_LOG(LogSpaceGen, Verbose, TEXT("Creating room for %s at (%d, %d, %d)."), *Step.Node->GetSymbolDescription(), Room.ChildRoom.X, Room.ChildRoom.Y, Room.ChildRoom.Z);
+	Frame.Room = Room;
+	Frame.UndoLogSize = UndoLog.Num();
+	Frame.RoomSavepoint = CreateRoomSavepoint();
+
+	SpaceHelper.MarkAsProcessed(Room.ChildRoom);
+	SpaceHelper.MarkAsProcessed(Step.Node);
+	SetOpenRoom(Room.ChildRoom, INVALID_LOCATION, false, SpaceHelper, UndoLog);
 
+	// Make the actual room
+	FFloorRoom floorRoom = MakeFloorRoom(Step.Node, Room.ChildRoom, SpaceHelper.Rng, TotalSymbolCount);
+	SetRoom(floorRoom);
+	UpdateNeighbors(Room, Step.AnchorStep != INDEX_NONE);
 
-	// Step 3: Attempt to place our deferred nodes
-	TMap<UDungeonMissionNode*, uint8> attemptCount;
-	const uint8 MAX_ATTEMPT_COUNT = 12;
-	while (deferredNodes.Num() > 0)
+	// If we're allowed to have children, mark our neighbors as available
+	if (((UDungeonMissionSymbol*)Step.Node->NodeType)->bAllowedToHaveChildren)
 	{
-		UDungeonMissionNode* currentNode = deferredNodes[0];
-		deferredNodes.RemoveAt(0);
-		if (attemptCount.Contains(currentNode))
+		for (const FIntVector& neighbor : GetAvailableLocations(Room.ChildRoom, SpaceHelper.GetProcessedRooms()))
 		{
-			attemptCount[currentNode]++;
+			SetOpenRoom(neighbor, Room.ChildRoom, true, SpaceHelper, UndoLog);
 		}
-		else
+	}
+}
+
+void UNeighboringMissionSpaceHandler::UndoPlacement(const FPlacementStep& Step, const FPlacementFrame& Frame,
+	FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog)
+{
+	for (int32 i = UndoLog.Num() - 1; i >= Frame.UndoLogSize; i--)
+	{
+		const FOpenRoomChange& change = UndoLog[i];
+		if (change.bWasOpen)
 		{
-			attemptCount.Add(currentNode, 1);
+			SpaceHelper.OpenRooms.Add(change.Location, change.PreviousParent);
 		}
-
-		bool bDeferProcessing = false;
-		for (int j = 0; j < currentNode->ParentNodes.Num(); j++)
+		else
 		{
-			if (!SpaceHelper.HasProcessed((UDungeonMissionNode*)currentNode->ParentNodes[j]))
-			{
-				bDeferProcessing = true;
-				break;
-			}
+			SpaceHelper.OpenRooms.Remove(change.Location);
 		}
-		if (!bDeferProcessing)
+	}
+	UndoLog.SetNum(Frame.UndoLogSize, false);
+
+	RollbackRooms(Frame.RoomSavepoint);
+	SpaceHelper.MarkAsUnprocessed(Frame.Room.ChildRoom);
+	SpaceHelper.MarkAsUnprocessed(Step.Node);
+}
+
+void UNeighboringMissionSpaceHandler::SetOpenRoom(FIntVector Location, FIntVector Parent, bool bIsOpen, FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog)
+{
+	const FIntVector* previousParent = SpaceHelper.OpenRooms.Find(Location);
+	if (previousParent == NULL && !bIsOpen)
+	{
+		return;
+	}
+	FOpenRoomChange& change = UndoLog[UndoLog.AddDefaulted()];
+	change.Location = Location;
+	change.bWasOpen = previousParent != NULL;
+	change.PreviousParent = previousParent != NULL ? *previousParent : INVALID_LOCATION;
+	if (bIsOpen)
+	{
+		SpaceHelper.OpenRooms.Add(Location, Parent);
+	}
+	else
+	{
+		SpaceHelper.OpenRooms.Remove(Location);
+	}
+}
+
+EMissionSpaceFeasibility UNeighboringMissionSpaceHandler::CheckMissionFeasibility(UDungeonMissionNode* Head, int32 SymbolCount) const
+{
+	EMissionSpaceFeasibility result = Super::CheckMissionFeasibility(Head, SymbolCount);
+	if (result != EMissionSpaceFeasibility::Feasible || Head == NULL)
+	{
+		return result;
+	}
+
+	// Rooms only ever connect to the four rooms beside them on the same floor.
+	// Every room but the first is placed next to a room that's already there, which takes up one of those.
+	const int32 MAX_NEIGHBOR_COUNT = 4;
+	int32 largestFloorSize = 0;
+	const FDungeonSpace& dungeonSpace = DungeonSpaceGenerator->DungeonSpace;
+	for (int i = 0; i < dungeonSpace.Num(); i++)
+	{
+		largestFloorSize = FMath::Max(largestFloorSize, dungeonSpace.GetLowRes(i).XSize() * dungeonSpace.GetLowRes(i).YSize());
+	}
+
+	const TArray<const UDungeonMakerNode*>& nodes = Head->GetGraphAnalysis().GetTopologicalOrder();
+	// How many nodes are tightly coupled to each node, directly or through other nodes, counting the node itself
+	TMap<const UDungeonMakerNode*, int32> tightGroupSizes;
+	for (int32 i = nodes.Num() - 1; i >= 0; i--)
+	{
+		const UDungeonMakerNode* node = nodes[i];
+		int32 tightChildCount = 0;
+		int32 groupSize = 1;
+		for (const UDungeonMakerNode* child : node->ChildrenNodes)
 		{
-			bool bSuccesfullyPairedChild = PairNodesToRooms(currentNode, AvailableRooms, SpaceHelper, false, TotalSymbolCount);
-			if (!bSuccesfullyPairedChild)
+			if (child == NULL || !child->bTightlyCoupledToParent)
 			{
-				// Failed to find a child leaf; back out
-				SpaceHelper.MarkAsUnprocessed(Node);
-				// Restart -- next time, we'll select a different leaf
-				UE_LOG(LogSpaceGen, Warning, TEXT("Restarting processing for %s because we couldn't find enough child leaves."), *Node->GetSymbolDescription());
-				return PairNodesToRooms(Node, AvailableRooms, SpaceHelper, bIsTightCoupling, TotalSymbolCount);
+				continue;
 			}
-			else
+			tightChildCount++;
+			// Children shared with another parent might be counted twice, so leave them out to stay on the safe side
+			const int32* childGroupSize = tightGroupSizes.Find(child);
+			if (childGroupSize != NULL && child->ParentNodes.Num() == 1)
 			{
-				// Stop keeping track of this
-				attemptCount.Remove(currentNode);
+				groupSize += *childGroupSize;
 			}
 		}
-		else
+		tightGroupSizes.Add(node, groupSize);
+
+		int32 freeNeighborCount = node == Head ? MAX_NEIGHBOR_COUNT : MAX_NEIGHBOR_COUNT - 1;
+		if (tightChildCount > freeNeighborCount)
 		{
-			if (attemptCount[currentNode] < MAX_ATTEMPT_COUNT)
-			{
-				deferredNodes.Add(currentNode);
-			}
+			UE_LOG(LogSpaceGen, Log, TEXT("%s has %d tightly-coupled children, but only %d free neighbors."), *node->ToGraphSymbol().GetSymbolDescription(), tightChildCount, freeNeighborCount);
+			return EMissionSpaceFeasibility::TooManyTightlyCoupledChildren;
+		}
+		// Tightly-coupled rooms never leave the floor their parent is on
+		if (groupSize > largestFloorSize)
+		{
+			UE_LOG(LogSpaceGen, Log, TEXT("%s has %d rooms tightly coupled to it, but floors only have %d rooms."), *node->ToGraphSymbol().GetSymbolDescription(), groupSize, largestFloorSize);
+			return EMissionSpaceFeasibility::TightlyCoupledGroupTooLarge;
 		}
 	}
-
-	// Make the actual room
-	FFloorRoom room = MakeFloorRoom(Node, nextLocation, SpaceHelper.Rng, TotalSymbolCount);
-	SetRoom(room);
-	
-	// Update neighbors
-	UpdateNeighbors(roomLocation, bIsTightCoupling);
-
-	return true;
+	return EMissionSpaceFeasibility::Feasible;
 }
 
-TMap<FIntVector, FIntVector> UNeighboringMissionSpaceHandler::GetRoomNeighbors(FIntVector RoomLocation, FMissionSpaceHelper &SpaceHelper)
+void UNeighboringMissionSpaceHandler::GetRoomNeighbors(FIntVector RoomLocation, FMissionSpaceHelper& SpaceHelper, TMap<FIntVector, FIntVector>& OutNeighbors)
 {
 	// Grab all our neighbor rooms, excluding those which have already been processed
 	TSet<FIntVector> neighboringRooms = GetAvailableLocations(RoomLocation, SpaceHelper.GetProcessedRooms());
-	TMap<FIntVector, FIntVector> roomNeighborMap;
 	// Map us to be the neighbor to all our neighbors
 	for (FIntVector neighbor : neighboringRooms)
 	{
-		roomNeighborMap.Add(neighbor, RoomLocation);
+		OutNeighbors.Add(neighbor, RoomLocation);
 	}
-	return roomNeighborMap;
 }
\ No newline at end of file
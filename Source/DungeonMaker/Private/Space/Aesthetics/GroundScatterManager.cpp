@@ -237,6 +237,11 @@ AActor* UGroundScatterManager::CreateScatterObject(ADungeonRoom* Room, const FIn
 #endif
 
 	SpawnedGroundScatter.Add(scatterActor);
+
+	FPlacedGroundScatter placedScatter;
+	placedScatter.Actor = scatterActor;
+	placedScatter.InstanceIndex = INDEX_NONE;
+	PlacedScatter.FindOrAdd(Location).Add(placedScatter);
 	return scatterActor;
 }
 
@@ -246,15 +251,15 @@ int32 UGroundScatterManager::CreateScatterObject(ADungeonRoom* Room, const FIntV
 {
 	FTransform objectTransform = GetObjectTransform(Room, Location, Scatter, Rng, SelectedObject, Direction);
 
-	// Spawn the item
+	UHierarchicalInstancedStaticMeshComponent* meshComponent;
 	if (StaticMeshes.Contains(SelectedMesh))
 	{
-		return StaticMeshes[SelectedMesh]->AddInstanceWorldSpace(objectTransform);
+		meshComponent = StaticMeshes[SelectedMesh];
 	}
 	else
 	{
 		// Create the mesh component first, then spawn the item
-		UHierarchicalInstancedStaticMeshComponent* meshComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this, FName(*SelectedMesh->GetName()));
+		meshComponent = NewObject<UHierarchicalInstancedStaticMeshComponent>(this, FName(*SelectedMesh->GetName()));
 
 		meshComponent->SetCollisionProfileName(UCollisionProfile::BlockAll_ProfileName);
 		meshComponent->Mobility = EComponentMobility::Movable;
@@ -265,7 +270,55 @@ int32 UGroundScatterManager::CreateScatterObject(ADungeonRoom* Room, const FIntV
 		meshComponent->RegisterComponent();
 
 		StaticMeshes.Add(SelectedMesh, meshComponent);
-		return meshComponent->AddInstanceWorldSpace(objectTransform);
+	}
+
+	// Spawn the item, reusing a cleared instance if we have one
+	int32 instanceIndex;
+	TArray<int32>* freeInstances = FreeInstances.Find(meshComponent);
+	if (freeInstances != NULL && freeInstances->Num() > 0)
+	{
+		instanceIndex = freeInstances->Pop();
+		meshComponent->UpdateInstanceTransform(instanceIndex, objectTransform, true, true);
+	}
+	else
+	{
+		instanceIndex = meshComponent->AddInstanceWorldSpace(objectTransform);
+	}
+
+	FPlacedGroundScatter placedScatter;
+	placedScatter.MeshComponent = meshComponent;
+	placedScatter.InstanceIndex = instanceIndex;
+	PlacedScatter.FindOrAdd(Location).Add(placedScatter);
+	return instanceIndex;
+}
+
+void UGroundScatterManager::ClearGroundScatter(const FIntVector& Min, const FIntVector& Max)
+{
+	// Collapsed instances stay in place so the indices of everything else stay stable
+	FTransform hiddenTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	for (int y = Min.Y; y < Max.Y; y++)
+	{
+		for (int x = Min.X; x < Max.X; x++)
+		{
+			TArray<FPlacedGroundScatter> placedScatter;
+			if (!PlacedScatter.RemoveAndCopyValue(FIntVector(x, y, Min.Z), placedScatter))
+			{
+				continue;
+			}
+			for (const FPlacedGroundScatter& scatter : placedScatter)
+			{
+				if (scatter.MeshComponent.IsValid())
+				{
+					scatter.MeshComponent->UpdateInstanceTransform(scatter.InstanceIndex, hiddenTransform, true, true);
+					FreeInstances.FindOrAdd(scatter.MeshComponent.Get()).Add(scatter.InstanceIndex);
+				}
+				else if (scatter.Actor.IsValid())
+				{
+					SpawnedGroundScatter.Remove(scatter.Actor.Get());
+					scatter.Actor->Destroy();
+				}
+			}
+		}
 	}
 }
 bool UGroundScatterManager::IsAdjacencyOkay(ETileDirection Direction, const UGroundScatterItem* Scatter, 
@@ -273,18 +326,25 @@ bool UGroundScatterManager::IsAdjacencyOkay(ETileDirection Direction, const UGro
 {
 	if (Direction != ETileDirection::Center)
 	{
+		FRoomTileView roomTiles = Room->GetTileView();
 		if (!Scatter->bPlaceAdjacentToNextRooms)
 		{
 			for (int x = -1; x <= 1; x++)
 			{
 				for (int y = -1; y <= 1; y++)
 				{
-					FFloorRoom nextRoom = Room->GetFloorManager()->GetRoomFromTileSpace(Location + FIntVector(x, y, Location.Z));
+					FIntVector neighborLocation = Location + FIntVector(x, y, 0);
+					if (roomTiles.Contains(neighborLocation))
+					{
+						// Still inside our own room
+						continue;
+					}
+					const FFloorRoom& nextRoom = Room->GetFloorManager()->GetRoomFromTileSpace(neighborLocation);
 					if (nextRoom.SpawnedRoom == NULL || nextRoom.SpawnedRoom == Room)
 					{
 						continue;
 					}
-					if (Room->RoomMetadata.GetOutgoingRooms().Contains(nextRoom.Location))
+					if (Room->RoomMetadata.IsOutgoingRoom(nextRoom.Location))
 					{
 						return false;
 					}
@@ -298,12 +358,18 @@ bool UGroundScatterManager::IsAdjacencyOkay(ETileDirection Direction, const UGro
 			{
 				for (int y = -1; y <= 1; y++)
 				{
-					FFloorRoom nextRoom = Room->GetFloorManager()->GetRoomFromTileSpace(Location + FIntVector(x, y, Location.Z));
+					FIntVector neighborLocation = Location + FIntVector(x, y, 0);
+					if (roomTiles.Contains(neighborLocation))
+					{
+						// Still inside our own room
+						continue;
+					}
+					const FFloorRoom& nextRoom = Room->GetFloorManager()->GetRoomFromTileSpace(neighborLocation);
 					if (nextRoom.SpawnedRoom == NULL || nextRoom.SpawnedRoom == Room)
 					{
 						continue;
 					}
-					if (Room->RoomMetadata.IncomingRoom == nextRoom.Location)
+					if (Room->RoomMetadata.HasIncomingRoom() && Room->RoomMetadata.GetIncomingRoom() == nextRoom.Location)
 					{
 						return false;
 					}
@@ -321,8 +387,7 @@ FScatterObject UGroundScatterManager::FindScatterObject(const UGroundScatterItem
 	TSubclassOf<AActor> selectedActor = NULL;
 	UStaticMesh* selectedStaticMesh = NULL;
 
-	FIntVector roomLocationMin = Room->GetRoomLocation();
-	FIntVector roomLocationMax = roomLocationMin + Room->GetRoomSize();
+	FRoomTileView roomTiles = Room->GetTileView();
 
 	FScatterObject selectedMesh;
 	do
@@ -344,16 +409,16 @@ FScatterObject UGroundScatterManager::FindScatterObject(const UGroundScatterItem
 		// Verify this mesh can work at this location
 		FIntVector maxOffset = Location + SelectedObject.EdgeOffset;
 		FIntVector minOffset = Location - SelectedObject.EdgeOffset;
-		if (minOffset.X < roomLocationMin.X || minOffset.Y < roomLocationMin.Y)
+		if (!roomTiles.Contains(FIntVector(minOffset.X, minOffset.Y, Location.Z)))
 		{
 			// Too close to the edge of the room
 			continue;
 		}
-		if (maxOffset.X >= roomLocationMax.X || maxOffset.Y >= roomLocationMax.Y)
+		if (!roomTiles.Contains(FIntVector(maxOffset.X, maxOffset.Y, Location.Z)))
 		{
 			// Too close to the positive edge of the room
 			continue;
-		};
+		}
 
 		if (!SelectedObject.DirectionOffsets.Contains(Direction))
 		{
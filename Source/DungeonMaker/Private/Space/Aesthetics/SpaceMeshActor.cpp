@@ -59,5 +59,24 @@ void ASpaceMeshActor::SetStaticMesh(const UDungeonTile* Tile, TArray<FDungeonTil
 int32 ASpaceMeshActor::AddInstance(int32 MeshID, const FTransform& Transform)
 {
 	verify(MeshComponents.IsValidIndex(MeshID));
+	if (FreeInstances.IsValidIndex(MeshID) && FreeInstances[MeshID].Num() > 0)
+	{
+		int32 instanceIndex = FreeInstances[MeshID].Pop();
+		MeshComponents[MeshID]->UpdateInstanceTransform(instanceIndex, Transform, false, true);
+		return instanceIndex;
+	}
 	return MeshComponents[MeshID]->AddInstance(Transform);
 }
+
+void ASpaceMeshActor::RemoveInstance(int32 MeshID, int32 InstanceIndex)
+{
+	verify(MeshComponents.IsValidIndex(MeshID));
+	if (FreeInstances.Num() < MeshComponents.Num())
+	{
+		FreeInstances.SetNum(MeshComponents.Num());
+	}
+	// Collapse the instance down to nothing instead of removing it, so indices stay stable
+	FTransform hiddenTransform(FQuat::Identity, FVector::ZeroVector, FVector::ZeroVector);
+	MeshComponents[MeshID]->UpdateInstanceTransform(InstanceIndex, hiddenTransform, false, true);
+	FreeInstances[MeshID].Add(InstanceIndex);
+}
@@ -3,6 +3,10 @@
 #include "Dungeon.h"
 #include "DungeonMaker.h"
 #include "Grammar/Grammar.h"
+#include "Floor/DungeonSpaceFile.h"
+#include "Misc/Paths.h"
+#include "Misc/SecureHash.h"
+#include "UObject/Package.h"
 
 #include <DrawDebugHelpers.h>
 
@@ -39,6 +43,17 @@ void ADungeon::BeginPlay()
 		rng.Initialize(Seed);
 	}
 	UE_LOG(LogMissionGen, Log, TEXT("Creating dungeon out of seed %d."), Seed);
+
+	FString cachePath;
+	if (bCacheGeneratedDungeons && !bDebugMission)
+	{
+		cachePath = GetDungeonCachePath(rng.GetInitialSeed());
+		if (Space->LoadDungeonSpace(cachePath, rng))
+		{
+			return;
+		}
+	}
+
 	bool bSuccessfullyMadeDungeon = false;
 	int32 attemptCount = 0;
 	const int32 MAX_ATTEMPTS = 100;
@@ -62,4 +77,47 @@ void ADungeon::BeginPlay()
 			}
 		}
 	} while (!bSuccessfullyMadeDungeon && attemptCount < MAX_ATTEMPTS);
+
+	if (bSuccessfullyMadeDungeon && !cachePath.IsEmpty())
+	{
+		Space->SaveDungeonSpace(cachePath);
+	}
+}
+
+// Asset paths stay the same when an asset is edited, so each one is stamped with the GUID its package was last saved with.
+static FString GetAssetCacheKey(const UObject* Asset)
+{
+	if (Asset == NULL)
+	{
+		return TEXT("None");
+	}
+	return Asset->GetPathName() + TEXT("@") + Asset->GetOutermost()->GetGuid().ToString();
+}
+
+FString ADungeon::GetDungeonCachePath(int32 DungeonSeed) const
+{
+	// Anything which changes what gets generated has to be part of the key
+	FString key = FString::Printf(TEXT("%u|%d|%s|%d|%d|%d|%d|%s"), FDungeonSpaceFile::VERSION, DungeonSeed,
+		*GetAssetCacheKey(Mission->HeadSymbol.Symbol), Mission->HeadSymbol.SymbolID,
+		Space->DungeonSize, Space->RoomSize, Space->MaxGeneratedRooms, *GetAssetCacheKey(Space->MissionToSpaceHandlerClass));
+	for (const UDungeonMissionGrammar* grammar : Mission->Grammars)
+	{
+		key += TEXT("|") + GetAssetCacheKey(grammar);
+	}
+	const UDungeonTile* defaultTiles[] = { Space->DefaultFloorTile, Space->DefaultWallTile, Space->DefaultEntranceTile, Space->DefaultExitTile };
+	for (const UDungeonTile* tile : defaultTiles)
+	{
+		key += TEXT("|") + GetAssetCacheKey(tile);
+	}
+	TArray<FRoomReplacements> replacementPhases = Space->PreGenerationRoomReplacementPhases;
+	replacementPhases.Append(Space->PostGenerationRoomReplacementPhases);
+	for (const FRoomReplacements& phase : replacementPhases)
+	{
+		for (const URoomReplacementPattern* pattern : phase.ReplacementPatterns)
+		{
+			key += TEXT("|") + GetAssetCacheKey(pattern);
+		}
+		key += TEXT(";");
+	}
+	return FPaths::Combine(FPaths::ProjectSavedDir(), TEXT("DungeonCache"), FMD5::HashAnsiString(*key) + TEXT(".dungeon"));
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "DungeonSpaceGenerator.h"
 #include "MissionSpaceHandlers/NeighboringMissionSpaceHandler.h"
+#include "Floor/DungeonSpaceFile.h"
 
 // Sets default values for this component's properties
 UDungeonSpaceGenerator::UDungeonSpaceGenerator()
@@ -27,6 +28,56 @@ bool UDungeonSpaceGenerator::CreateDungeonSpace(UDungeonMissionNode* Head, int32
 	return true;
 }
 
+bool UDungeonSpaceGenerator::SaveDungeonSpace(const FString& FilePath) const
+{
+	return FDungeonSpaceFile::SaveToFile(DungeonSpace, FilePath);
+}
+
+bool UDungeonSpaceGenerator::LoadDungeonSpace(const FString& FilePath, FRandomStream& Rng)
+{
+	FDungeonSpaceFileReader reader;
+	if (!reader.Open(FilePath))
+	{
+		UE_LOG(LogSpaceGen, Verbose, TEXT("No saved dungeon at %s."), *FilePath);
+		return false;
+	}
+	const FDungeonSpaceFileView& view = reader.GetView();
+	FString error;
+	if (!view.Validate(error))
+	{
+		UE_LOG(LogSpaceGen, Warning, TEXT("Could not load dungeon from %s: %s"), *FilePath, *error);
+		return false;
+	}
+
+	// Make sure every asset the file needs exists before we start spawning anything
+	TArray<const UDungeonTile*> palette;
+	TMap<FIntVector, FIntVector> roomTileSizes;
+	if (!FDungeonSpaceFile::ReadPalette(view, palette) || !FDungeonSpaceFile::ReadLayout(view, DefaultFloorTile, DungeonSpace, roomTileSizes))
+	{
+		UE_LOG(LogSpaceGen, Warning, TEXT("Could not load dungeon from %s because it references missing assets."), *FilePath);
+		DungeonSpace = FDungeonSpace();
+		return false;
+	}
+	RoomSize = view.GetHeader().RoomSize;
+
+	CreateFloorManagers();
+	for (UDungeonFloorManager* floor : Floors)
+	{
+		floor->RestoreRooms(roomTileSizes, Rng, GlobalGroundScatter);
+	}
+	// Spawning the rooms filled them with default tiles, so put the saved tiles back
+	FDungeonSpaceFile::ReadTiles(view, palette, DungeonSpace);
+	for (UDungeonFloorManager* floor : Floors)
+	{
+		floor->RestoreRoomInterfaces(Rng);
+	}
+	TotalSymbolCount = MissionRooms.Num();
+
+	UE_LOG(LogSpaceGen, Log, TEXT("Loaded %d rooms from %s."), MissionRooms.Num(), *FilePath);
+	PlaceMeshes(Rng);
+	return true;
+}
+
 bool UDungeonSpaceGenerator::CreateLowResMap(int32 SymbolCount, UDungeonMissionNode* Head, FRandomStream& Rng)
 {
 	// Create floors
@@ -46,6 +97,17 @@ bool UDungeonSpaceGenerator::CreateLowResMap(int32 SymbolCount, UDungeonMissionN
 	MissionSpaceHandler = NewObject<UDungeonMissionSpaceHandler>(GetOuter(), MissionToSpaceHandlerClass, TEXT("Mission Space Manager"));
 	MissionSpaceHandler->RoomSize = RoomSize;
 	MissionSpaceHandler->InitializeDungeonFloor(this, dungeonLevelSizes);
+
+	// Missions that can't fit are much cheaper to catch here than after placing fails
+	EMissionSpaceFeasibility feasibility = MissionSpaceHandler->CheckMissionFeasibility(Head, TotalSymbolCount);
+	FeasibilityStats.Record(feasibility);
+	if (feasibility != EMissionSpaceFeasibility::Feasible)
+	{
+		UE_LOG(LogSpaceGen, Log, TEXT("Mission can't fit in the dungeon space; %d of %d missions rejected so far."), FeasibilityStats.GetTotalRejectionCount(), FeasibilityStats.CheckCount);
+		MissionSpaceHandler->DestroyComponent();
+		return false;
+	}
+
 	// Map the mission to the space
 	if (MissionSpaceHandler->CreateDungeonSpace(Head, FIntVector(0, 0, 0), TotalSymbolCount, Rng))
 	{
@@ -65,76 +127,118 @@ void UDungeonSpaceGenerator::CreateTilemap(FRandomStream& Rng)
 	// Convert low-res maps to high-res
 	DungeonSpace.CopyLosResToHighRes(DefaultFloorTile);
 
-	for (int i = 0; i < DungeonSpace.Num(); i++)
+	CreateFloorManagers();
+	for (UDungeonFloorManager* floor : Floors)
 	{
-		FString floorName = "Floor ";
-		floorName.AppendInt(i);
-		UDungeonFloorManager* floor = NewObject<UDungeonFloorManager>(GetOuter(), FName(*floorName));
-		floor->InitializeFloorManager(this, i);
-		Floors.Add(floor);
 		floor->CreateRoomTiles(Rng, GlobalGroundScatter);
 	}
 
 #if WITH_EDITOR
 	for (int i = 0; i < DungeonSpace.ZSize(); i++)
 	{
-		UE_LOG(LogSpaceGen, Log, TEXT("Dungeon Level %d Tiles:\n%s"), i, *DungeonSpace.GetHighRes(i).ToString());
+		UE_LOG(LogSpaceGen, Log, TEXT("Dungeon Level %d Tiles:\n%s"), i, *DungeonSpace.FloorToString(i));
 	}
 #endif
 }
 
+void UDungeonSpaceGenerator::CreateFloorManagers()
+{
+	for (int i = 0; i < DungeonSpace.Num(); i++)
+	{
+		FString floorName = "Floor ";
+		floorName.AppendInt(i);
+		UDungeonFloorManager* floor = NewObject<UDungeonFloorManager>(GetOuter(), FName(*floorName));
+		floor->InitializeFloorManager(this, i);
+		Floors.Add(floor);
+	}
+}
+
 void UDungeonSpaceGenerator::PlaceMeshes(FRandomStream& Rng)
 {
+	// Everything is about to be built from scratch, so nothing is out of date
+	DungeonSpace.ClearDirtyRegions();
 	if (bDebugDungeon)
 	{
 		DrawDebugSpace();
 	}
 	else
 	{
-		TSet<const UDungeonTile*> roomTiles = DungeonSpace.FindAllTiles();
-		for (const UDungeonTile* tile : roomTiles)
+		CreateTileMeshActors(DungeonSpace.FindAllTiles());
+		UE_LOG(LogSpaceGen, Log, TEXT("Generated %d ceiling meshes and %d floor meshes for %d rooms."), CeilingComponentLookup.Num(), FloorComponentLookup.Num(), MissionRooms.Num());
+
+		for (UDungeonFloorManager* floor : Floors)
 		{
-			if (!FloorComponentLookup.Contains(tile) && tile->GroundMesh.Num() > 0)
-			{
-				// Otherwise, create a new InstancedStaticMeshComponent
-				FString componentName = tile->TileID.ToString() + " Floor";
-				UE_LOG(LogSpaceGen, Verbose, TEXT("Generating new dungeon space actor %s."), *componentName);
-
-				ASpaceMeshActor* floorMeshComponent = (ASpaceMeshActor*)GetWorld()->SpawnActor(ASpaceMeshActor::StaticClass());
-				floorMeshComponent->Rename(*componentName);
-				floorMeshComponent->SetStaticMesh(tile, tile->GroundMesh);
-				FloorComponentLookup.Add(tile, floorMeshComponent);
-			}
-			if (!CeilingComponentLookup.Contains(tile) && tile->CeilingMesh.Num() > 0)
-			{
-				// Otherwise, create a new InstancedStaticMeshComponent
-				FString componentName = tile->TileID.ToString() + " Ceiling";
-				UE_LOG(LogSpaceGen, Verbose, TEXT("Generating new dungeon space actor %s."), *componentName);
-
-				ASpaceMeshActor* ceilingMeshComponent = (ASpaceMeshActor*)GetWorld()->SpawnActor(ASpaceMeshActor::StaticClass());
-				ceilingMeshComponent->Rename(*componentName);
-				ceilingMeshComponent->SetStaticMesh(tile, tile->CeilingMesh);
-				CeilingComponentLookup.Add(tile, ceilingMeshComponent);
-			}
+			floor->SpawnRoomMeshes(FloorComponentLookup, CeilingComponentLookup, Rng);
 		}
-		UE_LOG(LogSpaceGen, Log, TEXT("Generated %d ceiling meshes and %d floor meshes for %d rooms."), CeilingComponentLookup.Num(), FloorComponentLookup.Num(), MissionRooms.Num());
+	}
+	// Rooms may have changed tiles once they finished generating
+	RebuildDirtyRegions(Rng);
+}
 
+void UDungeonSpaceGenerator::CreateTileMeshActors(const TSet<const UDungeonTile*>& Tiles)
+{
+	for (const UDungeonTile* tile : Tiles)
+	{
+		if (!FloorComponentLookup.Contains(tile) && tile->GroundMesh.Num() > 0)
+		{
+			// Otherwise, create a new InstancedStaticMeshComponent
+			FString componentName = tile->TileID.ToString() + " Floor";
+			UE_LOG(LogSpaceGen, Verbose, TEXT("Generating new dungeon space actor %s."), *componentName);
+
+			ASpaceMeshActor* floorMeshComponent = (ASpaceMeshActor*)GetWorld()->SpawnActor(ASpaceMeshActor::StaticClass());
+			floorMeshComponent->Rename(*componentName);
+			floorMeshComponent->SetStaticMesh(tile, tile->GroundMesh);
+			FloorComponentLookup.Add(tile, floorMeshComponent);
 #if WITH_EDITOR
-		for (auto& kvp : CeilingComponentLookup)
+			floorMeshComponent->SetFolderPath("Rooms/Meshes/Floor");
+#endif
+		}
+		if (!CeilingComponentLookup.Contains(tile) && tile->CeilingMesh.Num() > 0)
 		{
-			FString folderPath = "Rooms/Meshes/Ceiling";
-			kvp.Value->SetFolderPath(FName(*folderPath));
+			// Otherwise, create a new InstancedStaticMeshComponent
+			FString componentName = tile->TileID.ToString() + " Ceiling";
+			UE_LOG(LogSpaceGen, Verbose, TEXT("Generating new dungeon space actor %s."), *componentName);
+
+			ASpaceMeshActor* ceilingMeshComponent = (ASpaceMeshActor*)GetWorld()->SpawnActor(ASpaceMeshActor::StaticClass());
+			ceilingMeshComponent->Rename(*componentName);
+			ceilingMeshComponent->SetStaticMesh(tile, tile->CeilingMesh);
+			CeilingComponentLookup.Add(tile, ceilingMeshComponent);
+#if WITH_EDITOR
+			ceilingMeshComponent->SetFolderPath("Rooms/Meshes/Ceiling");
+#endif
 		}
-		for (auto& kvp : FloorComponentLookup)
+	}
+}
+
+void UDungeonSpaceGenerator::RebuildDirtyRegions(FRandomStream& Rng)
+{
+	TArray<FDungeonDirtyRegion> dirtyRegions = DungeonSpace.ConsumeDirtyRegions();
+	if (dirtyRegions.Num() == 0)
+	{
+		return;
+	}
+	UE_LOG(LogSpaceGen, Log, TEXT("Rebuilding %d changed regions of the dungeon."), dirtyRegions.Num());
+
+	for (const FDungeonDirtyRegion& region : dirtyRegions)
+	{
+		int32 z = region.Min.Z;
+		if (bDebugDungeon)
 		{
-			FString folderPath = "Rooms/Meshes/Floor";
-			kvp.Value->SetFolderPath(FName(*folderPath));
+			DungeonSpace.GetHighRes(z).DrawDungeonFloor(GetOwner(), z, region.Min, region.Max);
+			continue;
 		}
-#endif
 
-		for (UDungeonFloorManager* floor : Floors)
+		// New tiles may have been introduced which don't have meshes yet
+		TSet<const UDungeonTile*> regionTiles;
+		DungeonSpace.GetRoomView(region.Min, region.Max - region.Min).ForEachTile([&regionTiles](const FIntVector& Location, const UDungeonTile* Tile)
 		{
-			floor->SpawnRoomMeshes(FloorComponentLookup, CeilingComponentLookup, Rng);
+			regionTiles.Add(Tile);
+		});
+		CreateTileMeshActors(regionTiles);
+
+		if (Floors.IsValidIndex(z))
+		{
+			Floors[z]->RebuildDirtyRegion(region, FloorComponentLookup, CeilingComponentLookup, Rng);
 		}
 	}
 }
@@ -151,7 +255,7 @@ bool UDungeonSpaceGenerator::IsLocationValid(FIntVector FloorSpaceCoordinates)
 	{
 		return false;
 	}
-	FLowResDungeonFloor floor = DungeonSpace.GetLowRes(FloorSpaceCoordinates.Z);
+	const FLowResDungeonFloor& floor = DungeonSpace.GetLowRes(FloorSpaceCoordinates.Z);
 	return FloorSpaceCoordinates.X < floor.XSize() && FloorSpaceCoordinates.Y < floor.YSize();
 }
 
@@ -159,22 +263,15 @@ bool UDungeonSpaceGenerator::IsLocationValid(FIntVector FloorSpaceCoordinates)
 TArray<FFloorRoom> UDungeonSpaceGenerator::GetAllNeighbors(FFloorRoom Room)
 {
 	TArray<FFloorRoom> neighbors;
-	for (FIntVector neighbor : Room.NeighboringRooms)
-	{
-		if (!IsLocationValid(neighbor))
-		{
-			continue;
-		}
-		neighbors.Add(DungeonSpace.GetLowRes(neighbor.Z)[neighbor.Y][neighbor.X]);
-	}
-	for (FIntVector neighbor : Room.NeighboringTightlyCoupledRooms)
+	auto addNeighbor = [this, &neighbors](const FIntVector& Neighbor)
 	{
-		if (!IsLocationValid(neighbor))
+		if (IsLocationValid(Neighbor))
 		{
-			continue;
+			neighbors.Add(DungeonSpace.GetLowRes(Neighbor));
 		}
-		neighbors.Add(DungeonSpace.GetLowRes(neighbor.Z)[neighbor.Y][neighbor.X]);
-	}
+	};
+	Room.ForEachNeighbor(false, addNeighbor);
+	Room.ForEachNeighbor(true, addNeighbor);
 	return neighbors;
 }
 
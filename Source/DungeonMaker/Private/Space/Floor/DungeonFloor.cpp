@@ -4,8 +4,9 @@
 #include <DrawDebugHelpers.h>
 
 const float UDungeonTile::TILE_SIZE = 500.0f;
+TAtomic<int32> FDungeonFloorCopyCounter::CopyCount(0);
 
-void FLowResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset)
+void FLowResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset) const
 {
 	if (Context == NULL)
 	{
@@ -17,12 +18,13 @@ void FLowResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset)
 	{
 		for (int y = 0; y < YSize(); y++)
 		{
+			const FFloorRoom& room = Get(y).Get(x);
 			FColor randomColor = FColor::MakeRandomColor();
 
 			int32 xOffset = x;
 			int32 yOffset = y;
 
-			float offset = UDungeonTile::TILE_SIZE * DungeonRooms[y][x].MaxRoomSize;
+			float offset = UDungeonTile::TILE_SIZE * room.MaxRoomSize;
 
 			FVector startingLocation(xOffset * offset, yOffset * offset, ZOffset * offset);
 			FVector endingLocation(xOffset * offset, (yOffset + 1) * offset, ZOffset * offset);
@@ -38,32 +40,64 @@ void FLowResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset)
 
 			// Label the center with the type of tile this is
 			FVector midpoint((xOffset + 0.5f) * offset, (yOffset + 0.5f) * offset, (ZOffset * offset) + 100.0f);
-			TSubclassOf<ADungeonRoom> room = DungeonRooms[y][x].RoomClass;
-			if (room != NULL)
+			if (room.RoomClass != NULL)
 			{
-				FString symbolDescription = DungeonRooms[y][x].DungeonSymbol.GetSymbolDescription();
+				FString symbolDescription = room.DungeonSymbol.GetSymbolDescription();
 				symbolDescription += " (";
-				symbolDescription.AppendInt(DungeonRooms[y][x].DungeonSymbol.SymbolID);
+				symbolDescription.AppendInt(room.DungeonSymbol.SymbolID);
 				symbolDescription += ")";
 				DrawDebugString(Context->GetWorld(), midpoint, symbolDescription);
 			}
 
-			for (FIntVector neighborLocation : DungeonRooms[y][x].NeighboringRooms)
+			UWorld* world = Context->GetWorld();
+			room.ForEachNeighbor(false, [world, midpoint, offset, randomColor](const FIntVector& NeighborLocation)
 			{
-				FVector otherMidpoint = FVector((neighborLocation.X + 0.5f) * offset, (neighborLocation.Y + 0.5f) * offset, neighborLocation.Z * offset);
-				DrawDebugLine(Context->GetWorld(), midpoint, otherMidpoint, randomColor, true);
-			}
-			for (FIntVector neighborLocation : DungeonRooms[y][x].NeighboringTightlyCoupledRooms)
+				FVector otherMidpoint = FVector((NeighborLocation.X + 0.5f) * offset, (NeighborLocation.Y + 0.5f) * offset, NeighborLocation.Z * offset);
+				DrawDebugLine(world, midpoint, otherMidpoint, randomColor, true);
+			});
+			room.ForEachNeighbor(true, [world, midpoint, offset, randomColor](const FIntVector& NeighborLocation)
 			{
-				FVector otherMidpoint = FVector((neighborLocation.X + 0.5f) * offset, (neighborLocation.Y + 0.5f) * offset, neighborLocation.Z * offset);
-				DrawDebugLine(Context->GetWorld(), midpoint, otherMidpoint, randomColor, true);
-				DrawDebugLine(Context->GetWorld(), midpoint + FVector(0.0f, 0.0f, 50.0f), otherMidpoint + FVector(0.0f, 0.0f, 50.0f), randomColor, true);
-			}
+				FVector otherMidpoint = FVector((NeighborLocation.X + 0.5f) * offset, (NeighborLocation.Y + 0.5f) * offset, NeighborLocation.Z * offset);
+				DrawDebugLine(world, midpoint, otherMidpoint, randomColor, true);
+				DrawDebugLine(world, midpoint + FVector(0.0f, 0.0f, 50.0f), otherMidpoint + FVector(0.0f, 0.0f, 50.0f), randomColor, true);
+			});
 		}
 	}
 }
 
-void FHighResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset)
+// Draws a square around a single high-res tile, using one color per room.
+static void DrawDebugTile(UWorld* World, TMap<uint16, FColor>& RandomColorLookup, int32 X, int32 Y, int32 ZOffset, uint16 RoomIndex)
+{
+	FColor randomColor;
+	if (RandomColorLookup.Contains(RoomIndex))
+	{
+		randomColor = RandomColorLookup[RoomIndex];
+	}
+	else
+	{
+		randomColor = FColor::MakeRandomColor();
+		RandomColorLookup.Add(RoomIndex, randomColor);
+	}
+
+	int32 xOffset = X;
+	int32 yOffset = Y;
+
+	float offset = UDungeonTile::TILE_SIZE;
+
+	FVector startingLocation(xOffset * offset, yOffset * offset, ZOffset * offset);
+	FVector endingLocation(xOffset * offset, (yOffset + 1) * offset, ZOffset * offset);
+
+	// Draw a square
+	DrawDebugLine(World, startingLocation, endingLocation, randomColor, true);
+	endingLocation = FVector((xOffset + 1) * offset, yOffset * offset, ZOffset * offset);
+	DrawDebugLine(World, startingLocation, endingLocation, randomColor, true);
+	startingLocation = FVector((xOffset + 1) * offset, (yOffset + 1) * offset, ZOffset * offset);
+	DrawDebugLine(World, startingLocation, endingLocation, randomColor, true);
+	endingLocation = FVector(xOffset * offset, (yOffset + 1) * offset, ZOffset * offset);
+	DrawDebugLine(World, startingLocation, endingLocation, randomColor, true);
+}
+
+void FHighResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset) const
 {
 	if (Context == NULL)
 	{
@@ -71,193 +105,295 @@ void FHighResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset)
 		return;
 	}
 
-	TMap<FIntVector, FColor> randomColorLookup;
-	for (int x = 0; x < XSize(); x++)
+	TMap<uint16, FColor> randomColorLookup;
+	UWorld* world = Context->GetWorld();
+	ForEachTile([&randomColorLookup, world, ZOffset](int32 X, int32 Y, uint16 TileIndex, uint16 RoomIndex)
 	{
-		for (int y = 0; y < YSize(); y++)
+		if (RoomIndex == NO_ROOM)
+		{
+			return;
+		}
+		DrawDebugTile(world, randomColorLookup, X, Y, ZOffset, RoomIndex);
+	});
+}
+
+void FHighResDungeonFloor::DrawDungeonFloor(AActor* Context, int32 ZOffset, const FIntVector& Min, const FIntVector& Max) const
+{
+	if (Context == NULL)
+	{
+		UE_LOG(LogSpaceGen, Error, TEXT("Can't draw without a context actor provided!"));
+		return;
+	}
+
+	TMap<uint16, FColor> randomColorLookup;
+	UWorld* world = Context->GetWorld();
+	for (int y = FMath::Max(Min.Y, 0); y < FMath::Min(Max.Y, Height); y++)
+	{
+		for (int x = FMath::Max(Min.X, 0); x < FMath::Min(Max.X, Width); x++)
 		{
-			FRoomTile tile = Get(x, y);
-			if (tile.Tile == NULL)
+			uint16 roomIndex = GetRoomIndex(x, y);
+			if (roomIndex == NO_ROOM || GetTileIndex(x, y) == FDungeonTilePalette::EMPTY_TILE)
 			{
 				continue;
 			}
+			DrawDebugTile(world, randomColorLookup, x, y, ZOffset, roomIndex);
+		}
+	}
+}
 
-			FIntVector location = tile.RoomLocation;
-			if (location.X < 0 || location.Y < 0 || location.Z < 0)
+FString FHighResDungeonFloor::RoomToString(const TBitArray<>& RoomFilter, const FDungeonTilePalette& Palette) const
+{
+	FString output = "";
+	for (int y = 0; y < Height; y++)
+	{
+		FString rowOutput = "";
+		for (int x = 0; x < Width; x++)
+		{
+			if (!RoomFilter[GetRoomIndex(x, y)])
 			{
 				continue;
 			}
-			FColor randomColor;
-			if (randomColorLookup.Contains(location))
+			const UDungeonTile* tile = Palette.Get(GetTileIndex(x, y));
+			if (tile == NULL)
 			{
-				randomColor = randomColorLookup[location];
+				rowOutput += 'X';
 			}
 			else
 			{
-				randomColor = FColor::MakeRandomColor();
-				randomColorLookup.Add(location, randomColor);
+				rowOutput += tile->TileID.ToString();
 			}
+		}
 
-			int32 xOffset = x;
-			int32 yOffset = y;
-
-			float offset = UDungeonTile::TILE_SIZE;
-
-			FVector startingLocation(xOffset * offset, yOffset * offset, ZOffset * offset);
-			FVector endingLocation(xOffset * offset, (yOffset + 1) * offset, ZOffset * offset);
-
-			// Draw a square
-			DrawDebugLine(Context->GetWorld(), startingLocation, endingLocation, randomColor, true);
-			endingLocation = FVector((xOffset + 1) * offset, yOffset * offset, ZOffset * offset);
-			DrawDebugLine(Context->GetWorld(), startingLocation, endingLocation, randomColor, true);
-			startingLocation = FVector((xOffset + 1) * offset, (yOffset + 1) * offset, ZOffset * offset);
-			DrawDebugLine(Context->GetWorld(), startingLocation, endingLocation, randomColor, true);
-			endingLocation = FVector(xOffset * offset, (yOffset + 1) * offset, ZOffset * offset);
-			DrawDebugLine(Context->GetWorld(), startingLocation, endingLocation, randomColor, true);
+		if (rowOutput == "")
+		{
+			continue;
 		}
+		if (output != "")
+		{
+			output += "\n";
+		}
+		output += rowOutput;
 	}
+	return output;
 }
 
-FString FHighResDungeonFloor::RoomToString(ADungeonRoom* Room, TArray<FLowResDungeonFloor> LowResFloors)
+FString FHighResDungeonFloor::ToString(const FDungeonTilePalette& Palette) const
 {
-	if (Room == NULL)
+	FString output;
+	for (int y = 0; y < Height; y++)
 	{
-		UE_LOG(LogSpaceGen, Warning, TEXT("Did not specify room to create string from!"));
-		return "Not a valid room!";
-	}
-
-	FString output = "";
-	FString lastOutput = "";
-	for (int i = 0; i < Rows.Num(); i++)
-	{
-		if (lastOutput != "")
+		if (y > 0)
 		{
 			output += "\n";
 		}
-		lastOutput = Rows[i].RoomToString(Room, LowResFloors);
-		output += lastOutput;
-	}
-	if (output == "")
-	{
-		UE_LOG(LogSpaceGen, Warning, TEXT("Could not find room %s in dungeon."), *Room->GetName());
-		output = "Room not found!";
+		for (int x = 0; x < Width; x++)
+		{
+			const UDungeonTile* tile = Palette.Get(GetTileIndex(x, y));
+			if (tile == NULL)
+			{
+				output += 'X';
+			}
+			else
+			{
+				output += tile->TileID.ToString();
+			}
+		}
 	}
 	return output;
 }
 
-FString FDungeonSpace::RoomToString(ADungeonRoom* Room)
+TBitArray<> FDungeonSpace::CreateRoomFilter(int32 Z, const ADungeonRoom* Room) const
 {
-	if (Room == NULL)
+	const FLowResDungeonFloor& lowResFloor = LowResFloors[Z];
+	const FHighResDungeonFloor& highResFloor = HighResFloors[Z];
+
+	// Index 0 is FHighResDungeonFloor::NO_ROOM, which is never accepted
+	TBitArray<> filter(false, highResFloor.RoomCount() + 1);
+	for (int y = 0; y < lowResFloor.YSize(); y++)
 	{
-		return "No room specified!";
+		for (int x = 0; x < lowResFloor.XSize(); x++)
+		{
+			if (Room == NULL || lowResFloor.Get(y).Get(x).SpawnedRoom == Room)
+			{
+				filter[highResFloor.ToRoomIndex(x, y)] = true;
+			}
+		}
 	}
-	return HighResFloors[Room->GetRoomLocation().Z].RoomToString(Room, LowResFloors);
+	return filter;
 }
 
-TSet<const UDungeonTile*> FHighResDungeonFloorRow::FindAllTiles(TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room /*= NULL*/)
+void FDungeonSpace::RebuildTileIndex()
 {
-	TSet<const UDungeonTile*> tiles;
-	for (int i = 0; i < DungeonTiles.Num(); i++)
+	TileCounts.Reset(HighResFloors);
+	FloorBitplanes.SetNum(HighResFloors.Num());
+	for (int z = 0; z < HighResFloors.Num(); z++)
 	{
-		FIntVector roomSpace = DungeonTiles[i].RoomLocation;
-		if (roomSpace.X < 0 || roomSpace.Y < 0 || roomSpace.Z < 0)
+		const FHighResDungeonFloor& floor = HighResFloors[z];
+		FDungeonFloorBitplanes& bitplanes = FloorBitplanes[z];
+		if (bitplanes.Occupied.XSize() != floor.XSize() || bitplanes.Occupied.YSize() != floor.YSize())
 		{
-			continue;
+			bitplanes = FDungeonFloorBitplanes(floor.XSize(), floor.YSize());
 		}
-		if (Room != NULL && LowResFloors[roomSpace.Z].Get(roomSpace.Y).Get(roomSpace.X).SpawnedRoom != Room)
+		else
 		{
-			continue;
+			bitplanes.Reset();
 		}
-		if (DungeonTiles[i].Tile != NULL)
+
+		floor.ForEachTile([this, z, &bitplanes](int32 X, int32 Y, uint16 TileIndex, uint16 RoomIndex)
 		{
-			tiles.Add(DungeonTiles[i].Tile);
-		}
+			TileCounts.Add(z, RoomIndex, TileIndex);
+			bitplanes.SetTile(X, Y, TilePalette.Get(TileIndex), RoomIndex != FHighResDungeonFloor::NO_ROOM);
+		});
 	}
-	return tiles;
+	ClearDirtyRegions();
 }
 
-TSet<FIntVector> FHighResDungeonFloorRow::GetTileLocations(const ETileType& TileType, int32 Y, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room /*= NULL*/)
+TArray<FDungeonDirtyRegion> FDungeonSpace::ConsumeDirtyRegions()
 {
-	TSet<FIntVector> locations;
-	for (int x = 0; x < DungeonTiles.Num(); x++)
+	TArray<FDungeonDirtyRegion> regions;
+	for (int z = 0; z < DirtyChunks.Num(); z++)
 	{
-		FIntVector roomSpace = DungeonTiles[x].RoomLocation;
-		if (roomSpace.X < 0 || roomSpace.Y < 0 || roomSpace.Z < 0)
+		FDungeonBitplane& chunks = DirtyChunks[z];
+		const FHighResDungeonFloor& floor = HighResFloors[z];
+		for (int y = 0; y < chunks.YSize(); y++)
 		{
-			continue;
+			// Each run of dirty chunks on a row becomes one region
+			int32 x = chunks.FindNextSetBit(0, y);
+			while (x < chunks.XSize())
+			{
+				int32 spanEnd = chunks.FindSpanEnd(x, y);
+				FIntVector min(x * DIRTY_CHUNK_SIZE, y * DIRTY_CHUNK_SIZE, z);
+				FIntVector max(FMath::Min(spanEnd * DIRTY_CHUNK_SIZE, floor.XSize()), FMath::Min((y + 1) * DIRTY_CHUNK_SIZE, floor.YSize()), z + 1);
+				regions.Add(FDungeonDirtyRegion(min, max));
+				x = chunks.FindNextSetBit(spanEnd, y);
+			}
 		}
-		if (Room != NULL && Room != LowResFloors[roomSpace.Z].Get(roomSpace.Y).Get(roomSpace.X).SpawnedRoom)
+		chunks.Reset();
+	}
+	return regions;
+}
+
+void FDungeonSpace::RollbackToSavepoint(int32 Savepoint)
+{
+	checkf(Savepoint >= 0 && Savepoint <= Journal.Num(), TEXT("Invalid savepoint %d; the journal only has %d entries!"), Savepoint, Journal.Num());
+
+	// Don't journal the writes that undo the journal
+	bool bWasJournaling = bIsJournaling;
+	bIsJournaling = false;
+	for (int i = Journal.Num() - 1; i >= Savepoint; i--)
+	{
+		FDungeonSpaceJournalEntry& entry = Journal[i];
+		switch (entry.WriteType)
 		{
-			continue;
+		case FDungeonSpaceJournalEntry::EWriteType::Room:
+			// Rooms are undone newest first, so this is always the last one
+			checkf(entry.OldRoomIndex == JournalRooms.Num() - 1, TEXT("Journaled room %d is out of order!"), entry.OldRoomIndex);
+			GetLowRes(entry.Location) = JournalRooms.Pop(false);
+			break;
+		case FDungeonSpaceJournalEntry::EWriteType::Neighbor:
+			GetLowRes(entry.Location).RemoveNeighbor(entry.Neighbor, false);
+			break;
+		case FDungeonSpaceJournalEntry::EWriteType::TightlyCoupledNeighbor:
+			GetLowRes(entry.Location).RemoveNeighbor(entry.Neighbor, true);
+			break;
+		case FDungeonSpaceJournalEntry::EWriteType::Tile:
+			WriteTileIndex(entry.Location, entry.OldTileIndex);
+			break;
 		}
-		if (DungeonTiles[x].Tile == NULL)
+	}
+	Journal.SetNum(Savepoint, false);
+	bIsJournaling = bWasJournaling;
+}
+
+void FDungeonSpace::ClearDirtyRegions()
+{
+	DirtyChunks.SetNum(HighResFloors.Num());
+	for (int z = 0; z < HighResFloors.Num(); z++)
+	{
+		int32 chunksX = FMath::DivideAndRoundUp(HighResFloors[z].XSize(), DIRTY_CHUNK_SIZE);
+		int32 chunksY = FMath::DivideAndRoundUp(HighResFloors[z].YSize(), DIRTY_CHUNK_SIZE);
+		if (DirtyChunks[z].XSize() != chunksX || DirtyChunks[z].YSize() != chunksY)
 		{
-			continue;
+			DirtyChunks[z] = FDungeonBitplane(chunksX, chunksY);
 		}
-		if (DungeonTiles[x].Tile->TileType == TileType)
+		else
 		{
-			locations.Add(FIntVector(x, Y, Z));
+			DirtyChunks[z].Reset();
 		}
 	}
-	return locations;
 }
 
-TSet<FIntVector> FHighResDungeonFloorRow::GetTileLocations(const UDungeonTile* Tile, int32 Y, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room /*= NULL*/)
+TSet<FIntVector> FDungeonSpace::GetTileLocations(const TBitArray<>& TileFilter, ADungeonRoom* Room /*= NULL*/) const
 {
 	TSet<FIntVector> locations;
-	for (int x = 0; x < DungeonTiles.Num(); x++)
+	for (int z = 0; z < HighResFloors.Num(); z++)
 	{
-		FIntVector roomSpace = DungeonTiles[x].RoomLocation;
-		if (roomSpace.X < 0 || roomSpace.Y < 0 || roomSpace.Z < 0)
+		const FHighResDungeonFloor& floor = HighResFloors[z];
+		TBitArray<> roomFilter = CreateRoomFilter(z, Room);
+		for (TConstSetBitIterator<> room(roomFilter); room; ++room)
 		{
-			continue;
-		}
-		if (Room != NULL && Room != LowResFloors[roomSpace.Z].Get(roomSpace.Y).Get(roomSpace.X).SpawnedRoom)
-		{
-			continue;
+			uint16 roomIndex = (uint16)room.GetIndex();
+			int32 tileCount = TileCounts.Num(z, roomIndex, TileFilter);
+			if (tileCount == 0)
+			{
+				continue;
+			}
+			// Only rooms which have a matching tile get scanned
+			locations.Reserve(locations.Num() + tileCount);
+			FIntVector roomLocation = floor.ToRoomLocation(roomIndex, z);
+			FRoomTileView roomTiles = GetRoomView(FIntVector(roomLocation.X * RoomSize, roomLocation.Y * RoomSize, z), FIntVector(RoomSize, RoomSize, 1));
+			roomTiles.AppendTileLocations(TileFilter, roomIndex, locations);
 		}
-		if (DungeonTiles[x].Tile == Tile)
+	}
+	return locations;
+}
+
+TSet<const UDungeonTile*> FDungeonSpace::FindAllTiles(ADungeonRoom* Room /*= NULL*/) const
+{
+	TSet<const UDungeonTile*> tiles;
+	for (int z = 0; z < HighResFloors.Num(); z++)
+	{
+		TBitArray<> roomFilter = CreateRoomFilter(z, Room);
+		for (TConstSetBitIterator<> room(roomFilter); room; ++room)
 		{
-			locations.Add(FIntVector(x, Y, Z));
+			for (int i = 1; i < TilePalette.Num(); i++)
+			{
+				if (TileCounts.Num(z, (uint16)room.GetIndex(), (uint16)i) > 0)
+				{
+					tiles.Add(TilePalette.Get((uint16)i));
+				}
+			}
 		}
 	}
-	return locations;
+	return tiles;
 }
 
-FString FHighResDungeonFloorRow::RoomToString(ADungeonRoom* Room, TArray<FLowResDungeonFloor> LowResFloors)
+FString FDungeonSpace::RoomToString(ADungeonRoom* Room) const
 {
 	if (Room == NULL)
 	{
-		UE_LOG(LogSpaceGen, Warning, TEXT("Did not specify room to create string from!"));
-		return "Not a valid room!";
+		return "No room specified!";
 	}
+	int32 z = Room->GetRoomLocation().Z;
 
-	FString output = "";
-	for (int i = 0; i < DungeonTiles.Num(); i++)
+	const FLowResDungeonFloor& lowResFloor = LowResFloors[z];
+	for (int y = 0; y < lowResFloor.YSize(); y++)
 	{
-		FIntVector roomSpace = DungeonTiles[i].RoomLocation;
-		if (roomSpace.X < 0 || roomSpace.Y < 0 || roomSpace.Z < 0)
-		{
-			continue;
-		}
-
-		ADungeonRoom* spawnedRoom = LowResFloors[roomSpace.Z].Get(roomSpace.Y).Get(roomSpace.X).SpawnedRoom;
-		if (spawnedRoom != Room)
+		for (int x = 0; x < lowResFloor.XSize(); x++)
 		{
-			if (spawnedRoom == NULL)
+			const FFloorRoom& room = lowResFloor.Get(y).Get(x);
+			if (room.MaxRoomSize > 0 && room.SpawnedRoom == NULL)
 			{
-				UE_LOG(LogSpaceGen, Warning, TEXT("Found an unspawned room at (%d, %d, %d)!"), roomSpace.X, roomSpace.Y, roomSpace.Z);
+				UE_LOG(LogSpaceGen, Warning, TEXT("Found an unspawned room at (%d, %d, %d)!"), x, y, z);
 			}
-			continue;
-		}
-		else if (DungeonTiles[i].Tile == NULL)
-		{
-			output += 'X';
-		}
-		else
-		{
-			output += DungeonTiles[i].Tile->TileID.ToString();
 		}
 	}
+
+	FString output = HighResFloors[z].RoomToString(CreateRoomFilter(z, Room), TilePalette);
+	if (output == "")
+	{
+		UE_LOG(LogSpaceGen, Warning, TEXT("Could not find room %s in dungeon."), *Room->GetName());
+		output = "Room not found!";
+	}
 	return output;
 }
@@ -13,11 +13,10 @@ FIntVector UDungeonFloorHelpers::GetRoomTileSpacePosition(ADungeonRoom* Room)
 	return Room->GetRoomLocation();
 }
 
-FRoomTile& UDungeonFloorHelpers::GetTileAtLocation(ADungeonRoom* Room, const FIntVector& Location)
+FRoomTile UDungeonFloorHelpers::GetTileAtLocation(ADungeonRoom* Room, const FIntVector& Location)
 {
 	check(Room != NULL);
-	FDungeonSpace& dungeonSpace = Room->GetDungeon();
-	return dungeonSpace.GetHighRes(Location.Z).Get(Location.X, Location.Y);
+	return Room->GetDungeon().GetRoomTile(Location);
 }
 
 TSet<FIntVector> UDungeonFloorHelpers::GetTileLocations(const UDungeonTile* Tile, ADungeonRoom* Room)
@@ -27,17 +26,23 @@ TSet<FIntVector> UDungeonFloorHelpers::GetTileLocations(const UDungeonTile* Tile
 		UE_LOG(LogSpaceGen, Error, TEXT("Did not specify room to get location of!"));
 		return TSet<FIntVector>();
 	}
-	return Room->GetDungeon().GetTileLocations(Tile, Room);
+	return Room->GetTileView().GetTileLocations(Tile);
 }
 
 FIntVector UDungeonFloorHelpers::FindTileInDirection(ADungeonRoom* Room, const FIntVector& StartingLocation, const FIntVector& SearchDirection, const UDungeonTile* TileToSearchFor)
 {
+	if (Room == NULL)
+	{
+		UE_LOG(LogSpaceGen, Error, TEXT("Did not specify room when searching for tile!"));
+		return FIntVector(-1, -1, -1);
+	}
+	FRoomTileView roomTiles = Room->GetTileView();
 	FIntVector location = FIntVector(StartingLocation);
 	const UDungeonTile* tile = NULL;
 
-	while (IsLocationInRoom(Room, location) && tile != TileToSearchFor)
+	while (roomTiles.Contains(location) && tile != TileToSearchFor)
 	{
-		tile = GetTileAtLocation(Room, location).Tile;
+		tile = roomTiles.GetTile(location);
 		location += SearchDirection;
 	}
 	if (tile == TileToSearchFor)
@@ -146,17 +151,17 @@ FTransform UDungeonFloorHelpers::FindTileTransform(ADungeonRoom* Room, const FIn
 	return tfm;
 }
 
-void UDungeonFloorHelpers::DrawDungeon(AActor* ContextObject, FDungeonSpace DungeonSpace)
+void UDungeonFloorHelpers::DrawDungeon(AActor* ContextObject, const FDungeonSpace& DungeonSpace)
 {
 	DungeonSpace.DrawDungeon(ContextObject);
 }
 
-FString UDungeonFloorHelpers::FloorToTileString(FDungeonSpace DungeonSpace, uint8 FloorNum)
+FString UDungeonFloorHelpers::FloorToTileString(const FDungeonSpace& DungeonSpace, uint8 FloorNum)
 {
-	return DungeonSpace.GetHighRes((int32)FloorNum).ToString();
+	return DungeonSpace.FloorToString((int32)FloorNum);
 }
 
-FString UDungeonFloorHelpers::RoomToTileString(FDungeonSpace DungeonSpace, ADungeonRoom* Room)
+FString UDungeonFloorHelpers::RoomToTileString(const FDungeonSpace& DungeonSpace, ADungeonRoom* Room)
 {
 	return DungeonSpace.RoomToString(Room);
 }
@@ -264,3 +269,23 @@ bool UDungeonFloorHelpers::AreFloorRoomsAdjacent(const FFloorRoom& First, const
 		distance.X == 0 && distance.Y == 1 && distance.Z == 0 ||
 		distance.X == 0 && distance.Y == 0 && distance.Z == 1;
 }
+
+TSet<FIntVector> UDungeonFloorHelpers::GetNeighboringRooms(const FFloorRoom& Room)
+{
+	return Room.GetNeighbors(false);
+}
+
+TSet<FIntVector> UDungeonFloorHelpers::GetNeighboringTightlyCoupledRooms(const FFloorRoom& Room)
+{
+	return Room.GetNeighbors(true);
+}
+
+TSet<FIntVector> UDungeonFloorHelpers::GetOutgoingRooms(const FFloorRoom& Room)
+{
+	return Room.GetOutgoingRooms();
+}
+
+FIntVector UDungeonFloorHelpers::GetIncomingRoom(const FFloorRoom& Room)
+{
+	return Room.GetIncomingRoom();
+}
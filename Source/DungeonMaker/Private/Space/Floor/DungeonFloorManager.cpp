@@ -67,10 +67,55 @@ void UDungeonFloorManager::CreateRoomTiles(FRandomStream& Rng, const FGroundScat
 	DoFloorWideTileReplacement(PostGenerationRoomReplacementPhases, Rng);
 }
 
+void UDungeonFloorManager::RestoreRooms(const TMap<FIntVector, FIntVector>& RoomTileSizes, FRandomStream& Rng,
+	const FGroundScatterPairing& GlobalGroundScatter)
+{
+	FLowResDungeonFloor& floor = DungeonSpaceGenerator->DungeonSpace.GetLowRes(DungeonLevel);
+	for (int x = 0; x < floor.XSize(); x++)
+	{
+		for (int y = 0; y < floor.YSize(); y++)
+		{
+			const FFloorRoom& room = floor[y][x];
+			if (room.RoomClass == NULL)
+			{
+				// This room is empty
+				continue;
+			}
+			if (room.DungeonSymbol.Symbol == NULL)
+			{
+				UE_LOG(LogSpaceGen, Error, TEXT("Saved room at %s had no symbol!"), *room.Location.ToString());
+				continue;
+			}
+			const FIntVector* tileSize = RoomTileSizes.Find(FIntVector(x, y, DungeonLevel));
+			if (tileSize == NULL || *tileSize == FIntVector::ZeroValue)
+			{
+				// The room was never spawned when the dungeon was saved
+				continue;
+			}
+			floor[y][x].SpawnedRoom = SpawnRoom(room, room.RoomClass, *tileSize, false, Rng, GlobalGroundScatter);
+		}
+	}
+}
+
+void UDungeonFloorManager::RestoreRoomInterfaces(FRandomStream& Rng)
+{
+	FLowResDungeonFloor& floor = DungeonSpaceGenerator->DungeonSpace.GetLowRes(DungeonLevel);
+	for (int x = 0; x < floor.XSize(); x++)
+	{
+		for (int y = 0; y < floor.YSize(); y++)
+		{
+			if (floor[y][x].SpawnedRoom == NULL)
+			{
+				continue;
+			}
+			floor[y][x].SpawnedRoom->RestoreRoom(Rng);
+		}
+	}
+}
+
 void UDungeonFloorManager::DrawDebugSpace()
 {
-	FLowResDungeonFloor floor = GetDungeonFloor();
-	floor.DrawDungeonFloor(GetOwner(), DungeonLevel);
+	GetDungeonFloor().DrawDungeonFloor(GetOwner(), DungeonLevel);
 }
 
 const UDungeonTile* UDungeonFloorManager::GetTileFromTileSpace(FIntVector TileSpaceLocation)
@@ -80,6 +125,7 @@ const UDungeonTile* UDungeonFloorManager::GetTileFromTileSpace(FIntVector TileSp
 
 void UDungeonFloorManager::UpdateTileFromTileSpace(FIntVector TileSpaceLocation, const UDungeonTile* NewTile)
 {
+	// Meshes get rebuilt for this tile the next time the space generator rebuilds its dirty regions
 	DungeonSpaceGenerator->SetTile(TileSpaceLocation, NewTile);
 }
 
@@ -110,6 +156,64 @@ void UDungeonFloorManager::SpawnRoomMeshes(TMap<const UDungeonTile*, ASpaceMeshA
 	}
 }
 
+void UDungeonFloorManager::RebuildDirtyRegion(const FDungeonDirtyRegion& Region,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
+	FRandomStream& Rng)
+{
+	const FLowResDungeonFloor& floor = GetDungeonFloor();
+	// Only look at the cells the region could possibly overlap
+	int32 minX = FMath::Max(Region.Min.X / RoomSize, 0);
+	int32 minY = FMath::Max(Region.Min.Y / RoomSize, 0);
+	int32 maxX = FMath::Min(FMath::DivideAndRoundUp(Region.Max.X, RoomSize), floor.XSize());
+	int32 maxY = FMath::Min(FMath::DivideAndRoundUp(Region.Max.Y, RoomSize), floor.YSize());
+	for (int x = minX; x < maxX; x++)
+	{
+		for (int y = minY; y < maxY; y++)
+		{
+			// Rebuild the whole cell, not just the room in it, so hallways and
+			// other tiles outside of the room itself get rebuilt as well
+			ADungeonRoom* room = FindRoomForCell(x, y);
+			if (room == NULL)
+			{
+				// No rooms on this floor at all
+				return;
+			}
+			FIntVector cellMin(FMath::Max(Region.Min.X, x * RoomSize), FMath::Max(Region.Min.Y, y * RoomSize), DungeonLevel);
+			FIntVector cellMax(FMath::Min(Region.Max.X, (x + 1) * RoomSize), FMath::Min(Region.Max.Y, (y + 1) * RoomSize), DungeonLevel);
+			room->GetMeshComponent()->RebuildRoomTiles(cellMin, cellMax, FloorComponentLookup, CeilingComponentLookup, Rng);
+		}
+	}
+}
+
+ADungeonRoom* UDungeonFloorManager::FindRoomForCell(int32 X, int32 Y) const
+{
+	const FLowResDungeonFloor& floor = GetDungeonFloor();
+	if (floor.Get(Y).Get(X).SpawnedRoom != NULL)
+	{
+		return floor.Get(Y).Get(X).SpawnedRoom;
+	}
+
+	// Tiles outside of any room are handed to the closest room, so they
+	// always end up being placed by the same room
+	ADungeonRoom* closestRoom = NULL;
+	int32 closestDistance = MAX_int32;
+	for (int x = 0; x < floor.XSize(); x++)
+	{
+		for (int y = 0; y < floor.YSize(); y++)
+		{
+			ADungeonRoom* room = floor.Get(y).Get(x).SpawnedRoom;
+			int32 distance = FMath::Abs(x - X) + FMath::Abs(y - Y);
+			if (room != NULL && distance < closestDistance)
+			{
+				closestRoom = room;
+				closestDistance = distance;
+			}
+		}
+	}
+	return closestRoom;
+}
+
 int UDungeonFloorManager::XSize() const
 {
 	return GetDungeonFloor().XSize() * RoomSize;
@@ -125,7 +229,7 @@ TSet<FIntVector> UDungeonFloorManager::GetAllTilesOfType(ETileType Type)
 	return DungeonSpaceGenerator->DungeonSpace.GetTileLocations(Type);
 }
 
-FFloorRoom UDungeonFloorManager::GetRoomFromTileSpace(const FIntVector& TileSpaceLocation)
+const FFloorRoom& UDungeonFloorManager::GetRoomFromTileSpace(const FIntVector& TileSpaceLocation)
 {
 	return DungeonSpaceGenerator->GetRoomFromTileSpace(TileSpaceLocation);
 }
@@ -161,7 +265,18 @@ ADungeonRoom* UDungeonFloorManager::CreateRoom(const FFloorRoom& Room, FRandomSt
 	}
 #endif
 
-	ADungeonRoom* room = (ADungeonRoom*)GetWorld()->SpawnActor(symbol->GetRoomType(Rng));
+	return SpawnRoom(Room, symbol->GetRoomType(Rng), FIntVector(RoomSize, RoomSize, 1), true, Rng, GlobalGroundScatter);
+}
+
+ADungeonRoom* UDungeonFloorManager::SpawnRoom(const FFloorRoom& Room, TSubclassOf<ADungeonRoom> RoomClass, const FIntVector& RoomDimensions,
+	bool bAllowRandomSize, FRandomStream& Rng, const FGroundScatterPairing& GlobalGroundScatter)
+{
+	FString roomName = Room.DungeonSymbol.GetSymbolDescription();
+	roomName.Append(" (");
+	roomName.AppendInt(Room.DungeonSymbol.SymbolID);
+	roomName.AppendChar(')');
+
+	ADungeonRoom* room = (ADungeonRoom*)GetWorld()->SpawnActor(RoomClass);
 	if (room == NULL)
 	{
 		UE_LOG(LogSpaceGen, Error, TEXT("Could not spawn %s!"), *roomName);
@@ -173,6 +288,10 @@ ADungeonRoom* UDungeonFloorManager::CreateRoom(const FFloorRoom& Room, FRandomSt
 	room->Rename(*roomName);
 
 	room->GetGroundScatter()->GroundScatter.CombinePairings(GlobalGroundScatter);
+	if (!bAllowRandomSize)
+	{
+		room->bRoomShouldBeRandomlySized = false;
+	}
 
 	FIntVector roomLocation = Room.Location * RoomSize;
 	roomLocation.Z = Room.Location.Z;
@@ -180,7 +299,7 @@ ADungeonRoom* UDungeonFloorManager::CreateRoom(const FFloorRoom& Room, FRandomSt
 	UE_LOG(LogSpaceGen, Log, TEXT("Spawned in room for %s."), *roomName);
 
 	room->InitializeRoom(DungeonSpaceGenerator, this, DefaultFloorTile, DefaultWallTile, DefaultEntranceTile, DefaultExitTile,
-		FIntVector(RoomSize, RoomSize, 1), roomLocation, Room, Rng);
+		RoomDimensions, roomLocation, Room, Rng);
 
 	if (room->IsChangedAtRuntime())
 	{
@@ -190,7 +309,7 @@ ADungeonRoom* UDungeonFloorManager::CreateRoom(const FFloorRoom& Room, FRandomSt
 	return room;
 }
 
-FLowResDungeonFloor UDungeonFloorManager::GetDungeonFloor() const
+const FLowResDungeonFloor& UDungeonFloorManager::GetDungeonFloor() const
 {
 	return DungeonSpaceGenerator->DungeonSpace.GetLowRes(DungeonLevel);
 }
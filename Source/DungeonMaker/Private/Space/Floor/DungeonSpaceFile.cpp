@@ -0,0 +1,500 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "DungeonSpaceFile.h"
+#include "DungeonRoom.h"
+#include "Async/MappedFileHandle.h"
+#include "HAL/PlatformFilemanager.h"
+#include "Misc/FileHelper.h"
+
+// The file is read in place, so it has to match the in-memory layout exactly
+static_assert(PLATFORM_LITTLE_ENDIAN, "Dungeon files are little-endian and can't be mapped on big-endian platforms!");
+static_assert(sizeof(FDungeonSpaceFileHeader) % 4 == 0, "Dungeon file header must stay 4-byte aligned!");
+static_assert(sizeof(FDungeonSpaceFileFloor) % 4 == 0, "Dungeon file floor records must stay 4-byte aligned!");
+static_assert(sizeof(FDungeonSpaceFileRoom) % 4 == 0, "Dungeon file room records must stay 4-byte aligned!");
+static_assert(sizeof(FDungeonSpaceFileNeighbor) % 4 == 0, "Dungeon file neighbor records must stay 4-byte aligned!");
+
+namespace
+{
+	// Collects the object paths referenced by a dungeon file, storing each one only once.
+	struct FDungeonSpaceFileStrings
+	{
+		TArray<FString> Strings;
+		TMap<FString, uint32> Indices;
+
+		uint32 Add(const UObject* Object)
+		{
+			if (Object == NULL)
+			{
+				return FDungeonSpaceFileHeader::NO_STRING;
+			}
+			FString path = Object->GetPathName();
+			const uint32* existingIndex = Indices.Find(path);
+			if (existingIndex != NULL)
+			{
+				return *existingIndex;
+			}
+			uint32 index = (uint32)Strings.Add(path);
+			Indices.Add(path, index);
+			return index;
+		}
+	};
+
+	// Appends raw bytes, padding the end so the next block stays aligned.
+	// Returns the offset the bytes were written at.
+	uint32 AppendBytes(TArray<uint8>& Data, const void* Bytes, int32 Count)
+	{
+		uint32 offset = (uint32)Data.Num();
+		Data.Append((const uint8*)Bytes, Count);
+		Data.AddZeroed(Align(Data.Num(), 4) - Data.Num());
+		return offset;
+	}
+
+	template<typename T>
+	uint32 AppendArray(TArray<uint8>& Data, const TArray<T>& Array)
+	{
+		return AppendBytes(Data, Array.GetData(), Array.Num() * sizeof(T));
+	}
+
+	bool IsValidStringIndex(const FDungeonSpaceFileHeader& Header, uint32 Index)
+	{
+		return Index == FDungeonSpaceFileHeader::NO_STRING || Index < Header.StringCount;
+	}
+}
+
+bool FDungeonSpaceFileView::Validate(FString& OutError) const
+{
+	if (Data == NULL || Size < (int64)sizeof(FDungeonSpaceFileHeader))
+	{
+		OutError = TEXT("File is too small to be a dungeon.");
+		return false;
+	}
+	if ((UPTRINT)Data % 4 != 0)
+	{
+		OutError = TEXT("File data is not aligned.");
+		return false;
+	}
+
+	const FDungeonSpaceFileHeader& header = GetHeader();
+	if (header.Magic != FDungeonSpaceFile::MAGIC)
+	{
+		OutError = TEXT("File is not a dungeon.");
+		return false;
+	}
+	if (header.Version != FDungeonSpaceFile::VERSION)
+	{
+		OutError = FString::Printf(TEXT("File is version %u, but only version %u is supported."), header.Version, FDungeonSpaceFile::VERSION);
+		return false;
+	}
+	if ((int64)header.FileSize != Size)
+	{
+		OutError = FString::Printf(TEXT("File should be %u bytes, but was %lld bytes."), header.FileSize, Size);
+		return false;
+	}
+	if (header.RoomSize <= 0 || header.RoomSize > FDungeonSpaceFile::MAX_ROOM_SIZE)
+	{
+		OutError = TEXT("File has an invalid room size.");
+		return false;
+	}
+	if (!IsValidRange(header.StringOffset, header.StringCount, sizeof(uint32)) ||
+		!IsValidRange(header.PaletteOffset, header.PaletteCount, sizeof(uint32)) ||
+		!IsValidRange(header.FloorOffset, header.FloorCount, sizeof(FDungeonSpaceFileFloor)) ||
+		!IsValidRange(header.RoomOffset, header.RoomCount, sizeof(FDungeonSpaceFileRoom)) ||
+		!IsValidRange(header.NeighborOffset, header.NeighborCount, sizeof(FDungeonSpaceFileNeighbor)))
+	{
+		OutError = TEXT("File has a table which runs past the end of the file.");
+		return false;
+	}
+
+	// Every string has to be terminated before the end of the file
+	for (uint32 i = 0; i < header.StringCount; i++)
+	{
+		int64 offset = GetAt<uint32>(header.StringOffset)[i];
+		while (offset < Size && Data[offset] != 0)
+		{
+			offset++;
+		}
+		if (offset >= Size)
+		{
+			OutError = FString::Printf(TEXT("String %u runs past the end of the file."), i);
+			return false;
+		}
+	}
+
+	if (header.PaletteCount == 0 || header.PaletteCount > (uint32)MAX_uint16 + 1 || GetPaletteEntry(0) != FDungeonSpaceFileHeader::NO_STRING)
+	{
+		OutError = TEXT("File has an invalid tile palette.");
+		return false;
+	}
+	for (uint32 i = 1; i < header.PaletteCount; i++)
+	{
+		if (GetPaletteEntry(i) >= header.StringCount)
+		{
+			OutError = FString::Printf(TEXT("Palette entry %u does not reference a tile."), i);
+			return false;
+		}
+	}
+
+	for (uint32 z = 0; z < header.FloorCount; z++)
+	{
+		const FDungeonSpaceFileFloor& floor = GetFloor(z);
+		// Sizes come straight from the file, so they're range checked before anything gets multiplied
+		if (floor.LowResXSize <= 0 || floor.LowResXSize > FDungeonSpaceFile::MAX_FLOOR_SIZE || floor.LowResXSize != floor.LowResYSize ||
+			(int64)floor.HighResXSize != (int64)floor.LowResXSize * header.RoomSize ||
+			(int64)floor.HighResYSize != (int64)floor.LowResYSize * header.RoomSize)
+		{
+			OutError = FString::Printf(TEXT("Floor %u has invalid dimensions."), z);
+			return false;
+		}
+		int64 tileCount = (int64)floor.HighResXSize * floor.HighResYSize;
+		if (!IsValidRange(floor.TileOffset, tileCount, sizeof(uint16)) || (int64)floor.FirstRoom + floor.RoomCount > header.RoomCount)
+		{
+			OutError = FString::Printf(TEXT("Floor %u runs past the end of the file."), z);
+			return false;
+		}
+		const uint16* tiles = GetTileIndices(floor);
+		for (int64 i = 0; i < tileCount; i++)
+		{
+			if (tiles[i] >= header.PaletteCount)
+			{
+				OutError = FString::Printf(TEXT("Floor %u has a tile which is not in the palette."), z);
+				return false;
+			}
+		}
+		for (uint32 i = floor.FirstRoom; i < floor.FirstRoom + floor.RoomCount; i++)
+		{
+			const FDungeonSpaceFileRoom& room = GetRoom(i);
+			if (room.Location.Z != (int32)z || !IsValidRoomLocation(room.Location))
+			{
+				OutError = FString::Printf(TEXT("Room %u is outside of floor %u."), i, z);
+				return false;
+			}
+			if (!IsValidStringIndex(header, room.RoomClass) || !IsValidStringIndex(header, room.Symbol))
+			{
+				OutError = FString::Printf(TEXT("Room %u references a string which does not exist."), i);
+				return false;
+			}
+			if (room.IncomingRoom != FIntVector(-1, -1, -1) && !IsValidRoomLocation(room.IncomingRoom))
+			{
+				OutError = FString::Printf(TEXT("Room %u has an incoming room outside of the dungeon."), i);
+				return false;
+			}
+			if ((int64)room.FirstNeighbor + room.NeighborCount + room.TightlyCoupledNeighborCount > header.NeighborCount)
+			{
+				OutError = FString::Printf(TEXT("Room %u has neighbors past the end of the file."), i);
+				return false;
+			}
+			for (uint32 n = room.FirstNeighbor; n < room.FirstNeighbor + room.NeighborCount + room.TightlyCoupledNeighborCount; n++)
+			{
+				if (!IsValidRoomLocation(GetNeighbor(n).Location))
+				{
+					OutError = FString::Printf(TEXT("Room %u has a neighbor outside of the dungeon."), i);
+					return false;
+				}
+			}
+		}
+	}
+	return true;
+}
+
+bool FDungeonSpaceFileView::IsValidRoomLocation(const FIntVector& Location) const
+{
+	if (Location.Z < 0 || (uint32)Location.Z >= GetHeader().FloorCount)
+	{
+		return false;
+	}
+	const FDungeonSpaceFileFloor& floor = GetFloor(Location.Z);
+	return Location.X >= 0 && Location.Y >= 0 && Location.X < floor.LowResXSize && Location.Y < floor.LowResYSize;
+}
+
+FString FDungeonSpaceFileView::GetString(uint32 Index) const
+{
+	if (Index == FDungeonSpaceFileHeader::NO_STRING)
+	{
+		return FString();
+	}
+	check(Index < GetHeader().StringCount);
+	const ANSICHAR* utf8 = GetAt<ANSICHAR>(GetAt<uint32>(GetHeader().StringOffset)[Index]);
+	return FString(UTF8_TO_TCHAR(utf8));
+}
+
+FDungeonSpaceFileReader::FDungeonSpaceFileReader()
+{
+}
+
+FDungeonSpaceFileReader::~FDungeonSpaceFileReader()
+{
+	// The region has to be unmapped before the file it came from is closed
+	MappedRegion.Reset();
+	MappedFile.Reset();
+}
+
+bool FDungeonSpaceFileReader::Open(const FString& FilePath)
+{
+	View = FDungeonSpaceFileView();
+	MappedRegion.Reset();
+	MappedFile.Reset();
+	Buffer.Empty();
+
+	IPlatformFile& platformFile = FPlatformFileManager::Get().GetPlatformFile();
+	MappedFile.Reset(platformFile.OpenMapped(*FilePath));
+	if (MappedFile.IsValid())
+	{
+		MappedRegion.Reset(MappedFile->MapRegion());
+		if (MappedRegion.IsValid())
+		{
+			View = FDungeonSpaceFileView(MappedRegion->GetMappedPtr(), MappedRegion->GetMappedSize());
+			return true;
+		}
+		MappedFile.Reset();
+	}
+
+	// Not every platform can map files, so read the whole thing in instead
+	if (!FFileHelper::LoadFileToArray(Buffer, *FilePath, FILEREAD_Silent))
+	{
+		return false;
+	}
+	View = FDungeonSpaceFileView(Buffer.GetData(), Buffer.Num());
+	return true;
+}
+
+void FDungeonSpaceFile::Write(const FDungeonSpace& DungeonSpace, TArray<uint8>& OutData)
+{
+	FDungeonSpaceFileStrings strings;
+
+	const FDungeonTilePalette& tilePalette = DungeonSpace.GetTilePalette();
+	TArray<uint32> palette;
+	palette.SetNumUninitialized(tilePalette.Num());
+	for (int i = 0; i < tilePalette.Num(); i++)
+	{
+		palette[i] = strings.Add(tilePalette.Get(i));
+	}
+
+	TArray<FDungeonSpaceFileFloor> floors;
+	TArray<FDungeonSpaceFileRoom> rooms;
+	TArray<FDungeonSpaceFileNeighbor> neighbors;
+	TArray<TArray<uint16>> floorTiles;
+	floors.SetNumZeroed(DungeonSpace.Num());
+	floorTiles.SetNum(DungeonSpace.Num());
+	for (int z = 0; z < DungeonSpace.Num(); z++)
+	{
+		const FLowResDungeonFloor& lowRes = DungeonSpace.GetLowRes(z);
+		const FHighResDungeonFloor& highRes = DungeonSpace.GetHighRes(z);
+		FDungeonSpaceFileFloor& floor = floors[z];
+		floor.LowResXSize = lowRes.XSize();
+		floor.LowResYSize = lowRes.YSize();
+		floor.HighResXSize = highRes.XSize();
+		floor.HighResYSize = highRes.YSize();
+		floor.FirstRoom = (uint32)rooms.Num();
+
+		for (int y = 0; y < lowRes.YSize(); y++)
+		{
+			for (int x = 0; x < lowRes.XSize(); x++)
+			{
+				const FFloorRoom& room = lowRes.Get(y).Get(x);
+				if (room.RoomClass == NULL && room.MaxRoomSize <= 0)
+				{
+					// Nothing was ever placed here
+					continue;
+				}
+				FDungeonSpaceFileRoom& record = rooms[rooms.AddZeroed()];
+				record.Location = FIntVector(x, y, z);
+				record.IncomingRoom = room.GetIncomingRoom();
+				record.MaxRoomSize = room.MaxRoomSize;
+				record.Difficulty = room.Difficulty;
+				if (room.SpawnedRoom != NULL)
+				{
+					// The symbol may have picked a different class than the one we planned for
+					record.RoomClass = strings.Add(room.SpawnedRoom->GetClass());
+					record.TileSize = room.SpawnedRoom->GetRoomSize();
+				}
+				else
+				{
+					record.RoomClass = strings.Add(room.RoomClass.Get());
+					record.TileSize = FIntVector::ZeroValue;
+				}
+				record.Symbol = strings.Add(room.DungeonSymbol.Symbol);
+				record.SymbolID = room.DungeonSymbol.SymbolID;
+
+				record.FirstNeighbor = (uint32)neighbors.Num();
+				record.NeighborCount = (uint32)room.NumNeighbors(false);
+				record.TightlyCoupledNeighborCount = (uint32)room.NumNeighbors(true);
+				auto addNeighbor = [&neighbors](const FIntVector& Neighbor)
+				{
+					neighbors[neighbors.AddZeroed()].Location = Neighbor;
+				};
+				room.ForEachNeighbor(false, addNeighbor);
+				room.ForEachNeighbor(true, addNeighbor);
+			}
+		}
+		floor.RoomCount = (uint32)rooms.Num() - floor.FirstRoom;
+
+		TArray<uint16>& tiles = floorTiles[z];
+		tiles.SetNumUninitialized(highRes.XSize() * highRes.YSize());
+		for (int y = 0; y < highRes.YSize(); y++)
+		{
+			for (int x = 0; x < highRes.XSize(); x++)
+			{
+				tiles[y * highRes.XSize() + x] = highRes.GetTileIndex(x, y);
+			}
+		}
+	}
+
+	FDungeonSpaceFileHeader header;
+	FMemory::Memzero(header);
+	header.Magic = MAGIC;
+	header.Version = VERSION;
+	header.RoomSize = floors.Num() > 0 && floors[0].LowResXSize > 0 ? floors[0].HighResXSize / floors[0].LowResXSize : 1;
+
+	OutData.Reset();
+	OutData.AddZeroed(sizeof(FDungeonSpaceFileHeader));
+
+	// String offsets come first, followed by the strings themselves
+	header.StringCount = (uint32)strings.Strings.Num();
+	header.StringOffset = (uint32)OutData.Num();
+	OutData.AddZeroed(strings.Strings.Num() * sizeof(uint32));
+	for (int i = 0; i < strings.Strings.Num(); i++)
+	{
+		FTCHARToUTF8 utf8(*strings.Strings[i]);
+		uint32 stringOffset = AppendBytes(OutData, utf8.Get(), utf8.Length() + 1);
+		FMemory::Memcpy(OutData.GetData() + header.StringOffset + i * sizeof(uint32), &stringOffset, sizeof(uint32));
+	}
+
+	header.PaletteCount = (uint32)palette.Num();
+	header.PaletteOffset = AppendArray(OutData, palette);
+
+	for (int z = 0; z < floors.Num(); z++)
+	{
+		floors[z].TileOffset = AppendArray(OutData, floorTiles[z]);
+	}
+	header.FloorCount = (uint32)floors.Num();
+	header.FloorOffset = AppendArray(OutData, floors);
+
+	header.RoomCount = (uint32)rooms.Num();
+	header.RoomOffset = AppendArray(OutData, rooms);
+
+	header.NeighborCount = (uint32)neighbors.Num();
+	header.NeighborOffset = AppendArray(OutData, neighbors);
+
+	header.FileSize = (uint32)OutData.Num();
+	FMemory::Memcpy(OutData.GetData(), &header, sizeof(FDungeonSpaceFileHeader));
+}
+
+bool FDungeonSpaceFile::SaveToFile(const FDungeonSpace& DungeonSpace, const FString& FilePath)
+{
+	TArray<uint8> data;
+	Write(DungeonSpace, data);
+	if (!FFileHelper::SaveArrayToFile(data, *FilePath))
+	{
+		UE_LOG(LogSpaceGen, Warning, TEXT("Could not save dungeon to %s."), *FilePath);
+		return false;
+	}
+	UE_LOG(LogSpaceGen, Log, TEXT("Saved dungeon to %s (%d bytes)."), *FilePath, data.Num());
+	return true;
+}
+
+bool FDungeonSpaceFile::ReadLayout(const FDungeonSpaceFileView& View, const UDungeonTile* DefaultTile, FDungeonSpace& OutDungeonSpace,
+	TMap<FIntVector, FIntVector>& OutRoomTileSizes)
+{
+	const FDungeonSpaceFileHeader& header = View.GetHeader();
+	TArray<int32> levelSizes;
+	levelSizes.SetNum(header.FloorCount);
+	for (int i = 0; i < levelSizes.Num(); i++)
+	{
+		levelSizes[i] = View.GetFloor(i).LowResXSize;
+	}
+	OutDungeonSpace = FDungeonSpace(levelSizes, header.RoomSize);
+	OutRoomTileSizes.Empty(header.RoomCount);
+
+	for (uint32 i = 0; i < header.RoomCount; i++)
+	{
+		const FDungeonSpaceFileRoom& record = View.GetRoom(i);
+		FFloorRoom room;
+		room.Location = record.Location;
+		room.SetIncomingRoom(record.IncomingRoom);
+		room.MaxRoomSize = record.MaxRoomSize;
+		room.Difficulty = record.Difficulty;
+
+		if (record.RoomClass != FDungeonSpaceFileHeader::NO_STRING)
+		{
+			FString classPath = View.GetString(record.RoomClass);
+			UClass* roomClass = LoadObject<UClass>(NULL, *classPath);
+			if (roomClass == NULL || !roomClass->IsChildOf(ADungeonRoom::StaticClass()))
+			{
+				UE_LOG(LogSpaceGen, Warning, TEXT("Could not load room class %s."), *classPath);
+				return false;
+			}
+			room.RoomClass = roomClass;
+		}
+		if (record.Symbol != FDungeonSpaceFileHeader::NO_STRING)
+		{
+			FString symbolPath = View.GetString(record.Symbol);
+			room.DungeonSymbol.Symbol = LoadObject<UGraphNode>(NULL, *symbolPath);
+			if (room.DungeonSymbol.Symbol == NULL)
+			{
+				UE_LOG(LogSpaceGen, Warning, TEXT("Could not load mission symbol %s."), *symbolPath);
+				return false;
+			}
+		}
+		room.DungeonSymbol.SymbolID = record.SymbolID;
+
+		for (uint32 n = 0; n < record.NeighborCount; n++)
+		{
+			room.AddNeighbor(View.GetNeighbor(record.FirstNeighbor + n).Location, false);
+		}
+		for (uint32 n = 0; n < record.TightlyCoupledNeighborCount; n++)
+		{
+			room.AddNeighbor(View.GetNeighbor(record.FirstNeighbor + record.NeighborCount + n).Location, true);
+		}
+
+		OutDungeonSpace.Set(room);
+		OutRoomTileSizes.Add(room.Location, record.TileSize);
+	}
+
+	OutDungeonSpace.CopyLosResToHighRes(DefaultTile);
+	return true;
+}
+
+bool FDungeonSpaceFile::ReadPalette(const FDungeonSpaceFileView& View, TArray<const UDungeonTile*>& OutPalette)
+{
+	const FDungeonSpaceFileHeader& header = View.GetHeader();
+	OutPalette.SetNumZeroed(header.PaletteCount);
+	for (uint32 i = 1; i < header.PaletteCount; i++)
+	{
+		FString tilePath = View.GetString(View.GetPaletteEntry(i));
+		OutPalette[i] = LoadObject<UDungeonTile>(NULL, *tilePath);
+		if (OutPalette[i] == NULL)
+		{
+			UE_LOG(LogSpaceGen, Warning, TEXT("Could not load tile %s."), *tilePath);
+			return false;
+		}
+	}
+	return true;
+}
+
+void FDungeonSpaceFile::ReadTiles(const FDungeonSpaceFileView& View, const TArray<const UDungeonTile*>& Palette, FDungeonSpace& DungeonSpace)
+{
+	for (int z = 0; z < DungeonSpace.Num(); z++)
+	{
+		const FDungeonSpaceFileFloor& floor = View.GetFloor(z);
+		const uint16* tiles = View.GetTileIndices(floor);
+		for (int y = 0; y < floor.HighResYSize; y++)
+		{
+			for (int x = 0; x < floor.HighResXSize; x++)
+			{
+				// Most of the dungeon is either empty or still the default tile, and
+				// writing those would allocate pages that were never needed
+				uint16 tileIndex = tiles[(int64)y * floor.HighResXSize + x];
+				if (tileIndex == FDungeonTilePalette::EMPTY_TILE)
+				{
+					continue;
+				}
+				FIntVector location(x, y, z);
+				if (DungeonSpace.GetTile(location) == Palette[tileIndex])
+				{
+					continue;
+				}
+				DungeonSpace.SetTile(location, Palette[tileIndex]);
+			}
+		}
+	}
+}
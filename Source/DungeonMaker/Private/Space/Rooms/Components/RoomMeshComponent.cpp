@@ -58,10 +58,53 @@ void URoomMeshComponent::PlaceTile(TMap<const UDungeonTile*, ASpaceMeshActor*>&
 	bHasPlacedMeshes = true;
 
 	FTransform objectTransform = CreateMeshTransform(MeshTransformOffset, Location);
-	ComponentLookup[Tile]->AddInstance(MeshID, objectTransform);
+	ASpaceMeshActor* meshActor = ComponentLookup[Tile];
+	int32 instanceIndex = meshActor->AddInstance(MeshID, objectTransform);
+
+	// Walls get stacked up above the tile, but they still belong to the tile on the room's floor
+	FIntVector tileLocation(Location.X, Location.Y, ParentRoom->GetRoomLocation().Z);
+	FPlacedTileInstance placedInstance;
+	placedInstance.MeshActor = meshActor;
+	placedInstance.MeshID = MeshID;
+	placedInstance.InstanceIndex = instanceIndex;
+	PlacedInstances.FindOrAdd(tileLocation).Add(placedInstance);
 }
 
-void URoomMeshComponent::CreateAllRoomTiles(TMap<const UDungeonTile*, TArray<FIntVector>>& TileLocations, TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup, TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup, FRandomStream& Rng)
+void URoomMeshComponent::ClearPlacedTiles(const FIntVector& Min, const FIntVector& Max)
+{
+	for (int y = Min.Y; y < Max.Y; y++)
+	{
+		for (int x = Min.X; x < Max.X; x++)
+		{
+			FIntVector location(x, y, Min.Z);
+			TArray<FPlacedTileInstance> instances;
+			if (PlacedInstances.RemoveAndCopyValue(location, instances))
+			{
+				for (const FPlacedTileInstance& instance : instances)
+				{
+					if (instance.MeshActor.IsValid())
+					{
+						instance.MeshActor->RemoveInstance(instance.MeshID, instance.InstanceIndex);
+					}
+				}
+			}
+
+			TArray<TWeakObjectPtr<AActor>> interactions;
+			if (SpawnedInteractions.RemoveAndCopyValue(location, interactions))
+			{
+				for (TWeakObjectPtr<AActor> interaction : interactions)
+				{
+					if (interaction.IsValid())
+					{
+						interaction->Destroy();
+					}
+				}
+			}
+		}
+	}
+}
+
+void URoomMeshComponent::CreateAllRoomTiles(const FRoomTileView& RoomTiles, TMap<const UDungeonTile*, TArray<FIntVector>>& TileLocations, TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup, TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup, FRandomStream& Rng)
 {
 	if (ParentRoom == NULL)
 	{
@@ -69,8 +112,7 @@ void URoomMeshComponent::CreateAllRoomTiles(TMap<const UDungeonTile*, TArray<FIn
 		return;
 	}
 
-	FDungeonSpace dungeon = GetDungeon();
-	TSet<FIntVector> entranceLocations = dungeon.GetTileLocations(ETileType::Entrance, ParentRoom);
+	TSet<FIntVector> entranceLocations = RoomTiles.GetTileLocations(ETileType::Entrance);
 	FIntVector roomSize = ParentRoom->GetRoomSize();
 
 	// Place tiles
@@ -131,17 +173,17 @@ void URoomMeshComponent::CreateAllRoomTiles(TMap<const UDungeonTile*, TArray<FIn
 	// Spawn walls up to the ceiling height
 	if (roomSize.Z > 1)
 	{
-		TSet<FIntVector> walls = dungeon.GetTileLocations(ETileType::Wall, ParentRoom);
-		walls.Append(dungeon.GetTileLocations(ETileType::Entrance, ParentRoom));
+		TSet<FIntVector> walls = RoomTiles.GetTileLocations(ETileType::Wall);
+		walls.Append(entranceLocations);
 		if (walls.Num() > 0)
 		{
 			// If we find more than 1 wall, grab the first wall we can
-			const UDungeonTile* wallTile = dungeon.GetTile(walls.Array()[0]);
+			const UDungeonTile* wallTile = RoomTiles.GetTile(walls.Array()[0]);
 			if (FloorComponentLookup.Contains(wallTile))
 			{
 				// Select the mesh associated with this wall
 				int32 meshSelection = FloorTileMeshSelections[wallTile];
-				TSet<FIntVector> wallLocations = dungeon.GetTileLocations(wallTile, ParentRoom);
+				TSet<FIntVector> wallLocations = RoomTiles.GetTileLocations(wallTile);
 				wallLocations.Append(entranceLocations.Array());
 				// Make walls go up to the ceiling
 				for (int i = 1; i < roomSize.Z; i++)
@@ -171,9 +213,17 @@ void URoomMeshComponent::SpawnInteractions(TMap<const UDungeonTile*, TArray<FInt
 		// Place tile interactions
 		for (auto& kvp : InteractionOptions)
 		{
+			if (!TileLocations.Contains(kvp.Key))
+			{
+				continue;
+			}
 			for (int i = 0; i < TileLocations[kvp.Key].Num(); i++)
 			{
-				SpawnInteraction(kvp.Key, kvp.Value, TileLocations[kvp.Key][i], Rng);
+				AActor* interaction = SpawnInteraction(kvp.Key, kvp.Value, TileLocations[kvp.Key][i], Rng);
+				if (interaction != NULL)
+				{
+					SpawnedInteractions.FindOrAdd(TileLocations[kvp.Key][i]).Add(interaction);
+				}
 			}
 		}
 #if !UE_BUILD_SHIPPING
@@ -197,66 +247,85 @@ void URoomMeshComponent::PlaceRoomTiles(TMap<const UDungeonTile*, ASpaceMeshActo
 		return;
 	}
 
-	FDungeonSpace& dungeon = ParentRoom->GetDungeon();
-	FIntVector roomLocation = ParentRoom->GetRoomLocation();
-	FIntVector roomSize = ParentRoom->GetRoomSize();
+	PlaceTilesInView(ParentRoom->GetTileView(), FloorComponentLookup, CeilingComponentLookup, Rng);
+}
+
+void URoomMeshComponent::RebuildRoomTiles(const FIntVector& Min, const FIntVector& Max,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup, FRandomStream& Rng)
+{
+	if (ParentRoom == NULL)
+	{
+		UE_LOG(LogSpaceGen, Error, TEXT("Mesh component did not have parent room defined!"));
+		return;
+	}
+
+	FIntVector rebuildMin(Min.X, Min.Y, ParentRoom->GetRoomLocation().Z);
+	FIntVector rebuildMax(Max.X, Max.Y, ParentRoom->GetRoomLocation().Z);
+	if (rebuildMin.X >= rebuildMax.X || rebuildMin.Y >= rebuildMax.Y)
+	{
+		return;
+	}
+
+	UE_LOG(LogSpaceGen, Verbose, TEXT("%s is rebuilding tiles from %s to %s."), *ParentRoom->GetName(), *rebuildMin.ToString(), *rebuildMax.ToString());
+	ClearPlacedTiles(rebuildMin, rebuildMax);
+	if (GroundScatter != NULL)
+	{
+		GroundScatter->ClearGroundScatter(rebuildMin, rebuildMax);
+	}
 
+	FIntVector rebuildSize = rebuildMax - rebuildMin;
+	rebuildSize.Z = 1;
+	PlaceTilesInView(GetDungeon().GetRoomView(rebuildMin, rebuildSize), FloorComponentLookup, CeilingComponentLookup, Rng);
+}
+
+void URoomMeshComponent::PlaceTilesInView(const FRoomTileView& RoomTiles,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+	TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup, FRandomStream& Rng)
+{
 	TMap<const UDungeonTile*, TArray<FIntVector>> tileLocations;
-	for (int x = roomLocation.X; x < roomLocation.X + roomSize.X; x++)
+	RoomTiles.ForEachTile([this, &tileLocations, &Rng](const FIntVector& Location, const UDungeonTile* Tile)
 	{
-		for (int y = roomLocation.Y; y < roomLocation.Y + roomSize.Y; y++)
-		{
-			// Cache this tile location
-			FIntVector location = FIntVector(x, y, roomLocation.Z);
-			const UDungeonTile* tile = dungeon.GetTile(location);
-			if (tile == NULL)
-			{
-				continue;
-			}
-			if (!tileLocations.Contains(tile))
-			{
-				tileLocations.Add(tile, TArray<FIntVector>());
-			}
-			tileLocations[tile].Add(location);
+		// Cache this tile location
+		tileLocations.FindOrAdd(Tile).Add(Location);
 
-			if (tile->bGroundMeshShouldAlwaysBeTheSame)
+		if (Tile->bGroundMeshShouldAlwaysBeTheSame)
+		{
+			// Determine what we should spawn on this tile later
+			if (Tile->GroundMesh.Num() > 0 && !FloorTileMeshSelections.Contains(Tile))
 			{
-				// Determine what we should spawn on this tile later
-				if (tile->GroundMesh.Num() > 0 && !FloorTileMeshSelections.Contains(tile))
+				int32 randomIndex;
+				do
 				{
-					int32 randomIndex;
-					do
-					{
-						randomIndex = Rng.RandRange(0, tile->GroundMesh.Num() - 1);
-					} while (tile->GroundMesh[randomIndex].SelectionChance < Rng.GetFraction());
+					randomIndex = Rng.RandRange(0, Tile->GroundMesh.Num() - 1);
+				} while (Tile->GroundMesh[randomIndex].SelectionChance < Rng.GetFraction());
 
-					FloorTileMeshSelections.Add(tile, randomIndex);
-				}
+				FloorTileMeshSelections.Add(Tile, randomIndex);
 			}
+		}
 
-			if (tile->bCeilingMeshShouldAlwaysBeTheSame)
+		if (Tile->bCeilingMeshShouldAlwaysBeTheSame)
+		{
+			if (Tile->CeilingMesh.Num() > 0 && !CeilingTileMeshSelections.Contains(Tile))
 			{
-				if (tile->CeilingMesh.Num() > 0 && !CeilingTileMeshSelections.Contains(tile))
+				int32 randomIndex;
+				do
 				{
-					int32 randomIndex;
-					do
-					{
-						randomIndex = Rng.RandRange(0, tile->CeilingMesh.Num() - 1);
-					} while (tile->CeilingMesh[randomIndex].SelectionChance < Rng.GetFraction());
+					randomIndex = Rng.RandRange(0, Tile->CeilingMesh.Num() - 1);
+				} while (Tile->CeilingMesh[randomIndex].SelectionChance < Rng.GetFraction());
 
-					CeilingTileMeshSelections.Add(tile, randomIndex);
-				}
+				CeilingTileMeshSelections.Add(Tile, randomIndex);
 			}
+		}
 
-			if (tile->Interactions.Num() > 0 && !InteractionOptions.Contains(tile))
-			{
-				int32 randomIndex = Rng.RandRange(0, tile->Interactions.Num() - 1);
-				InteractionOptions.Add(tile, tile->Interactions[randomIndex]);
-			}
+		if (Tile->Interactions.Num() > 0 && !InteractionOptions.Contains(Tile))
+		{
+			int32 randomIndex = Rng.RandRange(0, Tile->Interactions.Num() - 1);
+			InteractionOptions.Add(Tile, Tile->Interactions[randomIndex]);
 		}
-	}
+	});
 
-	CreateAllRoomTiles(tileLocations, FloorComponentLookup, CeilingComponentLookup, Rng);
+	CreateAllRoomTiles(RoomTiles, tileLocations, FloorComponentLookup, CeilingComponentLookup, Rng);
 
 	SpawnInteractions(tileLocations, Rng);
 
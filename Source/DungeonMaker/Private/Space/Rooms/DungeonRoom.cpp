@@ -186,6 +186,42 @@ void ADungeonRoom::DoTileReplacement(FRandomStream &Rng)
 
 	OnRoomTilesReplaced();
 
+	TrySpawnInterfaces(Rng);
+}
+
+void ADungeonRoom::RestoreRoom(FRandomStream& Rng)
+{
+	FDungeonSpace& dungeon = GetDungeon();
+
+	// The entrances were carved when the dungeon was saved, so just link up with our neighbors
+	RoomMetadata.ForEachNeighbor(false, [this, &dungeon](const FIntVector& Neighbor)
+	{
+		ADungeonRoom* room = dungeon.GetLowRes(Neighbor).SpawnedRoom;
+		if (room == NULL)
+		{
+			return;
+		}
+		room->AllNeighbors.Add(this);
+		AllNeighbors.Add(room);
+	});
+	RoomMetadata.ForEachNeighbor(true, [this, &dungeon](const FIntVector& Neighbor)
+	{
+		ADungeonRoom* room = dungeon.GetLowRes(Neighbor).SpawnedRoom;
+		if (room == NULL)
+		{
+			return;
+		}
+		room->AllNeighbors.Add(this);
+		AllNeighbors.Add(room);
+		room->TightlyCoupledNeighbors.Add(this);
+		TightlyCoupledNeighbors.Add(room);
+	});
+
+	TrySpawnInterfaces(Rng);
+}
+
+void ADungeonRoom::TrySpawnInterfaces(FRandomStream& Rng)
+{
 #if !UE_BUILD_SHIPPING
 	if (bSpawnInterfaces)
 	{
@@ -211,6 +247,11 @@ FDungeonSpace& ADungeonRoom::GetDungeon() const
 	return DungeonSpace->DungeonSpace;
 }
 
+FRoomTileView ADungeonRoom::GetTileView() const
+{
+	return GetDungeon().GetRoomView(GetRoomLocation(), GetRoomSize());
+}
+
 bool ADungeonRoom::IsChangedAtRuntime() const
 {
 	if (Symbol == NULL)
@@ -303,7 +344,7 @@ void ADungeonRoom::CreateEntranceToNeighbors(FRandomStream& Rng)
 {
 	FDungeonSpace& dungeon = GetDungeon();
 
-	TSet<FIntVector> neighbors = RoomMetadata.NeighboringRooms;
+	TSet<FIntVector> neighbors = RoomMetadata.GetNeighbors(false);
 	for (FIntVector neighbor : neighbors)
 	{
 		ADungeonRoom* room = dungeon.GetLowRes(neighbor).SpawnedRoom;
@@ -317,7 +358,7 @@ void ADungeonRoom::CreateEntranceToNeighbors(FRandomStream& Rng)
 	}
 
 	// Now process any tightly-coupled neighbors
-	neighbors = RoomMetadata.NeighboringTightlyCoupledRooms;
+	neighbors = RoomMetadata.GetNeighbors(true);
 	for (FIntVector neighbor : neighbors)
 	{
 		ADungeonRoom* room = dungeon.GetLowRes(neighbor).SpawnedRoom;
@@ -340,5 +381,10 @@ bool ADungeonRoom::IsChildOf(ADungeonRoom* ParentRoom) const
 		UE_LOG(LogSpaceGen, Error, TEXT("Can't check if %s is a child of a null room!"), *GetName());
 		return false;
 	}
+	if (RoomMetadata.RoomNode == NULL || ParentRoom->RoomMetadata.RoomNode == NULL)
+	{
+		// Rooms loaded from a saved dungeon don't have a mission graph behind them
+		return false;
+	}
 	return RoomMetadata.RoomNode->IsChildOf(ParentRoom->RoomMetadata.RoomNode);
 }
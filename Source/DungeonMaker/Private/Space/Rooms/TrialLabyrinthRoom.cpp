@@ -3,7 +3,8 @@
 void ATrialLabyrinthRoom::DoTileReplacementPreprocessing(FRandomStream& Rng)
 {
 	FDungeonSpace& dungeon = GetDungeon();
-	TSet<FIntVector> entranceLocations = dungeon.GetTileLocations(ETileType::Entrance, this);
+	FRoomTileView roomTiles = GetTileView();
+	TSet<FIntVector> entranceLocations = roomTiles.GetTileLocations(ETileType::Entrance);
 
 	if (entranceLocations.Num() == 0)
 	{
@@ -21,7 +22,7 @@ void ATrialLabyrinthRoom::DoTileReplacementPreprocessing(FRandomStream& Rng)
 
 	// This stores the tile used as the "default" tile for this room
 	// The walls may already be set, but (1, 1) is guaranteed to become floor
-	const UDungeonTile* defaultTile = dungeon.GetTile(FIntVector(GetRoomLocation() + FIntVector(1, 1, 0)));
+	const UDungeonTile* defaultTile = roomTiles.GetTile(FIntVector(GetRoomLocation() + FIntVector(1, 1, 0)));
 
 	// Maze is made using a recursive backtracker
 	TArray<FIntVector> cellPositions;
@@ -45,7 +46,7 @@ void ATrialLabyrinthRoom::DoTileReplacementPreprocessing(FRandomStream& Rng)
 					continue;
 				}
 				FIntVector position = entrances[i] + FIntVector(x, y, 0);
-				const UDungeonTile* neighborTile = dungeon.GetTile(position);
+				const UDungeonTile* neighborTile = roomTiles.GetTile(position);
 				if (neighborTile != defaultTile)
 				{
 					continue;
@@ -96,16 +97,13 @@ bool ATrialLabyrinthRoom::PositionIsValid(FIntVector Position, const UDungeonTil
 		return false;
 	}
 
-	FIntVector roomMinExtent = GetRoomLocation();
-	FIntVector roomMaxExtent = roomMinExtent + GetRoomSize();
-
-	if (Position.X < roomMinExtent.X || Position.Y < roomMinExtent.Y ||
-		Position.X >= roomMaxExtent.X || Position.Y >= roomMaxExtent.Y)
+	FRoomTileView roomTiles = GetTileView();
+	if (!roomTiles.Contains(Position))
 	{
 		return false;
 	}
 
-	const UDungeonTile* tile = GetDungeon().GetTile(Position);
+	const UDungeonTile* tile = roomTiles.GetTile(Position);
 	if (tile != DefaultTile)
 	{
 		// Not available for carving
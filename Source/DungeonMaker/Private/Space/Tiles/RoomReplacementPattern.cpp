@@ -107,7 +107,7 @@ bool URoomReplacementPattern::FindAndReplaceByLocation(const FIntVector& RoomTil
 	}
 }
 
-TArray<FIntVector> URoomReplacementPattern::FindPossibleReplacements(FDungeonSpace &DungeonSpace, int32 StartX, int32 StartY, int32 StartZ, int32 XSize, int32 YSize) const
+TArray<FIntVector> URoomReplacementPattern::FindPossibleReplacements(const FDungeonSpace& DungeonSpace, int32 StartX, int32 StartY, int32 StartZ, int32 XSize, int32 YSize) const
 {
 	TArray<FIntVector> possibleReplacements;
 
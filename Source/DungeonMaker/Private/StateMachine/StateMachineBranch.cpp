@@ -6,7 +6,7 @@ UStateMachineState* UStateMachineBranch::TryBranch(const UObject* ReferenceObjec
 	int32 DataIndex, int32& OutDataIndex)
 {
 	OutDataIndex = DataIndex + 1;
-	if (DataSource.IsValidIndex(DataIndex) && AcceptableInputs.Contains(DataSource[DataIndex]))
+	if (DataSource.IsValidIndex(DataIndex) && AcceptsInput(DataSource[DataIndex]))
 	{
 		UE_LOG(LogStateMachine, Verbose, TEXT("%s accepts input %s!"), *GetName(), *DataSource[DataIndex]->Description.ToString());
 		return bReverseInputTest ? NULL : DestinationState;
@@ -14,17 +14,75 @@ UStateMachineState* UStateMachineBranch::TryBranch(const UObject* ReferenceObjec
 	else
 	{
 #if !UE_BUILD_SHIPPING
-		FString acceptedInputs = "";
-		for (int i = 0; i < AcceptableInputs.Num(); i++)
+		// Only worth listing everything if someone's going to read it
+		if (UE_LOG_ACTIVE(LogStateMachine, Verbose))
 		{
-			acceptedInputs.Append(AcceptableInputs[i]->Description.ToString());
-			if (i + 1 < AcceptableInputs.Num())
+			FString acceptedInputs = "";
+			for (int i = 0; i < AcceptableInputs.Num(); i++)
 			{
-				acceptedInputs.Append(", ");
+				acceptedInputs.Append(AcceptableInputs[i]->Description.ToString());
+				if (i + 1 < AcceptableInputs.Num())
+				{
+					acceptedInputs.Append(", ");
+				}
 			}
+			UE_LOG(LogStateMachine, Verbose, TEXT("%s does not accept input %s! Acceptable inputs: %s"), *GetName(), *DataSource[DataIndex]->Description.ToString(), *acceptedInputs);
 		}
-		UE_LOG(LogStateMachine, Verbose, TEXT("%s does not accept input %s! Acceptable inputs: %s"), *GetName(), *DataSource[DataIndex]->Description.ToString(), *acceptedInputs);
 #endif
 		return bReverseInputTest ? DestinationState : NULL;
 	}
-}
\ No newline at end of file
+}
+
+bool UStateMachineBranch::AcceptsInput(const UStateMachineSymbol* Input) const
+{
+	if (bHasBuiltAcceptableInputSet)
+	{
+		return AcceptableInputSet.Contains(Input);
+	}
+
+	// The set hasn't been built yet, so check them one at a time
+	for (int i = 0; i < AcceptableInputs.Num(); i++)
+	{
+		if (AcceptableInputs[i] == Input)
+		{
+			return true;
+		}
+	}
+	return false;
+}
+
+void UStateMachineBranch::SetAcceptableInputs(const TArray<UStateMachineSymbol*>& Inputs)
+{
+	AcceptableInputs = Inputs;
+	BuildAcceptableInputSet();
+}
+
+void UStateMachineBranch::BuildAcceptableInputSet()
+{
+	AcceptableInputSet.Reset();
+	for (const UStateMachineSymbol* symbol : AcceptableInputs)
+	{
+		AcceptableInputSet.Add(symbol);
+	}
+	bHasBuiltAcceptableInputSet = true;
+}
+
+void UStateMachineBranch::PostLoad()
+{
+	Super::PostLoad();
+	BuildAcceptableInputSet();
+}
+
+#if WITH_EDITOR
+void UStateMachineBranch::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+	BuildAcceptableInputSet();
+}
+
+void UStateMachineBranch::PostEditUndo()
+{
+	Super::PostEditUndo();
+	BuildAcceptableInputSet();
+}
+#endif
@@ -2,6 +2,10 @@
 
 #include "StateMachineState.h"
 #include "StateMachineSymbol.h"
+#include "Async/ParallelFor.h"
+
+// How many inputs each worker gets when a batch is split up. Smaller batches aren't worth the threading overhead.
+static const int32 BATCH_CHUNK_SIZE = 64;
 
 UStateMachineState::UStateMachineState()
 {
@@ -16,61 +20,112 @@ UStateMachineState::UStateMachineState(const FObjectInitializer& Initializer) :
 FStateMachineResult UStateMachineState::RunState(const UObject* ReferenceObject,
 	const TArray<UStateMachineSymbol*>& DataSource, int32 DataIndex, int32 RemainingSteps) const
 {
-	TArray<UStateMachineBranch*> branches;
-	branches.Append(InstancedBranches);
-	branches.Append(SharedBranches);
-	return RunStateWithBranches(ReferenceObject, DataSource, branches, TArray<UStateMachineBranch*>(), DataIndex, RemainingSteps);
+	return RunStateWithBranchLists(ReferenceObject, DataSource, InstancedBranches, SharedBranches, DataIndex, RemainingSteps);
+}
+
+FStateMachineResult UStateMachineState::RunStateWithBranches(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
+	const TArray<UStateMachineBranch*>& Branches, int32 DataIndex, int32 RemainingSteps) const
+{
+	static const TArray<UStateMachineBranch*> noBranches;
+	return RunStateWithBranchLists(ReferenceObject, DataSource, Branches, noBranches, DataIndex, RemainingSteps);
 }
 
 FStateMachineResult UStateMachineState::RunStateWithBranches(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
 	TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps) const
 {
-	bool bMustEndNow = (bTerminateImmediately || !DataSource.IsValidIndex(DataIndex));
+	return RunStateWithBranches(ReferenceObject, DataSource, Branches, DataIndex, RemainingSteps);
+}
 
-	if (RemainingSteps != 0 && !bMustEndNow)
+FStateMachineResult UStateMachineState::RunStateWithBranchLists(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
+	const TArray<UStateMachineBranch*>& FirstBranches, const TArray<UStateMachineBranch*>& SecondBranches, int32 DataIndex, int32 RemainingSteps) const
+{
+	// Every state we move into is run with the branches we started with
+	const UStateMachineState* currentState = this;
+	while (true)
 	{
+		bool bMustEndNow = (currentState->bTerminateImmediately || !DataSource.IsValidIndex(DataIndex));
+		if (RemainingSteps == 0 || bMustEndNow)
+		{
+			return FStateMachineResult(currentState, DataIndex, bMustEndNow ? currentState->CompletionType : EStateMachineCompletionType::OutOfSteps);
+		}
+
 		UStateMachineState* destinationState = NULL;
 		int32 destinationDataIndex = DataIndex;
-		for (int32 i = 0; i < Branches.Num(); i++)
+		for (int32 i = 0; i < FirstBranches.Num() + SecondBranches.Num(); i++)
 		{
+			UStateMachineBranch* branch = i < FirstBranches.Num() ? FirstBranches[i] : SecondBranches[i - FirstBranches.Num()];
 			// Make sure the branch isn't null
-			check(Branches[i]);
-			destinationState = Branches[i]->TryBranch(ReferenceObject, DataSource, DataIndex, destinationDataIndex);
+			check(branch);
+			destinationState = branch->TryBranch(ReferenceObject, DataSource, DataIndex, destinationDataIndex);
 			if (destinationState != NULL)
 			{
-				TakenBranches.Add(Branches[i]);
-				return destinationState->RunStateWithBranches(ReferenceObject, DataSource, Branches, TakenBranches, destinationDataIndex, RemainingSteps - 1);
+				break;
 			}
 		}
-		if (bLoopByDefault)
+
+		if (destinationState != NULL)
 		{
-			return LoopStateWithBranches(ReferenceObject, DataSource, Branches, TakenBranches, DataIndex, RemainingSteps);
+			currentState = destinationState;
+			DataIndex = destinationDataIndex;
 		}
-		bMustEndNow = true;
+		else if (currentState->bLoopByDefault)
+		{
+			// Loop to the next input. Used when the current input isn't recognized for whatever reason.
+			DataIndex++;
+		}
+		else
+		{
+			return FStateMachineResult(currentState, DataIndex, currentState->CompletionType);
+		}
+		RemainingSteps--;
 	}
+}
 
-	return FStateMachineResult(this, DataIndex, bMustEndNow ? CompletionType : EStateMachineCompletionType::OutOfSteps);
+void UStateMachineState::RunStateBatch(const UObject* ReferenceObject, const TArray<FStateMachineInput>& Inputs, TArray<FStateMachineResult>& OutResults,
+	int32 RemainingSteps) const
+{
+	OutResults.SetNum(Inputs.Num(), false);
+	for (int32 i = 0; i < Inputs.Num(); i++)
+	{
+		OutResults[i] = RunStateWithBranchLists(ReferenceObject, Inputs[i].Symbols, InstancedBranches, SharedBranches, 0, RemainingSteps);
+	}
 }
 
-FStateMachineResult UStateMachineState::LoopStateWithBranches(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
-	TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps) const
+void UStateMachineState::RunStateBatchParallel(const UObject* ReferenceObject, const TArray<FStateMachineInput>& Inputs, TArray<FStateMachineResult>& OutResults,
+	int32 RemainingSteps) const
 {
-	TakenBranches.Add(NULL);
-	return RunStateWithBranches(ReferenceObject, DataSource, Branches, TakenBranches, DataIndex + 1, RemainingSteps - 1);
+	int32 chunkCount = FMath::DivideAndRoundUp(Inputs.Num(), BATCH_CHUNK_SIZE);
+	if (chunkCount <= 1)
+	{
+		RunStateBatch(ReferenceObject, Inputs, OutResults, RemainingSteps);
+		return;
+	}
+
+	OutResults.SetNum(Inputs.Num(), false);
+
+	// Every input writes only to its own result, so the chunks don't need to share anything
+	ParallelFor(chunkCount, [this, ReferenceObject, &Inputs, &OutResults, RemainingSteps](int32 Chunk)
+	{
+		int32 end = FMath::Min((Chunk + 1) * BATCH_CHUNK_SIZE, Inputs.Num());
+		for (int32 i = Chunk * BATCH_CHUNK_SIZE; i < end; i++)
+		{
+			OutResults[i] = RunStateWithBranchLists(ReferenceObject, Inputs[i].Symbols, InstancedBranches, SharedBranches, 0, RemainingSteps);
+		}
+	});
 }
 
 bool UStateMachineState::Contains(const UStateMachineSymbol* Symbol) const
 {
 	for (int i = 0; i < InstancedBranches.Num(); i++)
 	{
-		if (InstancedBranches[i]->AcceptableInputs.Contains(Symbol))
+		if (InstancedBranches[i]->AcceptsInput(Symbol))
 		{
 			return true;
 		}
 	}
 	for (int i = 0; i < SharedBranches.Num(); i++)
 	{
-		if (SharedBranches[i]->AcceptableInputs.Contains(Symbol))
+		if (SharedBranches[i]->AcceptsInput(Symbol))
 		{
 			return true;
 		}
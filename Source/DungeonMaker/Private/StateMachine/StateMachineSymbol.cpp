@@ -1,3 +1,33 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
-#include "StateMachineSymbol.h"
\ No newline at end of file
+#include "StateMachineSymbol.h"
+
+TAtomic<int32> FStateMachineSymbolRegistry::SymbolCount(0);
+
+int32 FStateMachineSymbolRegistry::Register()
+{
+	return SymbolCount++;
+}
+
+int32 FStateMachineSymbolRegistry::Num()
+{
+	return SymbolCount.Load();
+}
+
+UStateMachineSymbol::UStateMachineSymbol()
+{
+	SymbolIndex = INDEX_NONE;
+}
+
+int32 UStateMachineSymbol::RegisterSymbolIndex() const
+{
+	checkf(!HasAnyFlags(RF_ClassDefaultObject | RF_ArchetypeObject), TEXT("%s is a class default or archetype, and can't be matched against!"), *GetName());
+	// If another thread got here first, keep its index; ours just goes unused
+	int32 newIndex = FStateMachineSymbolRegistry::Register();
+	int32 index = INDEX_NONE;
+	if (SymbolIndex.CompareExchange(index, newIndex))
+	{
+		return newIndex;
+	}
+	return index;
+}
@@ -0,0 +1,72 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "DungeonSpaceGenerator.h"
+#include "DungeonMissionSymbol.h"
+#include "MissionSpaceHandlers/NeighboringMissionSpaceHandler.h"
+#include "Floor/DungeonSpaceFile.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FDungeonFloorCopyTest, "DungeonMaker.Space.FloorsAreNeverCopied",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FDungeonFloorCopyTest::RunTest(const FString& Parameters)
+{
+	// A chain of rooms, with one tightly coupled to its parent
+	const int32 nodeCount = 8;
+	UDungeonMissionSymbol* symbol = NewObject<UDungeonMissionSymbol>();
+	symbol->RoomTypes.Add(ADungeonRoom::StaticClass());
+	symbol->bAllowedToHaveChildren = true;
+	TArray<UDungeonMissionNode*> nodes;
+	for (int i = 0; i < nodeCount; i++)
+	{
+		UDungeonMissionNode* node = NewObject<UDungeonMissionNode>();
+		node->NodeType = symbol;
+		node->NodeID = i + 1;
+		node->bTightlyCoupledToParent = i == nodeCount / 2;
+		if (nodes.Num() > 0)
+		{
+			nodes.Last()->AddLinkToNode(node, node->bTightlyCoupledToParent);
+		}
+		nodes.Add(node);
+	}
+
+	UDungeonTile* defaultTile = NewObject<UDungeonTile>();
+	UDungeonTile* changedTile = NewObject<UDungeonTile>();
+	UDungeonSpaceGenerator* generator = NewObject<UDungeonSpaceGenerator>();
+	generator->RoomSize = 8;
+	UDungeonMissionSpaceHandler* handler = NewObject<UNeighboringMissionSpaceHandler>(generator);
+	handler->RoomSize = generator->RoomSize;
+	TArray<int32> levelSizes;
+	levelSizes.Add(4);
+	FRandomStream rng(1234);
+
+	int32 startingCopies = FDungeonFloorCopyCounter::GetCopyCount();
+
+	handler->InitializeDungeonFloor(generator, levelSizes);
+	TestTrue(TEXT("The mission fits in the dungeon space."), handler->CreateDungeonSpace(nodes[0], FIntVector(0, 0, 0), nodeCount, rng));
+
+	FDungeonSpace& dungeonSpace = generator->DungeonSpace;
+	dungeonSpace.CopyLosResToHighRes(defaultTile);
+
+	// Rooms change tiles after they spawn, sometimes under a savepoint
+	int32 savepoint = dungeonSpace.CreateSavepoint();
+	dungeonSpace.SetTile(FIntVector(1, 1, 0), changedTile);
+	dungeonSpace.RollbackToSavepoint(savepoint);
+	dungeonSpace.CommitJournal();
+	dungeonSpace.SetTile(FIntVector(2, 2, 0), changedTile);
+	TestEqual(TEXT("Only the committed tile change is kept."), dungeonSpace.GetTileLocations(changedTile).Num(), 1);
+	TestEqual(TEXT("Both tiles are found."), dungeonSpace.FindAllTiles().Num(), 2);
+	TestTrue(TEXT("Changed tiles are reported as dirty."), dungeonSpace.ConsumeDirtyRegions().Num() > 0);
+
+	TArray<uint8> data;
+	FDungeonSpaceFile::Write(dungeonSpace, data);
+	FString error;
+	TestTrue(TEXT("The saved dungeon is valid."), FDungeonSpaceFileView(data.GetData(), data.Num()).Validate(error));
+
+	TestEqual(TEXT("Dungeon floors copied while generating"), FDungeonFloorCopyCounter::GetCopyCount() - startingCopies, 0);
+	return true;
+}
+
+#endif
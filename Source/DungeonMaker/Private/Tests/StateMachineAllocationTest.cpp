@@ -0,0 +1,135 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Misc/AutomationTest.h"
+#include "HAL/MemoryBase.h"
+#include "HAL/PlatformTLS.h"
+#include "HAL/PlatformTime.h"
+#include "StateMachineState.h"
+#include "StateMachineSymbol.h"
+
+#if WITH_DEV_AUTOMATION_TESTS
+
+// Passes everything through to the real allocator, counting allocations made on one thread.
+// Other threads keep allocating while the test runs, so only the test thread is counted.
+class FCountingMalloc : public FMalloc
+{
+public:
+	FCountingMalloc(FMalloc* InInnerMalloc, uint32 InCountedThreadId)
+		: InnerMalloc(InInnerMalloc), CountedThreadId(InCountedThreadId), AllocationCount(0)
+	{
+	}
+
+	virtual void* Malloc(SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Malloc(Count, Alignment);
+	}
+
+	virtual void* Realloc(void* Original, SIZE_T Count, uint32 Alignment) override
+	{
+		CountAllocation();
+		return InnerMalloc->Realloc(Original, Count, Alignment);
+	}
+
+	virtual void Free(void* Original) override
+	{
+		InnerMalloc->Free(Original);
+	}
+
+	virtual bool GetAllocationSize(void* Original, SIZE_T& SizeOut) override
+	{
+		return InnerMalloc->GetAllocationSize(Original, SizeOut);
+	}
+
+	virtual bool IsInternallyThreadSafe() const override
+	{
+		return InnerMalloc->IsInternallyThreadSafe();
+	}
+
+	virtual const TCHAR* GetDescriptorName() const override
+	{
+		return TEXT("DungeonMakerCountingMalloc");
+	}
+
+	int32 GetAllocationCount() const
+	{
+		return AllocationCount;
+	}
+
+private:
+	void CountAllocation()
+	{
+		if (FPlatformTLS::GetCurrentThreadId() == CountedThreadId)
+		{
+			AllocationCount++;
+		}
+	}
+
+	FMalloc* InnerMalloc;
+	uint32 CountedThreadId;
+	// Only ever touched by the counted thread
+	int32 AllocationCount;
+};
+
+IMPLEMENT_SIMPLE_AUTOMATION_TEST(FStateMachineAllocationTest, "DungeonMaker.StateMachine.RunsWithoutAllocating",
+	EAutomationTestFlags::ApplicationContextMask | EAutomationTestFlags::EngineFilter)
+
+bool FStateMachineAllocationTest::RunTest(const FString& Parameters)
+{
+	const int32 runCount = 10000;
+
+	// Two states which bounce back and forth on alternating symbols
+	UStateMachineSymbol* symbolA = NewObject<UStateMachineSymbol>();
+	UStateMachineSymbol* symbolB = NewObject<UStateMachineSymbol>();
+	UStateMachineState* stateA = NewObject<UStateMachineState>();
+	UStateMachineState* stateB = NewObject<UStateMachineState>();
+	UStateMachineState* startState = NewObject<UStateMachineState>();
+
+	UStateMachineBranch* branchA = NewObject<UStateMachineBranch>(startState);
+	branchA->DestinationState = stateA;
+	branchA->SetAcceptableInputs({ symbolA });
+	UStateMachineBranch* branchB = NewObject<UStateMachineBranch>(startState);
+	branchB->DestinationState = stateB;
+	branchB->SetAcceptableInputs({ symbolB });
+	startState->InstancedBranches.Add(branchA);
+	startState->SharedBranches.Add(branchB);
+	TArray<UStateMachineBranch*> branches = { branchA, branchB };
+
+	TArray<UStateMachineSymbol*> input = { symbolA, symbolB, symbolA, symbolB, symbolA };
+	TArray<FStateMachineInput> batch;
+	batch.SetNum(16);
+	for (FStateMachineInput& batchInput : batch)
+	{
+		batchInput.Symbols = input;
+	}
+	TArray<FStateMachineResult> batchResults;
+
+	// Let the results grow to full size before we start counting
+	FStateMachineResult result = startState->RunState(NULL, input);
+	TestEqual(TEXT("The machine ends on the last symbol's state."), result.FinalState, (const UStateMachineState*)stateA);
+	TestEqual(TEXT("The machine reads every symbol."), result.DataIndex, input.Num());
+	result = startState->RunStateWithBranches(NULL, input, branches);
+	TestEqual(TEXT("Explicit branches end on the last symbol's state."), result.FinalState, (const UStateMachineState*)stateA);
+	startState->RunStateBatch(NULL, batch, batchResults);
+
+	FMalloc* realMalloc = GMalloc;
+	FCountingMalloc countingMalloc(realMalloc, FPlatformTLS::GetCurrentThreadId());
+	GMalloc = &countingMalloc;
+
+	double startTime = FPlatformTime::Seconds();
+	for (int32 i = 0; i < runCount; i++)
+	{
+		startState->RunState(NULL, input);
+		startState->RunStateWithBranches(NULL, input, branches);
+	}
+	double runSeconds = FPlatformTime::Seconds() - startTime;
+	startState->RunStateBatch(NULL, batch, batchResults);
+
+	GMalloc = realMalloc;
+
+	AddInfo(FString::Printf(TEXT("%d state machine runs took %.3f ms."), runCount * 2, runSeconds * 1000.0));
+	TestEqual(TEXT("Allocations made while running the state machine"), countingMalloc.GetAllocationCount(), 0);
+	return true;
+}
+
+#endif
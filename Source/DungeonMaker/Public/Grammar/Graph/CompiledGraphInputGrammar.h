@@ -0,0 +1,114 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "StateMachineResult.h"
+#include "GraphOutputGrammar.h"
+
+class UGraphInputGrammar;
+class UStateMachineState;
+class UStateMachineSymbol;
+
+/*
+* A graph input grammar, flattened into a transition table.
+*
+* Every state reachable from the start state gets an index, and every symbol
+* any branch looks at gets a column. The table holds, for each state, column,
+* and coupling of the next link, the state the first passing branch leads to.
+* Running the table gives the same result as UGraphInputGrammar::RunCoupledState,
+* without recursing, allocating, or calling into any branches.
+*/
+struct DUNGEONMAKER_API FCompiledGraphInputGrammar
+{
+public:
+	// How the link after the current one is coupled to it.
+	enum ENextLinkCoupling : uint8
+	{
+		// There is no next link.
+		NoNextLink,
+		LooselyCoupled,
+		TightlyCoupled,
+		CouplingCount
+	};
+
+	static ENextLinkCoupling GetNextLinkCoupling(const TArray<FGraphLink>& DataSource, int32 DataIndex)
+	{
+		if (!DataSource.IsValidIndex(DataIndex + 1))
+		{
+			return NoNextLink;
+		}
+		return DataSource[DataIndex + 1].bIsTightlyCoupled ? TightlyCoupled : LooselyCoupled;
+	}
+
+private:
+	struct FCompiledState
+	{
+		const UStateMachineState* State;
+		EStateMachineCompletionType CompletionType;
+		bool bTerminateImmediately;
+	};
+
+	static const int32 NO_STATE = INDEX_NONE;
+
+	TArray<FCompiledState> States;
+	TMap<const UStateMachineSymbol*, int32> SymbolColumns;
+	// One column per symbol, plus a final column for any symbol nobody looks at.
+	int32 ColumnCount;
+	TArray<int32> Transitions;
+
+	int32 GetTransitionIndex(int32 StateIndex, int32 Column, ENextLinkCoupling Coupling) const
+	{
+		return ((StateIndex * ColumnCount) + Column) * CouplingCount + Coupling;
+	}
+
+	// Can the start state be left (or be accepted in) from this column?
+	bool MightAcceptColumn(int32 Column, ENextLinkCoupling Coupling) const;
+
+public:
+	FCompiledGraphInputGrammar()
+	{
+		ColumnCount = 0;
+	}
+
+	// Flattens every state reachable from StartState.
+	// Returns false (leaving this empty) if any branch isn't a plain graph edge,
+	// since only the stock edge behavior can be baked into a table.
+	bool Compile(const UGraphInputGrammar* StartState);
+
+	void Reset()
+	{
+		States.Empty();
+		SymbolColumns.Empty();
+		ColumnCount = 0;
+		Transitions.Empty();
+	}
+
+	bool IsCompiled() const
+	{
+		return States.Num() > 0;
+	}
+
+	// Runs the whole machine over the data source, starting with the first link.
+	FStateMachineResult Run(const TArray<FGraphLink>& DataSource) const;
+
+	// Returns true if a data source starting with Symbol could be accepted, given how the link after it is coupled.
+	// Only the first step is looked at, so this can say yes to things Run rejects, but never the other way around.
+	bool MightAccept(const UStateMachineSymbol* Symbol, ENextLinkCoupling Coupling) const
+	{
+		const int32* column = SymbolColumns.Find(Symbol);
+		return MightAcceptColumn(column == NULL ? ColumnCount - 1 : *column, Coupling);
+	}
+
+	// Same as MightAccept, for any symbol no branch looks at.
+	bool MightAcceptUnknownSymbol(ENextLinkCoupling Coupling) const
+	{
+		return MightAcceptColumn(ColumnCount - 1, Coupling);
+	}
+
+	// Gets every symbol any branch of the machine looks at.
+	void GetKnownSymbols(TArray<const UStateMachineSymbol*>& OutSymbols) const
+	{
+		SymbolColumns.GetKeys(OutSymbols);
+	}
+};
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "CoreMinimal.h"
+
+class UDungeonMakerNode;
+
+/*
+* The shape of a graph of UDungeonMakerNodes, worked out once so it doesn't
+* have to be walked again for every question about it.
+*
+* Covers every node connected to the node it was built from, through either
+* children or parents. Ancestry follows ParentNodes and levels follow
+* ChildrenNodes, the same way UDungeonMakerNode::IsChildOf and
+* UDungeonMissionNode::GetLevelCount always have.
+*
+* Nodes share one analysis per graph (see UDungeonMakerNode::GetGraphAnalysis),
+* and any change to a link should invalidate it.
+*/
+struct DUNGEONMAKER_API FDungeonMakerGraphAnalysis
+{
+private:
+	// Parents come before their children, unless the graph has a cycle.
+	TArray<const UDungeonMakerNode*> Nodes;
+	TMap<const UDungeonMakerNode*, int32> NodeIndices;
+	// How many links the longest path from a root to each node has.
+	TArray<int32> Depths;
+	// How many nodes the longest path from each node down to a leaf has, counting the node itself.
+	TArray<int32> LevelCounts;
+	// Bit N is set if node N can be reached by following ParentNodes.
+	TArray<TBitArray<>> Ancestors;
+	bool bIsValid;
+
+public:
+	FDungeonMakerGraphAnalysis()
+	{
+		bIsValid = false;
+	}
+
+	void Build(const UDungeonMakerNode* StartNode);
+
+	bool IsValid() const
+	{
+		return bIsValid;
+	}
+
+	void Invalidate()
+	{
+		bIsValid = false;
+	}
+
+	bool Contains(const UDungeonMakerNode* Node) const
+	{
+		return NodeIndices.Contains(Node);
+	}
+
+	const TArray<const UDungeonMakerNode*>& GetTopologicalOrder() const
+	{
+		return Nodes;
+	}
+
+	int32 GetDepth(const UDungeonMakerNode* Node) const
+	{
+		return Depths[NodeIndices[Node]];
+	}
+
+	int32 GetLevelCount(const UDungeonMakerNode* Node) const
+	{
+		return LevelCounts[NodeIndices[Node]];
+	}
+
+	// Returns true if Ancestor is a parent of Node, or a parent of one of its parents, and so on.
+	bool IsAncestorOf(const UDungeonMakerNode* Ancestor, const UDungeonMakerNode* Node) const
+	{
+		const int32* ancestorIndex = NodeIndices.Find(Ancestor);
+		const int32* nodeIndex = NodeIndices.Find(Node);
+		if (ancestorIndex == NULL || nodeIndex == NULL)
+		{
+			return false;
+		}
+		return Ancestors[*nodeIndex][*ancestorIndex];
+	}
+
+	// Visits every node reachable from StartNodes through ChildrenNodes exactly once, closest nodes first.
+	// Func gets each node and how many links it is from the closest start node.
+	template<typename FuncType>
+	static void ForEachBreadthFirst(const TArray<UDungeonMakerNode*>& StartNodes, FuncType Func);
+};
@@ -2,6 +2,7 @@
 
 #include "CoreMinimal.h"
 #include "Grammar/Graph/GraphNode.h"
+#include "DungeonMakerGraphAnalysis.h"
 #include "DungeonMakerNode.generated.h"
 
 class UDungeonMakerGraph;
@@ -61,4 +62,43 @@ public:
 	bool IsChildOf(UDungeonMakerNode* ParentSymbol) const;
 	//////////////////////////////////////////////////////////////////////////
 	UDungeonMakerGraph* GetGraph();
+
+	// Gets the analysis of the graph this node is in, building it if the graph has changed since it was last built.
+	const FDungeonMakerGraphAnalysis& GetGraphAnalysis() const;
+	// Must be called before changing ChildrenNodes or ParentNodes.
+	void InvalidateGraphAnalysis();
+
+private:
+	// Shared with every other node in the same graph.
+	mutable TSharedPtr<FDungeonMakerGraphAnalysis> GraphAnalysis;
 };
+
+template<typename FuncType>
+void FDungeonMakerGraphAnalysis::ForEachBreadthFirst(const TArray<UDungeonMakerNode*>& StartNodes, FuncType Func)
+{
+	// Walk an array instead of popping off the front of it, so nothing gets shifted around
+	TArray<TPair<UDungeonMakerNode*, int32>> queue;
+	TSet<const UDungeonMakerNode*> visited;
+	for (UDungeonMakerNode* node : StartNodes)
+	{
+		if (node != NULL && !visited.Contains(node))
+		{
+			visited.Add(node);
+			queue.Add(TPair<UDungeonMakerNode*, int32>(node, 0));
+		}
+	}
+	for (int32 i = 0; i < queue.Num(); i++)
+	{
+		UDungeonMakerNode* node = queue[i].Key;
+		int32 distance = queue[i].Value;
+		Func(node, distance);
+		for (UDungeonMakerNode* child : node->ChildrenNodes)
+		{
+			if (child != NULL && !visited.Contains(child))
+			{
+				visited.Add(child);
+				queue.Add(TPair<UDungeonMakerNode*, int32>(child, distance + 1));
+			}
+		}
+	}
+}
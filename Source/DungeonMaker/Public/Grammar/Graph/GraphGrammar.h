@@ -24,5 +24,14 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	UDungeonMakerGraph* OutputGraph;
 
+	// The shape the input nodes must have, for inputs which aren't a simple chain.
+	// If defined, this will be matched instead of RuleInput. Node 1 is the node being replaced,
+	// and output nodes replace input nodes through their InputNodeID. Every input node must be
+	// replaced by some output node, or the grammar is never used.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	UDungeonMakerGraph* InputGraph;
+
+	// Runs the input states directly. Mission generation goes through FCompiledMissionGrammar
+	// instead, which compiles the input states once per generation.
 	EGrammarResultType MatchesGrammar(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource) const;
 };
\ No newline at end of file
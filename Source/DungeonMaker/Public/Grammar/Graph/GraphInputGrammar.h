@@ -18,7 +18,11 @@ class DUNGEONMAKER_API UGraphInputGrammar : public UInputGrammar
 {
 	GENERATED_BODY()
 public:
-	FStateMachineResult RunCoupledState(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps);
-	FStateMachineResult RunCoupledStateWithBranches(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource, TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps);
+	// Runs the machine, with each state using its own branches.
+	FStateMachineResult RunCoupledState(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource, int32 DataIndex = 0, int32 RemainingSteps = -1) const;
+
+protected:
+	// Returns the state the first branch which accepts the input at DataIndex leads to, or NULL if none do.
+	UGraphInputGrammar* TryCoupledBranches(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource, int32 DataIndex, int32& OutDataIndex) const;
 };
 
@@ -4,6 +4,7 @@
 #include "GraphOutputGrammar.generated.h"
 
 class UDungeonMakerGraph;
+struct FCompiledMissionGrammar;
 
 USTRUCT(BlueprintType)
 struct DUNGEONMAKER_API FGraphLink
@@ -42,12 +43,31 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	float Weight;
 
+	// Identifies the shape of Graph, so usage can be tracked without comparing graphs.
+	// Graphs with the same shape share an ID.
 	UPROPERTY(BlueprintReadOnly)
-	TArray<FGraphLink> MatchedLinks;
+	int32 GraphID;
+
+	// The read-only grammar this output came from, if it came from a mission grammar.
+	// Replacements should read the output graph from here rather than from Graph.
+	const FCompiledMissionGrammar* CompiledGrammar;
+
+	// The links this grammar matched, stored in the mission candidate's MatchedLinkPool.
+	int32 FirstMatchedLink;
+	int32 MatchedLinkCount;
+	// If the grammar has an input graph, the mission node each input node was matched to,
+	// stored in the mission candidate's MatchedNodePool. Empty for grammars matched through their links.
+	int32 FirstMatchedNode;
+	int32 MatchedNodeCount;
 
 	FGraphOutput()
 	{
 		Weight = 0.0f;
-		MatchedLinks = TArray<FGraphLink>();
+		GraphID = INDEX_NONE;
+		CompiledGrammar = NULL;
+		FirstMatchedLink = 0;
+		MatchedLinkCount = 0;
+		FirstMatchedNode = 0;
+		MatchedNodeCount = 0;
 	}
 };
\ No newline at end of file
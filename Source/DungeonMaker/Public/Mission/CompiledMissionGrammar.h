@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "Grammar.h"
+#include "GraphNode.h"
+#include "GraphOutputGrammar.h"
+#include "CompiledGraphInputGrammar.h"
+#include "MissionSubgraphPattern.h"
+
+class UDungeonMissionGrammar;
+
+// One node of a compiled output or input graph.
+struct DUNGEONMAKER_API FCompiledOutputNode
+{
+	UGraphNode* NodeType;
+	// The ID this node has once the output graph's IDs are up to date.
+	int32 NodeID;
+	bool bTightlyCoupledToParent;
+	// Indices of this node's children in the compiled output.
+	TArray<int32> Children;
+
+	FNumberedGraphSymbol ToGraphSymbol() const
+	{
+		FNumberedGraphSymbol symbol;
+		symbol.Symbol = NodeType;
+		symbol.SymbolID = NodeID;
+		return symbol;
+	}
+};
+
+/*
+* A read-only copy of a UDungeonMissionGrammar, made once and never changed.
+*
+* Everything mission generation needs from a grammar is copied in here: the
+* input states as a transition table, and the output graph with its node IDs
+* already worked out. Generation only ever reads these, so any number of
+* generators and candidates can share one without touching the grammar asset.
+*
+* Editing the asset makes a new copy (see UDungeonMissionGrammar::GetCompiledGrammar);
+* anything still holding the old one can keep using it.
+*/
+struct DUNGEONMAKER_API FCompiledMissionGrammar
+{
+private:
+	const UDungeonMissionGrammar* Grammar;
+	float Weight;
+	FCompiledGraphInputGrammar RuleInput;
+	// Grammars with an input graph are only ever matched through InputPattern.
+	bool bHasInputGraph;
+	FMissionSubgraphPattern InputPattern;
+	TArray<FCompiledOutputNode> OutputNodes;
+	TArray<int32> OutputRootNodes;
+	// Which output node has each node ID.
+	TMap<int32, int32> OutputNodeIDs;
+	FString OutputDescription;
+
+public:
+	explicit FCompiledMissionGrammar(const UDungeonMissionGrammar* SourceGrammar);
+
+	const UDungeonMissionGrammar* GetGrammar() const
+	{
+		return Grammar;
+	}
+
+	float GetWeight() const
+	{
+		return Weight;
+	}
+
+	const FCompiledGraphInputGrammar& GetRuleInput() const
+	{
+		return RuleInput;
+	}
+
+	bool HasInputGraph() const
+	{
+		return bHasInputGraph;
+	}
+
+	// Empty if there's no input graph, or it couldn't be compiled.
+	const FMissionSubgraphPattern& GetInputPattern() const
+	{
+		return InputPattern;
+	}
+
+	// If the input states couldn't be compiled, they get run directly. That only reads from them.
+	// Always rejects grammars with an input graph.
+	EGrammarResultType MatchesGrammar(const UObject* ReferenceObject, const TArray<FGraphLink>& DataSource) const;
+
+	bool HasOutput() const
+	{
+		return OutputRootNodes.Num() > 0;
+	}
+
+	int32 NumOutputNodes() const
+	{
+		return OutputNodes.Num();
+	}
+
+	// Output nodes are in the same order as the output graph's AllNodes.
+	const FCompiledOutputNode& GetOutputNode(int32 Index) const
+	{
+		return OutputNodes[Index];
+	}
+
+	// Returns the index of the output node with the given ID, or INDEX_NONE if there isn't one.
+	int32 FindOutputNode(int32 NodeID) const
+	{
+		const int32* index = OutputNodeIDs.Find(NodeID);
+		return index != NULL ? *index : INDEX_NONE;
+	}
+
+	// The same as UDungeonMakerGraph::ToString on the output graph.
+	const FString& GetOutputDescription() const
+	{
+		return OutputDescription;
+	}
+};
+
+typedef TSharedPtr<const FCompiledMissionGrammar, ESPMode::ThreadSafe> FCompiledMissionGrammarPtr;
@@ -6,6 +6,9 @@
 #include "Components/ActorComponent.h"
 #include "DungeonMissionNode.h"
 #include "DungeonMissionGrammar.h"
+#include "DungeonMissionGrammarIndex.h"
+#include "MissionGraph.h"
+#include "MissionCandidate.h"
 #include "DungeonMissionGenerator.generated.h"
 
 USTRUCT(BlueprintType)
@@ -49,6 +52,20 @@ public:
 	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "Dungeon Grammar")
 	int32 DungeonSize;
 
+	// How many missions to build at once each time we try to create a dungeon.
+	// Each one gets its own seed from the stream, and the best scoring one is kept.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Grammar", meta = (ClampMin = "1"))
+	int32 CandidateCount;
+
+	// Should every non-overlapping rewrite found in a pass be applied at once?
+	// This needs far fewer matching passes on big missions, but gives different missions for the same seed.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Grammar")
+	bool bBatchRewrites;
+
+	// How candidates get scored. With no metrics, the first candidate is always kept.
+	UPROPERTY(EditAnywhere, Instanced, Category = "Dungeon Grammar")
+	TArray<UMissionCandidateMetric*> CandidateMetrics;
+
 	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeons|Missions")
 	void TryToCreateDungeon(FRandomStream& Stream);
 
@@ -59,26 +76,66 @@ public:
 
 
 protected:
-	void TryToCreateDungeon(UDungeonMissionNode* StartingLocation, TArray<const UDungeonMissionGrammar*> AllowedGrammars, 
-		FRandomStream& Rng, int32 RemainingMaxStepCount);
+	// Builds a whole mission into Candidate from the head symbol.
+	// This only reads from the generator, so candidates can be built on any thread.
+	void CreateCandidate(FMissionCandidate& Candidate, FRandomStream& Rng) const;
+
+	float ScoreCandidate(const FMissionCandidate& Candidate) const;
+
+	// Keeps rewriting nodes, starting from StartingLocation, until every node is terminal or unresolved.
+	// Each node can go through at most RemainingMaxStepCount rewrites, counting those of its parents.
+	void TryToCreateDungeon(FMissionCandidate& Candidate, int32 StartingLocation, 
+		const FDungeonMissionGrammarIndex& AllowedGrammars, FRandomStream& Rng, int32 RemainingMaxStepCount) const;
+
+	// Does the same as TryToCreateDungeon, but matches every non-terminal node in one pass and then
+	// applies all the rewrites which don't share nodes. Stops after MaxPassCount passes.
+	void TryToCreateDungeonInBatches(FMissionCandidate& Candidate, int32 StartingLocation,
+		const FDungeonMissionGrammarIndex& AllowedGrammars, FRandomStream& Rng, int32 MaxPassCount) const;
+
+	void FindNodeMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+		int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const;
+
+	void CheckGrammarMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+		const TArray<FGraphLink>& Links, int32 StartingLocation, bool bFoundMatches,
+		TArray<FGraphOutput>& OutAcceptableGrammars) const;
+
+	void FindMatchesWithChildren(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+		int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const;
+
+	// Finds every grammar whose input graph can be matched with its root at the starting location.
+	void FindPatternMatches(FMissionCandidate& Candidate, const FDungeonMissionGrammarIndex& AllowedGrammars,
+		int32 StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars) const;
+
+	// Adds an output for Grammar, weighted by how often the candidate has used it already.
+	FGraphOutput& AddAcceptableGrammar(const FMissionCandidate& Candidate, const FIndexedMissionGrammar& Grammar,
+		bool bFoundMatches, TArray<FGraphOutput>& OutAcceptableGrammars) const;
+
+	// Returns the index of a randomly picked acceptable grammar, or INDEX_NONE if none of them can be picked.
+	int32 ChooseGrammar(const TArray<FGraphOutput>& AcceptableGrammars, FRandomStream& Rng) const;
 
-	void FindNodeMatches(TArray<const UDungeonMissionGrammar*>& AllowedGrammars,
-		UDungeonMissionNode* StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars);
+	// Picks one of the acceptable grammars and uses it to replace the starting location.
+	// Returns false if none of them could be picked.
+	bool ReplaceDungeonNodes(FMissionCandidate& Candidate, int32 StartingLocation,
+		const TArray<FGraphOutput>& AcceptableGrammars, FRandomStream& Rng) const;
 
-	void CheckGrammarMatches(TArray<const UDungeonMissionGrammar*>& AllowedGrammars,
-		const TArray<FGraphLink>& Links, UDungeonMissionNode* StartingLocation, bool bFoundMatches,
-		TArray<FGraphOutput>& OutAcceptableGrammars);
+	// MatchedChild is the child of StartingLocation which was matched along with it, if any.
+	void ReplaceNodes(FMissionCandidate& Candidate, int32 StartingLocation, int32 MatchedChild,
+		const FGraphOutput& GrammarReplaceResult) const;
 
-	void FindMatchesWithChildren(TArray<const UDungeonMissionGrammar*>& AllowedGrammars,
-		UDungeonMissionNode* StartingLocation, TArray<FGraphOutput>& OutAcceptableGrammars);
+	// Rewrites all the nodes an input graph matched in one go.
+	void ReplaceSubgraph(FMissionCandidate& Candidate, const FGraphOutput& GrammarReplaceResult) const;
 
-	void ReplaceDungeonNodes(UDungeonMissionNode* StartingLocation,
-		TArray<FGraphOutput> AcceptableGrammars, FRandomStream& Rng);
+	// Adds everything under Head in the grammar's output graph. NodeMap has the mission node
+	// for each output node ID which already exists, and gets any new nodes added to it.
+	void AddOutputNodes(FMissionCandidate& Candidate, const FCompiledMissionGrammar* Grammar, int32 Head,
+		TMap<int32, int32>& NodeMap, const FString& InitialShape) const;
 
-	void ReplaceNodes(UDungeonMissionNode* StartingLocation,
-		const FGraphOutput& GrammarReplaceResult);
+	// Which of our grammars might match any given symbol.
+	FDungeonMissionGrammarIndex GrammarIndex;
 
-	TMap<FString, int32> GrammarUsageCount;
+	// Missions as they're being built. Nodes only become UDungeonMissionNodes once the best one is picked.
+	// These are kept between attempts so their memory can be reused.
+	TArray<FMissionCandidate> Candidates;
 
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "Dungeon Grammar")
 	TArray<UDungeonMissionNode*> UnresolvedHooks;
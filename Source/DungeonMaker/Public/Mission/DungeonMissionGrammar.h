@@ -1,6 +1,7 @@
 #pragma once
 
 #include "GraphGrammar.h"
+#include "CompiledMissionGrammar.h"
 
 #include "DungeonMissionGrammar.generated.h"
 
@@ -14,4 +15,20 @@ UCLASS(BlueprintType)
 class UDungeonMissionGrammar : public UGraphGrammar
 {
 	GENERATED_BODY()
+public:
+	// Returns the read-only copy of this grammar that mission generation uses.
+	// Should be called on the game thread; the copy it returns can be used from any thread.
+	FCompiledMissionGrammarPtr GetCompiledGrammar() const;
+	// Makes a fresh copy of this grammar for GetCompiledGrammar to return.
+	// This happens automatically on load and when the grammar is edited.
+	void CompileMissionGrammar() const;
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+protected:
+	// Never changed once it's made; a new one replaces it instead.
+	mutable FCompiledMissionGrammarPtr CompiledGrammar;
 };
\ No newline at end of file
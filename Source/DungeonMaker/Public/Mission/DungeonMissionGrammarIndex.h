@@ -0,0 +1,70 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "DungeonMissionGrammar.h"
+
+struct DUNGEONMAKER_API FIndexedMissionGrammar
+{
+	// Kept alive by the index it came from.
+	const FCompiledMissionGrammar* Grammar;
+	// Which output graph shape the grammar produces.
+	// IDs run from 0 up to the number of distinct shapes in the index.
+	int32 OutputGraphID;
+};
+
+/*
+* Looks up which mission grammars could possibly match a chain of links,
+* based on the first symbol in the chain and how the second link is coupled to it.
+* Everything it leaves out is guaranteed to be rejected by MatchesGrammar.
+* Candidates come back in the order the grammars were given in.
+*/
+struct DUNGEONMAKER_API FDungeonMissionGrammarIndex
+{
+private:
+	struct FCandidateGrammars
+	{
+		TArray<FIndexedMissionGrammar> Grammars[FCompiledGraphInputGrammar::CouplingCount];
+	};
+
+	int32 GrammarCount;
+	int32 OutputGraphCount;
+	// Holds on to every grammar we index, even if the assets get recompiled.
+	TArray<FCompiledMissionGrammarPtr> CompiledGrammars;
+	TMap<const UStateMachineSymbol*, FCandidateGrammars> SymbolCandidates;
+	// Used for symbols which no grammar looks at.
+	FCandidateGrammars UnknownSymbolCandidates;
+	// Grammars with input graphs, by the symbol of their root node.
+	TMap<const UGraphNode*, TArray<FIndexedMissionGrammar>> PatternCandidates;
+
+public:
+	FDungeonMissionGrammarIndex()
+	{
+		GrammarCount = 0;
+		OutputGraphCount = 0;
+	}
+
+	// Indexes the compiled form of each grammar, so must be called on the game thread.
+	// Grammars whose input states couldn't be compiled are treated as though they could match anything.
+	void Build(const TArray<const UDungeonMissionGrammar*>& Grammars);
+
+	int32 Num() const
+	{
+		return GrammarCount;
+	}
+
+	// How many distinct output graph shapes the indexed grammars have.
+	int32 NumOutputGraphs() const
+	{
+		return OutputGraphCount;
+	}
+
+	// Never includes grammars with input graphs.
+	const TArray<FIndexedMissionGrammar>& GetCandidates(const TArray<FGraphLink>& Links) const;
+	// Returns the grammars whose input graph has Symbol at its root, or NULL if there aren't any.
+	const TArray<FIndexedMissionGrammar>* GetPatternCandidates(const UGraphNode* Symbol) const
+	{
+		return PatternCandidates.Find(Symbol);
+	}
+};
@@ -0,0 +1,122 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "UObject/NoExportTypes.h"
+#include "Containers/ArrayView.h"
+#include "MissionGraph.h"
+#include "GraphOutputGrammar.h"
+#include "MissionCandidate.generated.h"
+
+/*
+* Everything one attempt at generating a mission keeps track of.
+* Candidates don't share anything that changes, so several can be built at once.
+*/
+struct DUNGEONMAKER_API FMissionCandidate
+{
+	FMissionGraph Graph;
+	int32 HeadNode;
+	TArray<int32> UnresolvedHookNodes;
+	// How many times each output graph has been used, indexed by graph ID.
+	TArray<int32> GrammarUsageCount;
+	// How many nodes can be reached from the head.
+	int32 NodeCount;
+	float Score;
+	// The links being matched right now. Kept here so matching reuses the same memory every time.
+	TArray<FGraphLink> MatchLinks;
+	// The same for the nodes matched by input graphs.
+	TArray<int32> MatchNodes;
+	// What every acceptable grammar found so far matched. Acceptable grammars point into these
+	// instead of keeping their own copies, so these only get reset along with them.
+	TArray<FGraphLink> MatchedLinkPool;
+	TArray<int32> MatchedNodePool;
+
+	FMissionCandidate()
+	{
+		HeadNode = FMissionGraph::NO_NODE;
+		NodeCount = 0;
+		Score = 0.0f;
+	}
+
+	void ResetMatches()
+	{
+		MatchedLinkPool.Reset();
+		MatchedNodePool.Reset();
+	}
+
+	TArrayView<const FGraphLink> GetMatchedLinks(const FGraphOutput& Output) const
+	{
+		return TArrayView<const FGraphLink>(MatchedLinkPool.GetData() + Output.FirstMatchedLink, Output.MatchedLinkCount);
+	}
+
+	TArrayView<const int32> GetMatchedNodes(const FGraphOutput& Output) const
+	{
+		return TArrayView<const int32>(MatchedNodePool.GetData() + Output.FirstMatchedNode, Output.MatchedNodeCount);
+	}
+};
+
+/**
+ * Scores a finished mission candidate. When a generator builds several candidates,
+ * the one with the highest total score across all its metrics gets used.
+ */
+UCLASS(Abstract, EditInlineNew)
+class DUNGEONMAKER_API UMissionCandidateMetric : public UObject
+{
+	GENERATED_BODY()
+public:
+	UMissionCandidateMetric();
+
+	// What the score from this metric gets multiplied by.
+	UPROPERTY(EditAnywhere, Category = "Mission Candidates")
+	float Weight;
+
+	virtual float ScoreCandidate(const FMissionCandidate& Candidate) const;
+};
+
+/**
+ * Prefers missions close to a target size.
+ * Set the target to about as many rooms as the dungeon space can hold.
+ */
+UCLASS()
+class DUNGEONMAKER_API UMissionSizeMetric : public UMissionCandidateMetric
+{
+	GENERATED_BODY()
+public:
+	UMissionSizeMetric();
+
+	UPROPERTY(EditAnywhere, Category = "Mission Candidates", meta = (ClampMin = "1"))
+	int32 TargetNodeCount;
+	// Going over the target is usually worse than falling short of it, since the extra rooms may not fit.
+	UPROPERTY(EditAnywhere, Category = "Mission Candidates")
+	float OverTargetPenalty;
+
+	virtual float ScoreCandidate(const FMissionCandidate& Candidate) const override;
+};
+
+/**
+ * Penalizes nodes with more children than a room can easily have neighbors.
+ */
+UCLASS()
+class DUNGEONMAKER_API UMissionBranchingMetric : public UMissionCandidateMetric
+{
+	GENERATED_BODY()
+public:
+	UMissionBranchingMetric();
+
+	UPROPERTY(EditAnywhere, Category = "Mission Candidates", meta = (ClampMin = "1"))
+	int32 MaxChildren;
+
+	virtual float ScoreCandidate(const FMissionCandidate& Candidate) const override;
+};
+
+/**
+ * Penalizes every node which no grammar could resolve.
+ */
+UCLASS()
+class DUNGEONMAKER_API UMissionUnresolvedHookMetric : public UMissionCandidateMetric
+{
+	GENERATED_BODY()
+public:
+	virtual float ScoreCandidate(const FMissionCandidate& Candidate) const override;
+};
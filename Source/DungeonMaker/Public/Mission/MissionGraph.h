@@ -0,0 +1,181 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphNode.h"
+
+class UDungeonMissionNode;
+
+struct DUNGEONMAKER_API FMissionGraphNode
+{
+	UGraphNode* NodeType;
+	int32 NodeID;
+	bool bTightlyCoupledToParent;
+	// The first and last entries of this node's child and parent lists, in FMissionGraph::Links.
+	int32 FirstChild;
+	int32 LastChild;
+	int32 FirstParent;
+	int32 LastParent;
+};
+
+/*
+* A mission graph made of plain structs, which refer to each other by index.
+*
+* This works the same way as a graph of UDungeonMissionNodes, but everything
+* lives in two flat arrays: one of nodes, and one of list entries for every
+* node's children and parents. Nothing here is a UObject, so rewriting the graph
+* creates no garbage and can happen off the game thread.
+*
+* Reset keeps all the memory around, so the next graph built in it doesn't need
+* to allocate anything until it outgrows the last one.
+*/
+struct DUNGEONMAKER_API FMissionGraph
+{
+public:
+	static const int32 NO_NODE = INDEX_NONE;
+
+private:
+	// One entry in a node's child or parent list.
+	struct FMissionGraphLink
+	{
+		int32 Node;
+		int32 Next;
+	};
+
+	TArray<FMissionGraphNode> Nodes;
+	TArray<FMissionGraphLink> Links;
+	// Entries which were removed from a list, ready to be used again.
+	int32 FirstFreeLink;
+
+	int32 AllocateLink(int32 Node);
+	void AppendLink(int32& First, int32& Last, int32 Node);
+	bool RemoveLink(int32& First, int32& Last, int32 Node);
+
+public:
+	FMissionGraph()
+	{
+		FirstFreeLink = NO_NODE;
+	}
+
+	// Empties the graph without freeing any memory.
+	void Reset()
+	{
+		Nodes.Reset();
+		Links.Reset();
+		FirstFreeLink = NO_NODE;
+	}
+
+	int32 Num() const
+	{
+		return Nodes.Num();
+	}
+
+	bool IsValidNode(int32 Node) const
+	{
+		return Nodes.IsValidIndex(Node);
+	}
+
+	// Returns the index of the new node, which has no links yet.
+	// Any references to other nodes may be invalidated by this.
+	int32 AddNode(UGraphNode* NodeType, int32 NodeID);
+
+	FMissionGraphNode& GetNode(int32 Node)
+	{
+		return Nodes[Node];
+	}
+
+	const FMissionGraphNode& GetNode(int32 Node) const
+	{
+		return Nodes[Node];
+	}
+
+	FNumberedGraphSymbol ToGraphSymbol(int32 Node) const
+	{
+		FNumberedGraphSymbol symbol;
+		symbol.Symbol = Nodes[Node].NodeType;
+		symbol.SymbolID = Nodes[Node].NodeID;
+		return symbol;
+	}
+
+	// Calls Func with the index of each child of Node, in the order they were added.
+	template<typename FuncType>
+	void ForEachChild(int32 Node, FuncType Func) const
+	{
+		for (int32 link = Nodes[Node].FirstChild; link != NO_NODE; link = Links[link].Next)
+		{
+			Func(Links[link].Node);
+		}
+	}
+
+	// Calls Func with the index of each parent of Node, in the order they were added.
+	template<typename FuncType>
+	void ForEachParent(int32 Node, FuncType Func) const
+	{
+		for (int32 link = Nodes[Node].FirstParent; link != NO_NODE; link = Links[link].Next)
+		{
+			Func(Links[link].Node);
+		}
+	}
+
+	bool HasChildren(int32 Node) const
+	{
+		return Nodes[Node].FirstChild != NO_NODE;
+	}
+
+	bool HasChild(int32 Parent, int32 Child) const
+	{
+		for (int32 link = Nodes[Parent].FirstChild; link != NO_NODE; link = Links[link].Next)
+		{
+			if (Links[link].Node == Child)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	int32 NumChildren(int32 Node) const
+	{
+		int32 count = 0;
+		for (int32 link = Nodes[Node].FirstChild; link != NO_NODE; link = Links[link].Next)
+		{
+			count++;
+		}
+		return count;
+	}
+
+	int32 NumParents(int32 Node) const
+	{
+		int32 count = 0;
+		for (int32 link = Nodes[Node].FirstParent; link != NO_NODE; link = Links[link].Next)
+		{
+			count++;
+		}
+		return count;
+	}
+
+	// Appends the children of Node to OutChildren.
+	void GetChildren(int32 Node, TArray<int32>& OutChildren) const
+	{
+		ForEachChild(Node, [&OutChildren](int32 Child)
+		{
+			OutChildren.Add(Child);
+		});
+	}
+
+	// Finds the child with the same symbol and ID, or NO_NODE if there isn't one.
+	int32 FindChildNodeFromSymbol(int32 Parent, const FNumberedGraphSymbol& ChildSymbol) const;
+	// Works the same as UDungeonMissionNode::AddLinkToNode.
+	void AddLinkToNode(int32 Parent, int32 NewChild, bool bTightlyCoupled);
+	// Works the same as UDungeonMissionNode::BreakLinkWithNode.
+	void BreakLinkWithNode(int32 Parent, int32 Child);
+
+	FString GetSymbolDescription(int32 Node) const;
+	FString ToString(int32 Node, int32 IndentLevel = 4, bool bPrintChildren = true) const;
+
+	// Creates a UDungeonMissionNode for every node which can be reached from Head,
+	// linked up the same way. OutNodes gets the UObject for each node index, or NULL
+	// for nodes which weren't reachable.
+	UDungeonMissionNode* CreateMissionNodes(int32 Head, TArray<UDungeonMissionNode*>& OutNodes) const;
+};
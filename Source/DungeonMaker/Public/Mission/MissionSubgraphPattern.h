@@ -0,0 +1,82 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+#include "GraphNode.h"
+#include "MissionGraph.h"
+
+struct FCompiledOutputNode;
+
+/*
+* The input graph of a mission grammar, ready to be found in a mission graph.
+*
+* The node with ID 1 is pinned to the node being rewritten, and every other node
+* must be reachable from it through its children. Nodes get matched one at a time,
+* each through a parent which is already matched. A mission node is only tried if it
+* has the right symbol, the right coupling, at least as many children and parents as
+* the pattern node, and every link the pattern node has to nodes matched so far.
+*/
+struct DUNGEONMAKER_API FMissionSubgraphPattern
+{
+private:
+	struct FPatternNode
+	{
+		UGraphNode* NodeType;
+		int32 NodeID;
+		bool bTightlyCoupledToParent;
+		TArray<int32> Children;
+		TArray<int32> Parents;
+	};
+
+	TArray<FPatternNode> Nodes;
+	// The order nodes get matched in, starting with the root.
+	TArray<int32> MatchOrder;
+	// The parent each node in MatchOrder is found through; the root has none.
+	TArray<int32> MatchParents;
+
+	bool CanMatch(const FMissionGraph& Graph, int32 PatternNode, int32 Node, const TArray<int32>& MatchedNodes) const;
+	bool MatchFrom(const FMissionGraph& Graph, int32 Step, TArray<int32>& MatchedNodes) const;
+
+public:
+	// Takes the nodes of a compiled input graph. Returns false, leaving the pattern empty,
+	// if there's no node with ID 1 or some node can't be reached from it.
+	bool Compile(const TArray<FCompiledOutputNode>& GraphNodes);
+
+	void Reset()
+	{
+		Nodes.Reset();
+		MatchOrder.Reset();
+		MatchParents.Reset();
+	}
+
+	bool IsValid() const
+	{
+		return Nodes.Num() > 0;
+	}
+
+	int32 Num() const
+	{
+		return Nodes.Num();
+	}
+
+	const UGraphNode* GetRootSymbol() const
+	{
+		return Nodes[MatchOrder[0]].NodeType;
+	}
+
+	int32 GetNodeID(int32 PatternNode) const
+	{
+		return Nodes[PatternNode].NodeID;
+	}
+
+	const TArray<int32>& GetChildren(int32 PatternNode) const
+	{
+		return Nodes[PatternNode].Children;
+	}
+
+	// Tries to match the pattern with its root at Root. On success, OutMatchedNodes holds
+	// the mission node matched to each pattern node. Matches are tried in child order, so
+	// the same graph always gives the same match. Doesn't allocate once OutMatchedNodes is big enough.
+	bool Match(const FMissionGraph& Graph, int32 Root, TArray<int32>& OutMatchedNodes) const;
+};
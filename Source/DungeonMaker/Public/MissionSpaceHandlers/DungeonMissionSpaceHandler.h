@@ -13,6 +13,66 @@
 
 class UDungeonSpaceGenerator;
 
+UENUM(BlueprintType)
+enum class EMissionSpaceFeasibility : uint8
+{
+	// Nothing rules the mission out; it may still fail to be placed.
+	Feasible,
+	// The mission has more nodes than the space generator is allowed to make rooms (MaxGeneratedRooms).
+	NotEnoughRooms,
+	// A node's symbol has no room types, so it can never be given a room.
+	MissingRoomType,
+	// A node has more tightly-coupled children than it has neighboring rooms.
+	TooManyTightlyCoupledChildren,
+	// A group of tightly-coupled nodes is larger than a single floor.
+	TightlyCoupledGroupTooLarge,
+	FeasibilityCount UMETA(Hidden)
+};
+
+USTRUCT(BlueprintType)
+struct DUNGEONMAKER_API FMissionSpaceFeasibilityStats
+{
+	GENERATED_BODY()
+
+public:
+	// How many missions have been checked.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	int32 CheckCount;
+	// How many missions were rejected for each reason, indexed by EMissionSpaceFeasibility.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly)
+	TArray<int32> RejectionCounts;
+
+	FMissionSpaceFeasibilityStats()
+	{
+		CheckCount = 0;
+		RejectionCounts.Init(0, (int32)EMissionSpaceFeasibility::FeasibilityCount);
+	}
+
+	void Record(EMissionSpaceFeasibility Result)
+	{
+		CheckCount++;
+		if (Result != EMissionSpaceFeasibility::Feasible)
+		{
+			RejectionCounts[(int32)Result]++;
+		}
+	}
+
+	int32 GetRejectionCount(EMissionSpaceFeasibility Reason) const
+	{
+		return RejectionCounts[(int32)Reason];
+	}
+
+	int32 GetTotalRejectionCount() const
+	{
+		int32 total = 0;
+		for (int32 count : RejectionCounts)
+		{
+			total += count;
+		}
+		return total;
+	}
+};
+
 USTRUCT(BlueprintType)
 struct DUNGEONMAKER_API FRoomPairing
 {
@@ -111,12 +171,19 @@ public:
 		ProcessedNodes.Remove(Node);
 	}
 
-	void AddOpenRooms(TMap<FIntVector, FIntVector> MoreOpenRooms)
+	void MarkAsUnprocessed(FIntVector RoomLocation)
 	{
-		OpenRooms.Append(MoreOpenRooms);
+		ProcessedRooms.Remove(RoomLocation);
 	}
 };
 
+// Where to roll back to in order to undo rooms placed by a mission space handler.
+struct DUNGEONMAKER_API FMissionSpaceRoomSavepoint
+{
+	int32 SpaceSavepoint;
+	int32 RoomCount;
+};
+
 /*
 * This is a class which takes a DungeonMission and converts it into a DungeonFloor, representing
 * the space in the level.
@@ -147,15 +214,26 @@ public:
 	bool CreateDungeonSpace(UDungeonMissionNode* Head, FIntVector StartLocation,
 		int32 SymbolCount, FRandomStream& Rng);
 
+	// A quick check for missions which could never be placed in our space, run before trying to place them.
+	// Passing doesn't mean the mission will fit, but failing means it never will.
+	// Subclasses should add any limits of their own on top of these.
+	virtual EMissionSpaceFeasibility CheckMissionFeasibility(UDungeonMissionNode* Head, int32 SymbolCount) const;
+
 protected:
-	TSet<FIntVector> GetAvailableLocations(FIntVector Location, TSet<FIntVector> IgnoredLocations = TSet<FIntVector>());
+	TSet<FIntVector> GetAvailableLocations(FIntVector Location, const TSet<FIntVector>& IgnoredLocations = TSet<FIntVector>());
 	FFloorRoom MakeFloorRoom(UDungeonMissionNode* Node, FIntVector Location,
 		FRandomStream& Rng, int32 TotalSymbolCount);
 	void SetRoom(FFloorRoom Room, bool bShouldIncrementRoomCount = true);
 	virtual void GenerateDungeonRooms(UDungeonMissionNode* Head, FIntVector StartLocation, FRandomStream &Rng, int32 SymbolCount);
 	void ProcessRoomNeighbors();
-	virtual FRoomPairing GetOpenRoom(UDungeonMissionNode* Node, TMap<FIntVector, FIntVector>& AvailableRooms, FMissionSpaceHelper& SpaceHelper);
+	// Picks a random room out of AvailableRooms which isn't in TriedRooms, and adds every room it looks at to TriedRooms.
+	virtual FRoomPairing GetOpenRoom(UDungeonMissionNode* Node, const TMap<FIntVector, FIntVector>& AvailableRooms,
+		TSet<FIntVector>& TriedRooms, FMissionSpaceHelper& SpaceHelper);
 	virtual void UpdateNeighbors(const FRoomPairing& RoomPairing, bool bIsTightCoupling);
-	bool CheckInputIsValid(TMap<FIntVector, FIntVector> &AvailableRooms, bool bIsTightCoupling, UDungeonMissionNode* Node, FMissionSpaceHelper &SpaceHelper);
-	bool CheckCanSkipProcessing(UDungeonMissionNode* Node, FMissionSpaceHelper &SpaceHelper);
+
+	// Lets a handler undo only the rooms it placed after this point, instead of starting over.
+	// Only works during CreateDungeonSpace, which journals everything written to the space.
+	FMissionSpaceRoomSavepoint CreateRoomSavepoint();
+	// Removes every room placed since the savepoint, along with their neighbors.
+	void RollbackRooms(const FMissionSpaceRoomSavepoint& Savepoint);
 };
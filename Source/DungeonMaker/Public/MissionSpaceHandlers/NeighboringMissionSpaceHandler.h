@@ -14,13 +14,58 @@ UCLASS()
 class DUNGEONMAKER_API UNeighboringMissionSpaceHandler : public UDungeonMissionSpaceHandler
 {
 	GENERATED_BODY()
+
+public:
+	// When a node has nowhere left to go, the room placed before it gets moved somewhere else.
+	// This is how many times that can happen before we give up on the mission.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, meta = (ClampMin = "0"))
+	int32 MaxBacktrackCount = 1000;
+
+	virtual EMissionSpaceFeasibility CheckMissionFeasibility(UDungeonMissionNode* Head, int32 SymbolCount) const override;
 	
 protected:
 	virtual void GenerateDungeonRooms(UDungeonMissionNode* Head, FIntVector StartLocation, FRandomStream &Rng, int32 SymbolCount) override;
 	
 private:
-	bool PairNodesToRooms(UDungeonMissionNode* Node, TMap<FIntVector, FIntVector>& AvailableRooms,
-		FMissionSpaceHelper& SpaceHelper, bool bIsTightCoupling, int32 TotalSymbolCount);
+	// One node in the order rooms get placed in.
+	struct FPlacementStep
+	{
+		UDungeonMissionNode* Node;
+		// The step which placed the parent a tightly-coupled node has to be next to, or INDEX_NONE.
+		int32 AnchorStep;
+	};
+
+	// A room which has been placed, along with the rooms it could still be moved to.
+	struct FPlacementFrame
+	{
+		// Only filled in for tightly-coupled steps; loose steps pick from the open rooms.
+		TMap<FIntVector, FIntVector> CandidateRooms;
+		// Every room tried is kept here, so going back to this step always picks somewhere new.
+		TSet<FIntVector> TriedRooms;
+		FRoomPairing Room;
+		// Where the undo log and the dungeon space were before this room was placed.
+		int32 UndoLogSize;
+		FMissionSpaceRoomSavepoint RoomSavepoint;
+	};
+
+	// What an open room was mapped to before it was changed, so the change can be undone.
+	struct FOpenRoomChange
+	{
+		FIntVector Location;
+		FIntVector PreviousParent;
+		bool bWasOpen;
+	};
+
+	// Parents always come before their children, and tightly-coupled children come right after their parents.
+	void BuildPlacementOrder(UDungeonMissionNode* Head, TArray<FPlacementStep>& OutSteps) const;
+
+	void PlaceRoom(const FPlacementStep& Step, FPlacementFrame& Frame, const FRoomPairing& Room,
+		FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog, int32 TotalSymbolCount);
+	// Undoes everything PlaceRoom did, leaving the frame's remaining candidates alone.
+	void UndoPlacement(const FPlacementStep& Step, const FPlacementFrame& Frame,
+		FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog);
+	void SetOpenRoom(FIntVector Location, FIntVector Parent, bool bIsOpen, FMissionSpaceHelper& SpaceHelper, TArray<FOpenRoomChange>& UndoLog);
 
-	TMap<FIntVector, FIntVector> GetRoomNeighbors(FIntVector nextLocation, FMissionSpaceHelper &SpaceHelper);
+	// Adds every unprocessed room next to RoomLocation to OutNeighbors, with RoomLocation as their parent.
+	void GetRoomNeighbors(FIntVector RoomLocation, FMissionSpaceHelper& SpaceHelper, TMap<FIntVector, FIntVector>& OutNeighbors);
 };
@@ -10,6 +10,17 @@
 
 class ADungeonRoom;
 
+/*
+* A single piece of ground scatter that was placed on a tile.
+* Either Actor is set, or MeshComponent and InstanceIndex are.
+*/
+struct FPlacedGroundScatter
+{
+	TWeakObjectPtr<AActor> Actor;
+	TWeakObjectPtr<UHierarchicalInstancedStaticMeshComponent> MeshComponent;
+	int32 InstanceIndex;
+};
+
 /*
 * This class is dedicated to spawning in ground scatter in a room.
 * Tiles are defined, with sets of ground scatter that should be spawned on that particular tile.
@@ -33,12 +44,21 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadWrite, Category = "Props")
 	TMap<UStaticMesh*, UHierarchicalInstancedStaticMeshComponent*> StaticMeshes;
 
+private:
+	// Everything we've placed, keyed by the tile it was placed on
+	TMap<FIntVector, TArray<FPlacedGroundScatter>> PlacedScatter;
+	// Instances which were cleared and can be reused
+	TMap<UHierarchicalInstancedStaticMeshComponent*, TArray<int32>> FreeInstances;
+
 public:
 	void DetermineGroundScatter(TMap<const UDungeonTile*, TArray<FIntVector>> TileLocations,
 		FRandomStream& Rng, ADungeonRoom* Room);
 
 	AActor* SpawnScatterActor(ADungeonRoom* Room, const FIntVector& Location,
 		const UGroundScatterItem* Scatter, FRandomStream& Rng);
+
+	// Removes all ground scatter placed on tiles from Min (inclusive) to Max (exclusive).
+	void ClearGroundScatter(const FIntVector& Min, const FIntVector& Max);
 private:
 	void ProcessScatterItem(const UGroundScatterItem* Scatter, const TArray<FIntVector>& TileLocations, 
 		FRandomStream& Rng, const UDungeonTile* Tile, ADungeonRoom* Room);
@@ -23,7 +23,15 @@ public:
 	TArray<UHierarchicalInstancedStaticMeshComponent*> MeshComponents;
 	UPROPERTY(BlueprintReadOnly, VisibleInstanceOnly)
 	const UDungeonTile* MeshTile;
+
+private:
+	// Instances which were removed and can be reused, one list per mesh component.
+	// Removing an instance outright would shift the index of every instance after it.
+	TArray<TArray<int32>> FreeInstances;
+
 public:
 	void SetStaticMesh(const UDungeonTile* Tile, TArray<FDungeonTileMesh> Mesh);
 	int32 AddInstance(int32 MeshIndex, const FTransform& Transform);
+	// Hides the given instance so a later AddInstance can reuse it.
+	void RemoveInstance(int32 MeshIndex, int32 InstanceIndex);
 };
@@ -38,6 +38,11 @@ public:
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dungeon")
 	bool bChooseRandomSeedAtRuntime = false;
 
+	// Should generated dungeons be saved to disk?
+	// If a dungeon with the same seed and settings was already saved, it gets loaded instead of generated.
+	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dungeon")
+	bool bCacheGeneratedDungeons = false;
+
 public:
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
 	TSet<FIntVector> GetAllTilesOfType(ETileType Type) const;
@@ -45,4 +50,7 @@ public:
 protected:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
+
+	// Gets where a dungeon made from the given seed and our current settings gets cached.
+	FString GetDungeonCachePath(int32 DungeonSeed) const;
 };
@@ -36,6 +36,7 @@ public:
 
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dungeon")
 	TSubclassOf<UDungeonMissionSpaceHandler> MissionToSpaceHandlerClass;
+	// Missions with more nodes than this are rejected before placing them. -1 means there's no limit.
 	UPROPERTY(BlueprintReadWrite, EditAnywhere, Category = "Dungeon")
 	int32 MaxGeneratedRooms;
 	UPROPERTY(EditInstanceOnly, BlueprintReadOnly, Category = "Debug")
@@ -79,9 +80,19 @@ public:
 
 	UPROPERTY(BlueprintReadOnly, VisibleInstanceOnly, Category = "Dungeon")
 	TArray<UDungeonFloorManager*> Floors;
+
+	// How many missions were turned away before we tried placing them, and why.
+	UPROPERTY(BlueprintReadOnly, VisibleInstanceOnly, Category = "Debug")
+	FMissionSpaceFeasibilityStats FeasibilityStats;
 public:	
 	bool CreateDungeonSpace(UDungeonMissionNode* Head, int32 SymbolCount, FRandomStream& Rng);
 
+	// Writes the generated dungeon out in the binary dungeon format.
+	bool SaveDungeonSpace(const FString& FilePath) const;
+	// Builds the dungeon from a file written by SaveDungeonSpace instead of generating it.
+	// Returns false (without spawning anything) if the file is missing or can't be used.
+	bool LoadDungeonSpace(const FString& FilePath, FRandomStream& Rng);
+
 	bool IsLocationValid(FIntVector FloorSpaceCoordinates);
 	TArray<FFloorRoom> GetAllNeighbors(FFloorRoom Room);
 	void SetRoom(FFloorRoom Room);
@@ -93,11 +104,21 @@ public:
 
 	void DrawDebugSpace();
 
+	// Rebuilds meshes, ground scatter, and debug drawing for any tiles
+	// which have changed since the dungeon was last built.
+	// Call this after changing tiles once the dungeon has been generated.
+	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeon Generation|Tiles")
+	void RebuildDirtyRegions(FRandomStream& Rng);
+
 protected:
 	// Determines how rooms will be placed relative to one another
 	bool CreateLowResMap(int32 SymbolCount, UDungeonMissionNode* Head, FRandomStream& Rng);
 	// Spawns the actual tiles for each room
 	void CreateTilemap(FRandomStream& Rng);
+	// Creates an empty floor manager for each floor of the dungeon space.
+	void CreateFloorManagers();
 	// Places all physical meshes for the room.
 	void PlaceMeshes(FRandomStream& Rng);
+	// Makes sure every tile passed in has somewhere to put its meshes.
+	void CreateTileMeshActors(const TSet<const UDungeonTile*>& Tiles);
 };
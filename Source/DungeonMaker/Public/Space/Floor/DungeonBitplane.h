@@ -0,0 +1,250 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonTile.h"
+
+/*
+* A single bit for every tile on a floor, packed 64 tiles to a word.
+* Every row starts on a fresh word, so row queries never straddle rows
+* and bits past the end of a row are always 0.
+*/
+struct DUNGEONMAKER_API FDungeonBitplane
+{
+private:
+	TArray<uint64> Words;
+	int32 Width;
+	int32 Height;
+	int32 WordsPerRow;
+
+	// Counts how many of the lowest bits are set before the first unset bit.
+	static int32 CountTrailingOnes(uint64 Bits)
+	{
+		// Adding 1 clears exactly the trailing ones, so only they survive the mask
+		return FPlatformMath::CountBits(Bits & ~(Bits + 1));
+	}
+
+public:
+	FDungeonBitplane()
+	{
+		Words = TArray<uint64>();
+		Width = 0;
+		Height = 0;
+		WordsPerRow = 0;
+	}
+
+	FDungeonBitplane(int32 XSize, int32 YSize)
+	{
+		check(XSize >= 0 && YSize >= 0);
+		Width = XSize;
+		Height = YSize;
+		WordsPerRow = FMath::DivideAndRoundUp(Width, 64);
+		Words = TArray<uint64>();
+		Words.SetNumZeroed(WordsPerRow * Height);
+	}
+
+	int32 XSize() const
+	{
+		return Width;
+	}
+
+	int32 YSize() const
+	{
+		return Height;
+	}
+
+	bool IsValidLocation(int32 X, int32 Y) const
+	{
+		return X >= 0 && Y >= 0 && X < Width && Y < Height;
+	}
+
+	// Locations outside of the plane always read as unset.
+	bool Get(int32 X, int32 Y) const
+	{
+		if (!IsValidLocation(X, Y))
+		{
+			return false;
+		}
+		return (Words[Y * WordsPerRow + X / 64] >> (X % 64)) & 1;
+	}
+
+	void Set(int32 X, int32 Y, bool bValue)
+	{
+		check(IsValidLocation(X, Y));
+		uint64& word = Words[Y * WordsPerRow + X / 64];
+		uint64 bit = 1ull << (X % 64);
+		if (bValue)
+		{
+			word |= bit;
+		}
+		else
+		{
+			word &= ~bit;
+		}
+	}
+
+	void Reset()
+	{
+		FMemory::Memzero(Words.GetData(), Words.Num() * sizeof(uint64));
+	}
+
+	// Gets up to 64 bits starting at (X, Y). Bit 0 of the result is (X, Y) itself.
+	// Anything past the end of the row (or past Count) is 0.
+	uint64 GetRowBits(int32 X, int32 Y, int32 Count = 64) const
+	{
+		if (Y < 0 || Y >= Height || X < 0 || X >= Width || Count <= 0)
+		{
+			return 0;
+		}
+		int32 wordIndex = X / 64;
+		int32 shift = X % 64;
+		const uint64* row = Words.GetData() + (Y * WordsPerRow);
+		uint64 bits = row[wordIndex] >> shift;
+		if (shift > 0 && wordIndex + 1 < WordsPerRow)
+		{
+			bits |= row[wordIndex + 1] << (64 - shift);
+		}
+		if (Count < 64)
+		{
+			bits &= (1ull << Count) - 1;
+		}
+		return bits;
+	}
+
+	// Counts the set bits on row Y, from StartX up to (but not including) EndX.
+	int32 CountRowSpan(int32 Y, int32 StartX, int32 EndX) const
+	{
+		StartX = FMath::Max(StartX, 0);
+		EndX = FMath::Min(EndX, Width);
+		int32 count = 0;
+		for (int x = StartX; x < EndX; x += 64)
+		{
+			count += FPlatformMath::CountBits(GetRowBits(x, Y, EndX - x));
+		}
+		return count;
+	}
+
+	// Starting at (X, Y), finds where the run of set bits on that row ends.
+	// Returns X if (X, Y) itself is unset.
+	int32 FindSpanEnd(int32 X, int32 Y) const
+	{
+		while (X < Width)
+		{
+			int32 run = CountTrailingOnes(GetRowBits(X, Y));
+			X += run;
+			if (run < 64)
+			{
+				break;
+			}
+		}
+		return FMath::Min(X, Width);
+	}
+
+	// Starting at (X, Y), finds the next set bit on that row.
+	// Returns the width of the plane if there are none.
+	int32 FindNextSetBit(int32 X, int32 Y) const
+	{
+		while (X < Width)
+		{
+			uint64 bits = GetRowBits(X, Y);
+			if (bits != 0)
+			{
+				// Isolate the lowest set bit; everything below it is a trailing zero
+				return X + FPlatformMath::CountBits((bits & (~bits + 1)) - 1);
+			}
+			X += 64;
+		}
+		return Width;
+	}
+
+	// Counts the set bits inside the rectangle from Min (inclusive) to Max (exclusive).
+	int32 CountInRect(const FIntVector& Min, const FIntVector& Max) const
+	{
+		int32 count = 0;
+		for (int y = FMath::Max(Min.Y, 0); y < FMath::Min(Max.Y, Height); y++)
+		{
+			count += CountRowSpan(y, Min.X, Max.X);
+		}
+		return count;
+	}
+
+	int32 CountSetBits() const
+	{
+		int32 count = 0;
+		for (int i = 0; i < Words.Num(); i++)
+		{
+			count += FPlatformMath::CountBits(Words[i]);
+		}
+		return count;
+	}
+
+	// Gets the 3x3 neighborhood around (X, Y) as a 9-bit mask.
+	// Bit ((dY + 1) * 3) + (dX + 1) is set if (X + dX, Y + dY) is set, so bit 4 is the center.
+	uint16 GetNeighborhoodMask(int32 X, int32 Y) const
+	{
+		uint16 mask = 0;
+		for (int dY = -1; dY <= 1; dY++)
+		{
+			uint64 rowBits;
+			if (X > 0)
+			{
+				rowBits = GetRowBits(X - 1, Y + dY, 3);
+			}
+			else
+			{
+				// No left neighbor; shift the row over so the center stays at bit 1
+				rowBits = GetRowBits(X, Y + dY, 2) << 1;
+			}
+			mask |= (uint16)(rowBits << ((dY + 1) * 3));
+		}
+		return mask;
+	}
+};
+
+/*
+* One bit per tile for the properties most algorithms care about.
+* FDungeonSpace keeps these in sync whenever a tile changes, so things
+* like flood fills and adjacency tests never need to look at the tiles themselves.
+*/
+struct DUNGEONMAKER_API FDungeonFloorBitplanes
+{
+public:
+	// Tiles that can be walked on (floors and entrances).
+	FDungeonBitplane Walkable;
+	FDungeonBitplane Wall;
+	FDungeonBitplane Entrance;
+	// Tiles that belong to a room.
+	FDungeonBitplane Occupied;
+
+	FDungeonFloorBitplanes()
+	{
+	}
+
+	FDungeonFloorBitplanes(int32 XSize, int32 YSize)
+	{
+		Walkable = FDungeonBitplane(XSize, YSize);
+		Wall = FDungeonBitplane(XSize, YSize);
+		Entrance = FDungeonBitplane(XSize, YSize);
+		Occupied = FDungeonBitplane(XSize, YSize);
+	}
+
+	// Occupied is passed in separately, since tiles don't know which room they belong to.
+	void SetTile(int32 X, int32 Y, const UDungeonTile* Tile, bool bOccupied)
+	{
+		ETileType type = Tile == NULL ? ETileType::Floor : Tile->TileType;
+		Walkable.Set(X, Y, Tile != NULL && (type == ETileType::Floor || type == ETileType::Entrance));
+		Wall.Set(X, Y, Tile != NULL && type == ETileType::Wall);
+		Entrance.Set(X, Y, Tile != NULL && type == ETileType::Entrance);
+		Occupied.Set(X, Y, bOccupied);
+	}
+
+	void Reset()
+	{
+		Walkable.Reset();
+		Wall.Reset();
+		Entrance.Reset();
+		Occupied.Reset();
+	}
+};
@@ -5,9 +5,11 @@
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
 #include "Engine/StaticMesh.h"
+#include "Templates/Atomic.h"
 #include "NoExportTypes.h"
 
 #include "DungeonTile.h"
+#include "DungeonBitplane.h"
 #include "DungeonMissionNode.h"
 #include "GraphNode.h"
 
@@ -16,6 +18,131 @@
 class ADungeonRoom;
 struct FLowResDungeonFloor;
 
+/*
+* A set of rooms neighboring a single room.
+* Neighbors are nearly always in one of the 26 cells surrounding the room, so those
+* are stored as one bit per direction. Anything further away goes in a small overflow list,
+* which stays empty (and unallocated) for almost every room.
+*/
+USTRUCT()
+struct DUNGEONMAKER_API FFloorRoomNeighbors
+{
+	GENERATED_BODY()
+
+private:
+	// Bit N is set if the room in direction N is a neighbor.
+	UPROPERTY()
+	uint32 DirectionMask;
+	// Neighbors which aren't in any of the surrounding cells.
+	UPROPERTY()
+	TArray<FIntVector> DistantNeighbors;
+
+public:
+	static const int32 DIRECTION_COUNT = 26;
+
+	FFloorRoomNeighbors()
+	{
+		DirectionMask = 0;
+		DistantNeighbors = TArray<FIntVector>();
+	}
+
+	// Gets the direction of a cell relative to a room, or INDEX_NONE if the cell
+	// isn't one of the 26 cells touching the room.
+	static int32 ToDirection(const FIntVector& Offset)
+	{
+		if (Offset == FIntVector::ZeroValue || FMath::Abs(Offset.X) > 1 || FMath::Abs(Offset.Y) > 1 || FMath::Abs(Offset.Z) > 1)
+		{
+			return INDEX_NONE;
+		}
+		int32 cell = (Offset.Z + 1) * 9 + (Offset.Y + 1) * 3 + (Offset.X + 1);
+		// Cell 13 is the room itself, so everything after it shifts down by one
+		return cell > 13 ? cell - 1 : cell;
+	}
+
+	static FIntVector ToOffset(int32 Direction)
+	{
+		check(Direction >= 0 && Direction < DIRECTION_COUNT);
+		int32 cell = Direction >= 13 ? Direction + 1 : Direction;
+		return FIntVector(cell % 3 - 1, (cell / 3) % 3 - 1, cell / 9 - 1);
+	}
+
+	// Returns true if the neighbor wasn't already in the set.
+	bool Add(const FIntVector& Origin, const FIntVector& Neighbor)
+	{
+		int32 direction = ToDirection(Neighbor - Origin);
+		if (direction != INDEX_NONE)
+		{
+			uint32 bit = 1u << direction;
+			bool bIsNew = (DirectionMask & bit) == 0;
+			DirectionMask |= bit;
+			return bIsNew;
+		}
+		if (DistantNeighbors.Contains(Neighbor))
+		{
+			return false;
+		}
+		DistantNeighbors.Add(Neighbor);
+		return true;
+	}
+
+	void Remove(const FIntVector& Origin, const FIntVector& Neighbor)
+	{
+		int32 direction = ToDirection(Neighbor - Origin);
+		if (direction != INDEX_NONE)
+		{
+			DirectionMask &= ~(1u << direction);
+		}
+		else
+		{
+			DistantNeighbors.RemoveSingleSwap(Neighbor);
+		}
+	}
+
+	bool Contains(const FIntVector& Origin, const FIntVector& Neighbor) const
+	{
+		int32 direction = ToDirection(Neighbor - Origin);
+		if (direction != INDEX_NONE)
+		{
+			return (DirectionMask & (1u << direction)) != 0;
+		}
+		return DistantNeighbors.Contains(Neighbor);
+	}
+
+	int32 Num() const
+	{
+		return FPlatformMath::CountBits(DirectionMask) + DistantNeighbors.Num();
+	}
+
+	// Calls Function with the location of every neighbor.
+	template<typename FunctionType>
+	void ForEach(const FIntVector& Origin, FunctionType Function) const
+	{
+		uint32 mask = DirectionMask;
+		while (mask != 0)
+		{
+			// Isolate the lowest set bit; everything below it is a trailing zero
+			int32 direction = FPlatformMath::CountBits((mask & (~mask + 1)) - 1);
+			mask &= mask - 1;
+			Function(Origin + ToOffset(direction));
+		}
+		for (const FIntVector& neighbor : DistantNeighbors)
+		{
+			Function(neighbor);
+		}
+	}
+
+	TSet<FIntVector> ToSet(const FIntVector& Origin) const
+	{
+		TSet<FIntVector> neighbors;
+		neighbors.Reserve(Num());
+		ForEach(Origin, [&neighbors](const FIntVector& Neighbor)
+		{
+			neighbors.Add(Neighbor);
+		});
+		return neighbors;
+	}
+};
+
 /*
 * This represents a room which will get spawned on this floor.
 * It also contains data about which rooms will neighbor this room.
@@ -35,12 +162,6 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
 	FIntVector Location;
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
-	TSet<FIntVector> NeighboringRooms;
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
-	TSet<FIntVector> NeighboringTightlyCoupledRooms;
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
-	FIntVector IncomingRoom;
-	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
 	int32 MaxRoomSize;
 
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
@@ -50,25 +171,131 @@ public:
 	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly)
 	FNumberedGraphSymbol DungeonSymbol;
 
+private:
+	// Neighbors are stored relative to Location.
+	// Blueprints can get at them through UDungeonFloorHelpers.
+	UPROPERTY()
+	FFloorRoomNeighbors Neighbors;
+	UPROPERTY()
+	FFloorRoomNeighbors TightlyCoupledNeighbors;
+	// The direction of the room we came from, or NO_DIRECTION if there isn't one.
+	UPROPERTY()
+	uint8 IncomingDirection;
+
+	FFloorRoomNeighbors& GetNeighborSet(bool bIsTightlyCoupled)
+	{
+		return bIsTightlyCoupled ? TightlyCoupledNeighbors : Neighbors;
+	}
+
+	const FFloorRoomNeighbors& GetNeighborSet(bool bIsTightlyCoupled) const
+	{
+		return bIsTightlyCoupled ? TightlyCoupledNeighbors : Neighbors;
+	}
+
+public:
+	static const uint8 NO_DIRECTION = MAX_uint8;
+
 	FFloorRoom()
 	{
 		RoomClass = NULL;
 		RoomNode = NULL;
 		Location = FIntVector(-1, -1, -1);
-		NeighboringRooms = TSet<FIntVector>();
-		NeighboringTightlyCoupledRooms = TSet<FIntVector>();
-		IncomingRoom = FIntVector::ZeroValue;
+		Neighbors = FFloorRoomNeighbors();
+		TightlyCoupledNeighbors = FFloorRoomNeighbors();
+		IncomingDirection = NO_DIRECTION;
 		Difficulty = 0.0f;
 		MaxRoomSize = -1;
 		SpawnedRoom = NULL;
 		DungeonSymbol = FNumberedGraphSymbol();
 	}
 
+	// Returns true if the neighbor wasn't already a neighbor of this type.
+	bool AddNeighbor(const FIntVector& Neighbor, bool bIsTightlyCoupled)
+	{
+		return GetNeighborSet(bIsTightlyCoupled).Add(Location, Neighbor);
+	}
+
+	void RemoveNeighbor(const FIntVector& Neighbor, bool bIsTightlyCoupled)
+	{
+		GetNeighborSet(bIsTightlyCoupled).Remove(Location, Neighbor);
+	}
+
+	bool HasNeighbor(const FIntVector& Neighbor, bool bIsTightlyCoupled) const
+	{
+		return GetNeighborSet(bIsTightlyCoupled).Contains(Location, Neighbor);
+	}
+
+	// Checks for a neighbor of either type.
+	bool HasNeighbor(const FIntVector& Neighbor) const
+	{
+		return HasNeighbor(Neighbor, false) || HasNeighbor(Neighbor, true);
+	}
+
+	int32 NumNeighbors(bool bIsTightlyCoupled) const
+	{
+		return GetNeighborSet(bIsTightlyCoupled).Num();
+	}
+
+	// Calls Function with the location of every neighbor of the given type.
+	template<typename FunctionType>
+	void ForEachNeighbor(bool bIsTightlyCoupled, FunctionType Function) const
+	{
+		GetNeighborSet(bIsTightlyCoupled).ForEach(Location, Function);
+	}
+
+	// Builds a set of every neighbor of the given type. Prefer HasNeighbor or ForEachNeighbor where possible.
+	TSet<FIntVector> GetNeighbors(bool bIsTightlyCoupled) const
+	{
+		return GetNeighborSet(bIsTightlyCoupled).ToSet(Location);
+	}
+
+	bool HasIncomingRoom() const
+	{
+		return IncomingDirection != NO_DIRECTION;
+	}
+
+	// Returns (-1, -1, -1) if there isn't an incoming room.
+	FIntVector GetIncomingRoom() const
+	{
+		if (!HasIncomingRoom())
+		{
+			return FIntVector(-1, -1, -1);
+		}
+		return Location + FFloorRoomNeighbors::ToOffset(IncomingDirection);
+	}
+
+	// The incoming room has to be in one of the cells touching this room.
+	// Returns false (and clears the incoming room) if it isn't. Pass (-1, -1, -1) to clear it on purpose.
+	bool SetIncomingRoom(const FIntVector& IncomingRoom)
+	{
+		int32 direction = FFloorRoomNeighbors::ToDirection(IncomingRoom - Location);
+		IncomingDirection = direction == INDEX_NONE ? NO_DIRECTION : (uint8)direction;
+		if (direction == INDEX_NONE && IncomingRoom != FIntVector(-1, -1, -1))
+		{
+			UE_LOG(LogSpaceGen, Warning, TEXT("Room at (%d, %d, %d) can't come from (%d, %d, %d), since it isn't next to it! Clearing its incoming room."),
+				Location.X, Location.Y, Location.Z, IncomingRoom.X, IncomingRoom.Y, IncomingRoom.Z);
+		}
+		return direction != INDEX_NONE;
+	}
+
+	// Is this a neighbor which we didn't come from?
+	bool IsOutgoingRoom(const FIntVector& Neighbor) const
+	{
+		if (HasIncomingRoom() && Neighbor == GetIncomingRoom())
+		{
+			return false;
+		}
+		return HasNeighbor(Neighbor);
+	}
+
 	TSet<FIntVector> GetOutgoingRooms() const
 	{
-		TSet<FIntVector> neighbors = TSet<FIntVector>(NeighboringRooms);
-		neighbors.Append(NeighboringTightlyCoupledRooms);
-		neighbors.Remove(IncomingRoom);
+		TSet<FIntVector> neighbors = GetNeighbors(false);
+		neighbors.Append(GetNeighbors(true));
+		if (HasIncomingRoom())
+		{
+			neighbors.Remove(GetIncomingRoom());
+		}
 		return neighbors;
 	}
 };
@@ -101,78 +328,129 @@ public:
 	}
 };
 
+/*
+* Counts how often entire dungeon floors get copied.
+* Floors can be very large, so outside of shipping builds the
+* automation tests check that none get copied while generating a dungeon.
+*/
+struct DUNGEONMAKER_API FDungeonFloorCopyCounter
+{
+private:
+	// Floors can get copied from several threads at once while building mission candidates.
+	static TAtomic<int32> CopyCount;
+
+	static void Increment()
+	{
+#if !UE_BUILD_SHIPPING
+		CopyCount++;
+#endif
+	}
+
+public:
+	FDungeonFloorCopyCounter()
+	{
+	}
+
+	FDungeonFloorCopyCounter(const FDungeonFloorCopyCounter& Other)
+	{
+		Increment();
+	}
+
+	FDungeonFloorCopyCounter(FDungeonFloorCopyCounter&& Other)
+	{
+	}
+
+	FDungeonFloorCopyCounter& operator=(const FDungeonFloorCopyCounter& Other)
+	{
+		Increment();
+		return *this;
+	}
+
+	FDungeonFloorCopyCounter& operator=(FDungeonFloorCopyCounter&& Other)
+	{
+		return *this;
+	}
+
+	static int32 GetCopyCount()
+	{
+		return CopyCount;
+	}
+};
+
+/*
+* A lookup table of every tile used by a dungeon.
+* High-res floors store small indices into this table instead of
+* full FRoomTile structs, which keeps each tile down to a few bytes.
+* Index 0 is reserved for "no tile."
+*/
 USTRUCT(BlueprintType)
-struct DUNGEONMAKER_API FHighResDungeonFloorRow
+struct DUNGEONMAKER_API FDungeonTilePalette
 {
 	GENERATED_BODY()
 
 private:
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
-	TArray<FRoomTile> DungeonTiles;
+	UPROPERTY(VisibleInstanceOnly, meta = (AllowPrivateAccess = "true"))
+	TArray<const UDungeonTile*> Tiles;
+	UPROPERTY()
+	TMap<const UDungeonTile*, uint16> TileIndices;
 
 public:
-	FHighResDungeonFloorRow()
+	static const uint16 EMPTY_TILE = 0;
+
+	FDungeonTilePalette()
 	{
-		DungeonTiles = TArray<FRoomTile>();
+		Tiles = TArray<const UDungeonTile*>();
+		Tiles.Add(NULL);
+		TileIndices = TMap<const UDungeonTile*, uint16>();
 	}
 
-	FHighResDungeonFloorRow(int32 Size)
+	uint16 FindOrAdd(const UDungeonTile* Tile)
 	{
-		DungeonTiles = TArray<FRoomTile>();
-		DungeonTiles.SetNum(Size);
-		for (int i = 0; i < DungeonTiles.Num(); i++)
+		if (Tile == NULL)
 		{
-			DungeonTiles[i] = FRoomTile();
+			return EMPTY_TILE;
 		}
-	}
-
-	void Set(FRoomTile Tile, int32 MaxPossibleRoomSize)
-	{
-		// @TODO: This only does square rooms and does it badly
-		for (int i = 0; i < MaxPossibleRoomSize; i++)
+		const uint16* existingIndex = TileIndices.Find(Tile);
+		if (existingIndex != NULL)
 		{
-			int32 location = MaxPossibleRoomSize * Tile.RoomLocation.X + i;
-			Tile.TileLocation.X = location;
-			DungeonTiles[location] = Tile;
+			return *existingIndex;
 		}
+		checkf(Tiles.Num() <= MAX_uint16, TEXT("Too many unique tiles in one dungeon!"));
+		uint16 index = (uint16)Tiles.Add(Tile);
+		TileIndices.Add(Tile, index);
+		return index;
 	}
 
-	FRoomTile& Get(int Index)
+	bool Find(const UDungeonTile* Tile, uint16& OutIndex) const
 	{
-		return DungeonTiles[Index];
+		const uint16* existingIndex = TileIndices.Find(Tile);
+		if (existingIndex == NULL)
+		{
+			return false;
+		}
+		OutIndex = *existingIndex;
+		return true;
 	}
 
-	TSet<const UDungeonTile*> FindAllTiles(TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL);
-	TSet<FIntVector> GetTileLocations(const UDungeonTile* Tile, int32 Y, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL);
-	TSet<FIntVector> GetTileLocations(const ETileType& TileType, int32 Y, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL);
-
-	bool IsValidLocation(int32 Location) const
+	const UDungeonTile* Get(uint16 Index) const
 	{
-		return DungeonTiles.IsValidIndex(Location);
+		return Tiles[Index];
 	}
 
 	int32 Num() const
 	{
-		return DungeonTiles.Num();
+		return Tiles.Num();
 	}
 
-	FString RoomToString(ADungeonRoom* Room, TArray<FLowResDungeonFloor> LowResFloors);
-
-	FString ToString() const
+	// Returns a bitmask, indexed by palette index, of every tile with the given type.
+	TBitArray<> CreateTileTypeFilter(const ETileType& TileType) const
 	{
-		FString output;
-		for (int i = 0; i < DungeonTiles.Num(); i++)
+		TBitArray<> filter(false, Tiles.Num());
+		for (int i = 1; i < Tiles.Num(); i++)
 		{
-			if (DungeonTiles[i].Tile == NULL)
-			{
-				output += 'X';
-			}
-			else
-			{
-				output += DungeonTiles[i].Tile->TileID.ToString();
-			}
+			filter[i] = Tiles[i] != NULL && Tiles[i]->TileType == TileType;
 		}
-		return output;
+		return filter;
 	}
 };
 
@@ -218,6 +496,11 @@ public:
 		return DungeonRooms[Index];
 	}
 
+	const FFloorRoom& Get(int Index) const
+	{
+		return DungeonRooms[Index];
+	}
+
 	FFloorRoom& operator[] (int Index)
 	{
 		return Get(Index);
@@ -229,123 +512,369 @@ public:
 	}
 };
 
+/*
+* A fixed-size square of tiles on a high-res floor.
+* Pages are only allocated once something gets written to them.
+*/
+USTRUCT()
+struct DUNGEONMAKER_API FHighResDungeonPage
+{
+	GENERATED_BODY()
+
+public:
+	static const int32 PAGE_SIZE = 32;
+
+	// Palette index of the tile at each location, stored as (Y * PAGE_SIZE) + X.
+	UPROPERTY()
+	TArray<uint16> TileIndices;
+	// The room each location belongs to, stored as (Y * PAGE_SIZE) + X.
+	// 0 means no room; anything else is 1 + the room's row-major index on the low-res floor.
+	UPROPERTY()
+	TArray<uint16> RoomIndices;
+
+	bool IsAllocated() const
+	{
+		return TileIndices.Num() > 0;
+	}
+
+	void Allocate()
+	{
+		TileIndices.SetNumZeroed(PAGE_SIZE * PAGE_SIZE);
+		RoomIndices.SetNumZeroed(PAGE_SIZE * PAGE_SIZE);
+	}
+};
+
+/*
+* The tiles making up a single floor of the dungeon.
+* Tiles are stored as palette indices in sparse pages, alongside
+* which low-res room owns each tile. Pages that have never been
+* written to take up no memory and read back as empty tiles.
+*/
 USTRUCT(BlueprintType)
 struct DUNGEONMAKER_API FHighResDungeonFloor
 {
 	GENERATED_BODY()
 private:
-	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
-	TArray<FHighResDungeonFloorRow> Rows;
+	// Stored as (PageY * PagesPerRow) + PageX.
+	UPROPERTY()
+	TArray<FHighResDungeonPage> Pages;
+	UPROPERTY(VisibleInstanceOnly)
+	int32 Width;
+	UPROPERTY(VisibleInstanceOnly)
+	int32 Height;
+	UPROPERTY(VisibleInstanceOnly)
+	int32 RoomSize;
+	FDungeonFloorCopyCounter CopyCounter;
+
+	int32 PagesPerRow() const
+	{
+		return FMath::DivideAndRoundUp(Width, FHighResDungeonPage::PAGE_SIZE);
+	}
+
+	int32 GetPageIndex(int32 X, int32 Y) const
+	{
+		return (Y / FHighResDungeonPage::PAGE_SIZE) * PagesPerRow() + (X / FHighResDungeonPage::PAGE_SIZE);
+	}
+
+	static int32 GetIndexInPage(int32 X, int32 Y)
+	{
+		return (Y % FHighResDungeonPage::PAGE_SIZE) * FHighResDungeonPage::PAGE_SIZE + (X % FHighResDungeonPage::PAGE_SIZE);
+	}
+
+	// Returns NULL if nothing has been written to this page yet.
+	const FHighResDungeonPage* FindPage(int32 X, int32 Y) const
+	{
+		const FHighResDungeonPage& page = Pages[GetPageIndex(X, Y)];
+		return page.IsAllocated() ? &page : NULL;
+	}
+
+	FHighResDungeonPage& FindOrAllocatePage(int32 X, int32 Y)
+	{
+		FHighResDungeonPage& page = Pages[GetPageIndex(X, Y)];
+		if (!page.IsAllocated())
+		{
+			page.Allocate();
+		}
+		return page;
+	}
 
 public:
+	static const uint16 NO_ROOM = 0;
+
 	FHighResDungeonFloor()
 	{
-		Rows = TArray<FHighResDungeonFloorRow>();
+		Pages = TArray<FHighResDungeonPage>();
+		Width = 0;
+		Height = 0;
+		RoomSize = 1;
+	}
+
+	FHighResDungeonFloor(int32 XSize, int32 YSize, int32 MaxRoomSize)
+	{
+		check(XSize >= 0 && YSize >= 0 && MaxRoomSize > 0);
+		Width = XSize;
+		Height = YSize;
+		RoomSize = MaxRoomSize;
+		// Only the page table is allocated up front; pages are allocated on first write
+		Pages = TArray<FHighResDungeonPage>();
+		Pages.SetNum(PagesPerRow() * FMath::DivideAndRoundUp(Height, FHighResDungeonPage::PAGE_SIZE));
+		checkf((Width / RoomSize) * (Height / RoomSize) < MAX_uint16, TEXT("Too many rooms on one floor!"));
 	}
 
-	FHighResDungeonFloor(int32 XSize, int32 YSize)
+	// Fills an entire room with the given tile, and marks each tile as belonging to that room.
+	// This bypasses the tile counts and bitplanes; FDungeonSpace::RebuildTileIndex must be called afterwards.
+	void Set(const FIntVector& RoomLocation, uint16 TileIndex, int32 MaxPossibleRoomSize)
 	{
-		Rows = TArray<FHighResDungeonFloorRow>();
-		Rows.SetNum(YSize);
-		for (int i = 0; i < Rows.Num(); i++)
+		// @TODO: This only does square rooms and does it badly
+		uint16 roomIndex = ToRoomIndex(RoomLocation.X, RoomLocation.Y);
+		for (int y = MaxPossibleRoomSize * RoomLocation.Y; y < MaxPossibleRoomSize * (RoomLocation.Y + 1); y++)
 		{
-			Rows[i] = FHighResDungeonFloorRow(XSize);
+			for (int x = MaxPossibleRoomSize * RoomLocation.X; x < MaxPossibleRoomSize * (RoomLocation.X + 1); x++)
+			{
+				FHighResDungeonPage& page = FindOrAllocatePage(x, y);
+				int32 index = GetIndexInPage(x, y);
+				page.TileIndices[index] = TileIndex;
+				page.RoomIndices[index] = roomIndex;
+			}
 		}
 	}
 
-	void Set(FRoomTile Tile, int32 MaxPossibleRoomSize)
+	uint16 GetTileIndex(int32 X, int32 Y) const
 	{
-		for (int i = 0; i < MaxPossibleRoomSize; i++)
+		const FHighResDungeonPage* page = FindPage(X, Y);
+		return page == NULL ? FDungeonTilePalette::EMPTY_TILE : page->TileIndices[GetIndexInPage(X, Y)];
+	}
+
+	void SetTileIndex(int32 X, int32 Y, uint16 TileIndex)
+	{
+		if (TileIndex == FDungeonTilePalette::EMPTY_TILE && FindPage(X, Y) == NULL)
 		{
-			int32 location = MaxPossibleRoomSize * Tile.RoomLocation.Y + i;
-			Tile.TileLocation.Y = location;
-			Rows[location].Set(Tile, MaxPossibleRoomSize);
+			// Already empty; don't allocate a page just to clear it
+			return;
 		}
+		FindOrAllocatePage(X, Y).TileIndices[GetIndexInPage(X, Y)] = TileIndex;
 	}
 
-	FRoomTile& Get(int X, int Y)
+	// Gets the palette indices starting at (X, Y) and running to the end of that page's row.
+	// Returns NULL if that page hasn't been allocated, meaning every tile in it is empty.
+	const uint16* GetRowSegment(int32 X, int32 Y, int32& OutSegmentEnd) const
 	{
-		return Rows[Y].Get(X);
+		OutSegmentEnd = FMath::Min(Width, (X / FHighResDungeonPage::PAGE_SIZE + 1) * FHighResDungeonPage::PAGE_SIZE);
+		const FHighResDungeonPage* page = FindPage(X, Y);
+		return page == NULL ? NULL : page->TileIndices.GetData() + GetIndexInPage(X, Y);
 	}
 
-	int XSize() const
+	uint16 GetRoomIndex(int32 X, int32 Y) const
 	{
-		if (Rows.Num() == 0)
+		const FHighResDungeonPage* page = FindPage(X, Y);
+		return page == NULL ? NO_ROOM : page->RoomIndices[GetIndexInPage(X, Y)];
+	}
+
+	// Calls Callback(X, Y, TileIndex, RoomIndex) for every non-empty tile, skipping unallocated pages.
+	template <typename FunctorType>
+	void ForEachTile(FunctorType&& Callback) const
+	{
+		const int32 pagesPerRow = PagesPerRow();
+		for (int i = 0; i < Pages.Num(); i++)
 		{
-			return 0;
+			const FHighResDungeonPage& page = Pages[i];
+			if (!page.IsAllocated())
+			{
+				continue;
+			}
+			int32 pageX = (i % pagesPerRow) * FHighResDungeonPage::PAGE_SIZE;
+			int32 pageY = (i / pagesPerRow) * FHighResDungeonPage::PAGE_SIZE;
+			int32 maxX = FMath::Min(FHighResDungeonPage::PAGE_SIZE, Width - pageX);
+			int32 maxY = FMath::Min(FHighResDungeonPage::PAGE_SIZE, Height - pageY);
+			for (int y = 0; y < maxY; y++)
+			{
+				for (int x = 0; x < maxX; x++)
+				{
+					int32 index = y * FHighResDungeonPage::PAGE_SIZE + x;
+					if (page.TileIndices[index] != FDungeonTilePalette::EMPTY_TILE)
+					{
+						Callback(pageX + x, pageY + y, page.TileIndices[index], page.RoomIndices[index]);
+					}
+				}
+			}
 		}
-		else
+	}
+
+	uint16 ToRoomIndex(int32 RoomX, int32 RoomY) const
+	{
+		return (uint16)(1 + RoomY * RoomsPerRow() + RoomX);
+	}
+
+	// Returns the low-res location of the given room, or (-1, -1, -1) for NO_ROOM.
+	FIntVector ToRoomLocation(uint16 RoomIndex, int32 Z) const
+	{
+		if (RoomIndex == NO_ROOM)
 		{
-			return Rows[0].Num();
+			return FIntVector(-1, -1, -1);
 		}
+		return FIntVector((RoomIndex - 1) % RoomsPerRow(), (RoomIndex - 1) / RoomsPerRow(), Z);
+	}
+
+	// Returns the low-res location of the room owning this tile, or (-1, -1, -1) if no room owns it.
+	FIntVector GetRoomLocation(int32 X, int32 Y, int32 Z) const
+	{
+		return ToRoomLocation(GetRoomIndex(X, Y), Z);
+	}
+
+	int32 RoomsPerRow() const
+	{
+		return FMath::Max(1, Width / RoomSize);
+	}
+
+	int32 RoomCount() const
+	{
+		return RoomsPerRow() * (Height / RoomSize);
+	}
+
+	int XSize() const
+	{
+		return Width;
 	}
 
 	int YSize() const
 	{
-		return Rows.Num();
+		return Height;
 	}
 
-	TSet<const UDungeonTile*> FindAllTiles(TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL)
+	bool IsValidLocation(int32 X, int32 Y) const
 	{
-		TSet<const UDungeonTile*> tiles;
-		for (int i = 0; i < Rows.Num(); i++)
-		{
-			tiles.Append(Rows[i].FindAllTiles(LowResFloors, Room));
-		}
-		return tiles;
+		return X >= 0 && Y >= 0 && X < Width && Y < Height;
 	}
 
-	TSet<FIntVector> GetTileLocations(const UDungeonTile* Tile, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL)
+	void DrawDungeonFloor(AActor* Context, int32 ZOffset) const;
+	// Only draws the tiles from Min (inclusive) to Max (exclusive).
+	void DrawDungeonFloor(AActor* Context, int32 ZOffset, const FIntVector& Min, const FIntVector& Max) const;
+
+	FString RoomToString(const TBitArray<>& RoomFilter, const FDungeonTilePalette& Palette) const;
+	FString ToString(const FDungeonTilePalette& Palette) const;
+};
+/*
+* A read-only view of the tiles inside a single room's rectangle.
+* Rather than scanning an entire floor and checking which room owns
+* each tile, this only walks the rows and columns the room covers.
+* Views are cheap to create, but shouldn't outlive the dungeon space
+* they were created from.
+*/
+struct DUNGEONMAKER_API FRoomTileView
+{
+private:
+	const FHighResDungeonFloor* Floor;
+	const FDungeonTilePalette* Palette;
+	// Inclusive minimum corner of the room, in tile space
+	FIntVector Min;
+	// Exclusive maximum corner of the room, in tile space
+	FIntVector Max;
+
+public:
+	FRoomTileView(const FHighResDungeonFloor& RoomFloor, const FDungeonTilePalette& TilePalette, const FIntVector& RoomLocation, const FIntVector& RoomSize)
 	{
-		TSet<FIntVector> locations;
-		for (int y = 0; y < Rows.Num(); y++)
-		{
-			locations.Append(Rows[y].GetTileLocations(Tile, y, Z, LowResFloors, Room));
-		}
-		return locations;
+		Floor = &RoomFloor;
+		Palette = &TilePalette;
+		// Clamp to the floor so callers never have to bounds-check
+		Min = FIntVector(FMath::Max(RoomLocation.X, 0), FMath::Max(RoomLocation.Y, 0), RoomLocation.Z);
+		Max = FIntVector(FMath::Min(RoomLocation.X + RoomSize.X, Floor->XSize()), FMath::Min(RoomLocation.Y + RoomSize.Y, Floor->YSize()), RoomLocation.Z);
 	}
 
-	TSet<FIntVector> GetTileLocations(const ETileType& TileType, int32 Z, TArray<FLowResDungeonFloor>& LowResFloors, ADungeonRoom* Room = NULL)
+	bool Contains(const FIntVector& Location) const
 	{
-		TSet<FIntVector> locations;
-		for (int y = 0; y < Rows.Num(); y++)
+		return Location.Z == Min.Z &&
+			Location.X >= Min.X && Location.X < Max.X &&
+			Location.Y >= Min.Y && Location.Y < Max.Y;
+	}
+
+	// Returns the tile at the given tile-space location, or NULL if it's outside of the room.
+	const UDungeonTile* GetTile(const FIntVector& Location) const
+	{
+		if (!Contains(Location))
 		{
-			locations.Append(Rows[y].GetTileLocations(TileType, y, Z, LowResFloors, Room));
+			return NULL;
 		}
-		return locations;
+		return Palette->Get(Floor->GetTileIndex(Location.X, Location.Y));
 	}
 
-	bool IsValidLocation(int32 X, int32 Y) const
+	// Calls Callback(const FIntVector& Location, const UDungeonTile* Tile) for every non-empty tile in the room.
+	template <typename FunctorType>
+	void ForEachTile(FunctorType&& Callback) const
 	{
-		if (!Rows.IsValidIndex(Y))
+		for (int y = Min.Y; y < Max.Y; y++)
 		{
-			return false;
+			int32 segmentEnd;
+			for (int x = Min.X; x < Max.X; x = segmentEnd)
+			{
+				const uint16* row = Floor->GetRowSegment(x, y, segmentEnd);
+				segmentEnd = FMath::Min(segmentEnd, Max.X);
+				if (row == NULL)
+				{
+					// Unallocated page; everything in it is empty
+					continue;
+				}
+				for (int i = 0; i < segmentEnd - x; i++)
+				{
+					if (row[i] != FDungeonTilePalette::EMPTY_TILE)
+					{
+						Callback(FIntVector(x + i, y, Min.Z), Palette->Get(row[i]));
+					}
+				}
+			}
 		}
-		else
+	}
+
+	// Adds the location of every tile in this room whose palette index is set in TileFilter.
+	// If RoomIndex isn't NO_ROOM, tiles owned by any other room are skipped.
+	void AppendTileLocations(const TBitArray<>& TileFilter, uint16 RoomIndex, TSet<FIntVector>& OutLocations) const
+	{
+		for (int y = Min.Y; y < Max.Y; y++)
 		{
-			return Rows[Y].IsValidLocation(X);
+			int32 segmentEnd;
+			for (int x = Min.X; x < Max.X; x = segmentEnd)
+			{
+				const uint16* row = Floor->GetRowSegment(x, y, segmentEnd);
+				segmentEnd = FMath::Min(segmentEnd, Max.X);
+				if (row == NULL)
+				{
+					continue;
+				}
+				for (int i = 0; i < segmentEnd - x; i++)
+				{
+					if (TileFilter[row[i]] && (RoomIndex == FHighResDungeonFloor::NO_ROOM || Floor->GetRoomIndex(x + i, y) == RoomIndex))
+					{
+						OutLocations.Add(FIntVector(x + i, y, Min.Z));
+					}
+				}
+			}
 		}
 	}
 
-	void DrawDungeonFloor(AActor* Context, int32 ZOffset);
-
-	FString RoomToString(ADungeonRoom* Room, TArray<FLowResDungeonFloor> LowResFloors);
+	// Gets the location of every tile in this room whose palette index is set in TileFilter.
+	TSet<FIntVector> GetTileLocations(const TBitArray<>& TileFilter) const
+	{
+		TSet<FIntVector> locations;
+		AppendTileLocations(TileFilter, FHighResDungeonFloor::NO_ROOM, locations);
+		return locations;
+	}
 
-	FString ToString() const
+	TSet<FIntVector> GetTileLocations(const UDungeonTile* Tile) const
 	{
-		FString output;
-		for (int i = 0; i < Rows.Num(); i++)
+		uint16 tileIndex;
+		if (Tile == NULL || !Palette->Find(Tile, tileIndex))
 		{
-			if (i > 0)
-			{
-				output += "\n";
-			}
-			output += Rows[i].ToString();
+			return TSet<FIntVector>();
 		}
-		return output;
+		TBitArray<> tileFilter(false, Palette->Num());
+		tileFilter[tileIndex] = true;
+		return GetTileLocations(tileFilter);
 	}
-};
 
+	TSet<FIntVector> GetTileLocations(const ETileType& TileType) const
+	{
+		return GetTileLocations(Palette->CreateTileTypeFilter(TileType));
+	}
+};
 
 /*
 * This is a 2D array of FFloorRooms.
@@ -367,6 +896,7 @@ struct DUNGEONMAKER_API FLowResDungeonFloor
 private:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
 	TArray<FLowResDungeonFloorRow> DungeonRooms;
+	FDungeonFloorCopyCounter CopyCounter;
 
 public:
 	FLowResDungeonFloor()
@@ -390,6 +920,11 @@ public:
 		return DungeonRooms[Index];
 	}
 
+	const FLowResDungeonFloorRow& Get(int Index) const
+	{
+		return DungeonRooms[Index];
+	}
+
 	FLowResDungeonFloorRow& operator[] (int Index)
 	{
 		return Get(Index);
@@ -412,7 +947,7 @@ public:
 		return DungeonRooms.Num();
 	}
 
-	void DrawDungeonFloor(AActor* Context, int32 ZOffset);
+	void DrawDungeonFloor(AActor* Context, int32 ZOffset) const;
 
 	FFloorRoom& Set(const FFloorRoom& Room)
 	{
@@ -429,8 +964,141 @@ public:
 
 	void UpdateChildren(FIntVector A, FIntVector B)
 	{
-		DungeonRooms[A.Y][A.X].NeighboringRooms.Add(B);
-		DungeonRooms[B.Y][B.X].NeighboringRooms.Add(A);
+		DungeonRooms[A.Y][A.X].AddNeighbor(B, false);
+		DungeonRooms[B.Y][B.X].AddNeighbor(A, false);
+	}
+};
+
+/*
+* How many of each tile every room owns, split up by floor.
+* FDungeonSpace keeps this up to date whenever a tile changes, so tile
+* queries only have to scan the rooms which have what they're looking for.
+*/
+struct DUNGEONMAKER_API FTileCountIndex
+{
+private:
+	// Indexed as [Floor][Room index][Palette index]. Each room only grows as far as the highest tile it owns.
+	TArray<TArray<TArray<int32>>> Counts;
+
+public:
+	void Reset(const TArray<FHighResDungeonFloor>& Floors)
+	{
+		Counts.Empty(Floors.Num());
+		Counts.SetNum(Floors.Num());
+		for (int i = 0; i < Floors.Num(); i++)
+		{
+			// Room index 0 (no room) gets a slot too, but it's never filled
+			Counts[i].SetNum(Floors[i].RoomCount() + 1);
+		}
+	}
+
+	void Add(int32 Z, uint16 RoomIndex, uint16 TileIndex)
+	{
+		if (RoomIndex == FHighResDungeonFloor::NO_ROOM || TileIndex == FDungeonTilePalette::EMPTY_TILE)
+		{
+			return;
+		}
+		TArray<int32>& roomCounts = Counts[Z][RoomIndex];
+		if (!roomCounts.IsValidIndex(TileIndex))
+		{
+			roomCounts.SetNumZeroed(TileIndex + 1);
+		}
+		roomCounts[TileIndex]++;
+	}
+
+	void Remove(int32 Z, uint16 RoomIndex, uint16 TileIndex)
+	{
+		if (Num(Z, RoomIndex, TileIndex) > 0)
+		{
+			Counts[Z][RoomIndex][TileIndex]--;
+		}
+	}
+
+	int32 Num(int32 Z, uint16 RoomIndex, uint16 TileIndex) const
+	{
+		if (!Counts.IsValidIndex(Z) || !Counts[Z].IsValidIndex(RoomIndex))
+		{
+			return 0;
+		}
+		const TArray<int32>& roomCounts = Counts[Z][RoomIndex];
+		return roomCounts.IsValidIndex(TileIndex) ? roomCounts[TileIndex] : 0;
+	}
+
+	// Counts the tiles owned by a room whose palette index is set in TileFilter.
+	int32 Num(int32 Z, uint16 RoomIndex, const TBitArray<>& TileFilter) const
+	{
+		int32 count = 0;
+		for (TConstSetBitIterator<> tile(TileFilter); tile; ++tile)
+		{
+			count += Num(Z, RoomIndex, (uint16)tile.GetIndex());
+		}
+		return count;
+	}
+};
+
+/*
+* A single write made to a dungeon space while it was journaling.
+* Holds whatever is needed to put things back the way they were.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceJournalEntry
+{
+public:
+	enum class EWriteType : uint8
+	{
+		// A whole low-res room was overwritten; OldRoomIndex points at what was there
+		Room,
+		// Neighbor was added to the room at Location
+		Neighbor,
+		// Neighbor was added to the room at Location as a tightly-coupled neighbor
+		TightlyCoupledNeighbor,
+		// A high-res tile was overwritten; OldTileIndex holds what was there
+		Tile
+	};
+
+	EWriteType WriteType;
+	FIntVector Location;
+	FIntVector Neighbor;
+	// Index into the space's JournalRooms; rooms are too big to keep in every entry
+	int32 OldRoomIndex;
+	uint16 OldTileIndex;
+
+	FDungeonSpaceJournalEntry()
+	{
+		WriteType = EWriteType::Tile;
+		Location = FIntVector(-1, -1, -1);
+		Neighbor = FIntVector(-1, -1, -1);
+		OldRoomIndex = INDEX_NONE;
+		OldTileIndex = FDungeonTilePalette::EMPTY_TILE;
+	}
+};
+
+/*
+* A rectangle of tiles which have changed since dirty regions were last consumed.
+* Min is inclusive, Max is exclusive. Every region lies on a single floor.
+*/
+struct DUNGEONMAKER_API FDungeonDirtyRegion
+{
+public:
+	FIntVector Min;
+	FIntVector Max;
+
+	FDungeonDirtyRegion()
+	{
+		Min = FIntVector::ZeroValue;
+		Max = FIntVector::ZeroValue;
+	}
+
+	FDungeonDirtyRegion(const FIntVector& RegionMin, const FIntVector& RegionMax)
+	{
+		Min = RegionMin;
+		Max = RegionMax;
+	}
+
+	bool Intersects(const FIntVector& OtherMin, const FIntVector& OtherMax) const
+	{
+		return Min.Z < OtherMax.Z && OtherMin.Z < Max.Z &&
+			Min.X < OtherMax.X && OtherMin.X < Max.X &&
+			Min.Y < OtherMax.Y && OtherMin.Y < Max.Y;
 	}
 };
 
@@ -453,10 +1121,59 @@ private:
 	TArray<FLowResDungeonFloor> LowResFloors;
 	UPROPERTY(EditAnywhere, BlueprintReadWrite, meta = (AllowPrivateAccess = "true"))
 	TArray<FHighResDungeonFloor> HighResFloors;
+	UPROPERTY(VisibleInstanceOnly, BlueprintReadOnly, meta = (AllowPrivateAccess = "true"))
+	FDungeonTilePalette TilePalette;
 	UPROPERTY(VisibleInstanceOnly)
 	int32 RoomSize;
 
+	// Not serialized; rebuilt from the high-res floors after loading.
+	FTileCountIndex TileCounts;
+	// Not serialized; one set of bitplanes for each high-res floor.
+	TArray<FDungeonFloorBitplanes> FloorBitplanes;
+	// Not serialized; one bit for every DIRTY_CHUNK_SIZE x DIRTY_CHUNK_SIZE chunk of each floor.
+	TArray<FDungeonBitplane> DirtyChunks;
+
+	// Every write made since the first savepoint, oldest first.
+	TArray<FDungeonSpaceJournalEntry> Journal;
+	// Every room overwritten since the first savepoint, in the same order as their journal entries.
+	// Rooms hold onto spawned rooms and symbols, so these have to be visible to garbage collection.
+	UPROPERTY(Transient)
+	TArray<FFloorRoom> JournalRooms;
+	bool bIsJournaling = false;
+
+	// Writes a tile index and keeps the tile counts, bitplanes, and dirty chunks in sync.
+	// The location must already be valid.
+	void WriteTileIndex(const FIntVector& Location, uint16 NewTileIndex)
+	{
+		FHighResDungeonFloor& floor = GetHighRes(Location.Z);
+		uint16 roomIndex = floor.GetRoomIndex(Location.X, Location.Y);
+		uint16 oldTileIndex = floor.GetTileIndex(Location.X, Location.Y);
+		if (oldTileIndex == NewTileIndex)
+		{
+			return;
+		}
+		if (bIsJournaling)
+		{
+			FDungeonSpaceJournalEntry& entry = Journal[Journal.AddDefaulted()];
+			entry.WriteType = FDungeonSpaceJournalEntry::EWriteType::Tile;
+			entry.Location = Location;
+			entry.OldTileIndex = oldTileIndex;
+		}
+		floor.SetTileIndex(Location.X, Location.Y, NewTileIndex);
+		TileCounts.Remove(Location.Z, roomIndex, oldTileIndex);
+		TileCounts.Add(Location.Z, roomIndex, NewTileIndex);
+		FloorBitplanes[Location.Z].SetTile(Location.X, Location.Y, TilePalette.Get(NewTileIndex), roomIndex != FHighResDungeonFloor::NO_ROOM);
+		DirtyChunks[Location.Z].Set(Location.X / DIRTY_CHUNK_SIZE, Location.Y / DIRTY_CHUNK_SIZE, true);
+	}
+
+	// Creates a bitmask of the room indices on the given floor which belong to a room.
+	// If no room is specified, every location that belongs to any room is accepted.
+	TBitArray<> CreateRoomFilter(int32 Z, const ADungeonRoom* Room) const;
+
 public:
+	// How many tiles (along each side) get marked dirty together.
+	static const int32 DIRTY_CHUNK_SIZE = 8;
+
 	FDungeonSpace()
 	{
 		LowResFloors = TArray<FLowResDungeonFloor>();
@@ -472,26 +1189,70 @@ public:
 		for (int i = 0; i < LowResFloors.Num(); i++)
 		{
 			LowResFloors[i] = FLowResDungeonFloor(LevelSizes[i], LevelSizes[i]);
-			HighResFloors[i] = FHighResDungeonFloor(LevelSizes[i] * MaxRoomSize, LevelSizes[i] * MaxRoomSize);
+			HighResFloors[i] = FHighResDungeonFloor(LevelSizes[i] * MaxRoomSize, LevelSizes[i] * MaxRoomSize, MaxRoomSize);
 		}
 		RoomSize = MaxRoomSize;
+		TileCounts.Reset(HighResFloors);
+		FloorBitplanes.SetNum(HighResFloors.Num());
+		for (int i = 0; i < HighResFloors.Num(); i++)
+		{
+			FloorBitplanes[i] = FDungeonFloorBitplanes(HighResFloors[i].XSize(), HighResFloors[i].YSize());
+		}
+		ClearDirtyRegions();
 	}
 
+	void PostSerialize(const FArchive& Ar)
+	{
+		if (Ar.IsLoading())
+		{
+			RebuildTileIndex();
+		}
+	}
+
+	// Recreates the tile counts and floor bitplanes from scratch by scanning every floor.
+	void RebuildTileIndex();
+
 	FLowResDungeonFloor& GetLowRes(int32 Index)
 	{
 		return LowResFloors[Index];
 	}
 
+	const FLowResDungeonFloor& GetLowRes(int32 Index) const
+	{
+		return LowResFloors[Index];
+	}
+
 	FHighResDungeonFloor& GetHighRes(int32 Index)
 	{
 		return HighResFloors[Index];
 	}
 
+	const FHighResDungeonFloor& GetHighRes(int32 Index) const
+	{
+		return HighResFloors[Index];
+	}
+
+	const FDungeonTilePalette& GetTilePalette() const
+	{
+		return TilePalette;
+	}
+
+	// Gets the walkable/wall/entrance/occupied bitplanes for the given floor.
+	const FDungeonFloorBitplanes& GetBitplanes(int32 Z) const
+	{
+		return FloorBitplanes[Z];
+	}
+
 	FFloorRoom& GetLowRes(const FIntVector& Location)
 	{
 		return GetLowRes(Location.Z).Get(Location.Y).Get(Location.X);
 	}
 
+	const FFloorRoom& GetLowRes(const FIntVector& Location) const
+	{
+		return GetLowRes(Location.Z).Get(Location.Y).Get(Location.X);
+	}
+
 	int LowResXSize() const
 	{
 		if (LowResFloors.Num() == 0)
@@ -526,37 +1287,47 @@ public:
 		return Num();
 	}
 
-	const UDungeonTile* GetTile(const FIntVector& Location)
+	const UDungeonTile* GetTile(const FIntVector& Location) const
 	{
-		FHighResDungeonFloor& floor = GetHighRes(Location.Z);
-		FRoomTile& tile = floor.Get(Location.X, Location.Y);
-		return tile.Tile;
+		const FHighResDungeonFloor& floor = GetHighRes(Location.Z);
+		return TilePalette.Get(floor.GetTileIndex(Location.X, Location.Y));
 	}
 
-	TSet<FIntVector> GetTileLocations(const UDungeonTile* Tile, ADungeonRoom* Room = NULL)
+	// Builds a full FRoomTile for the given location.
+	// Tiles aren't stored this way internally, so this is a copy.
+	FRoomTile GetRoomTile(const FIntVector& Location) const
 	{
-		if (Tile == NULL)
+		const FHighResDungeonFloor& floor = GetHighRes(Location.Z);
+		FIntVector roomLocation = floor.GetRoomLocation(Location.X, Location.Y, Location.Z);
+		return FRoomTile(GetTile(Location), roomLocation, Location);
+	}
+
+	// Creates a view which only looks at the tiles inside the given rectangle.
+	FRoomTileView GetRoomView(const FIntVector& RoomLocation, const FIntVector& RoomDimensions) const
+	{
+		return FRoomTileView(GetHighRes(RoomLocation.Z), TilePalette, RoomLocation, RoomDimensions);
+	}
+
+	TSet<FIntVector> GetTileLocations(const UDungeonTile* Tile, ADungeonRoom* Room = NULL) const
+	{
+		uint16 tileIndex;
+		if (Tile == NULL || !TilePalette.Find(Tile, tileIndex))
 		{
 			return TSet<FIntVector>();
 		}
-		TSet<FIntVector> locations;
-		for (int z = 0; z < HighResFloors.Num(); z++)
-		{
-			locations.Append(HighResFloors[z].GetTileLocations(Tile, z, LowResFloors, Room));
-		}
-		return locations;
+		TBitArray<> tileFilter(false, TilePalette.Num());
+		tileFilter[tileIndex] = true;
+		return GetTileLocations(tileFilter, Room);
 	}
 
-	TSet<FIntVector> GetTileLocations(const ETileType& TileType, ADungeonRoom* Room = NULL)
+	TSet<FIntVector> GetTileLocations(const ETileType& TileType, ADungeonRoom* Room = NULL) const
 	{
-		TSet<FIntVector> locations;
-		for (int z = 0; z < HighResFloors.Num(); z++)
-		{
-			locations.Append(HighResFloors[z].GetTileLocations(TileType, z, LowResFloors, Room));
-		}
-		return locations;
+		return GetTileLocations(TilePalette.CreateTileTypeFilter(TileType), Room);
 	}
 
+	// Gets the location of every tile whose palette index is set in TileFilter.
+	TSet<FIntVector> GetTileLocations(const TBitArray<>& TileFilter, ADungeonRoom* Room = NULL) const;
+
 	void SetTile(const FIntVector& Location, const UDungeonTile* Tile)
 	{
 		if (!HighResFloors.IsValidIndex(Location.Z))
@@ -570,18 +1341,121 @@ public:
 			UE_LOG(LogSpaceGen, Error, TEXT("Invalid tile X, Y location! (%d, %d), max is (%d, %d)."), Location.X, Location.Y, floor.XSize() -1, floor.YSize() - 1);
 			return;
 		}
-		FRoomTile& tile = floor.Get(Location.X, Location.Y);
-		tile.Tile = Tile;
+		WriteTileIndex(Location, TilePalette.FindOrAdd(Tile));
 	}
 
+	bool HasDirtyRegions() const
+	{
+		for (int i = 0; i < DirtyChunks.Num(); i++)
+		{
+			if (DirtyChunks[i].CountSetBits() > 0)
+			{
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Returns every region that SetTile touched since the last call, then forgets about them.
+	// Regions are chunk-aligned, so they may cover a few tiles that didn't actually change.
+	TArray<FDungeonDirtyRegion> ConsumeDirtyRegions();
+	// Forgets about any changed tiles without reporting them.
+	void ClearDirtyRegions();
+
 	void Set(const FFloorRoom& Room)
 	{
+		if (bIsJournaling)
+		{
+			FDungeonSpaceJournalEntry& entry = Journal[Journal.AddDefaulted()];
+			entry.WriteType = FDungeonSpaceJournalEntry::EWriteType::Room;
+			entry.Location = Room.Location;
+			entry.OldRoomIndex = JournalRooms.Add(GetLowRes(Room.Location));
+		}
 		// @TODO: Multi-floor support
 		LowResFloors[Room.Location.Z].Set(Room);
 	}
 
+	// Marks Neighbor as neighboring the room at Location (but not the other way around).
+	void AddNeighbor(const FIntVector& Location, const FIntVector& Neighbor, bool bIsTightlyCoupled)
+	{
+		FFloorRoom& room = GetLowRes(Location);
+		// Neighbors are stored relative to the room, so it has to have been placed here already
+		check(room.Location == Location);
+		if (room.AddNeighbor(Neighbor, bIsTightlyCoupled) && bIsJournaling)
+		{
+			FDungeonSpaceJournalEntry& entry = Journal[Journal.AddDefaulted()];
+			entry.WriteType = bIsTightlyCoupled ? FDungeonSpaceJournalEntry::EWriteType::TightlyCoupledNeighbor : FDungeonSpaceJournalEntry::EWriteType::Neighbor;
+			entry.Location = Location;
+			entry.Neighbor = Neighbor;
+		}
+	}
+
+	// Starts journaling writes (if we weren't already) and returns a savepoint which can be rolled back to.
+	// Only writes made through Set, AddNeighbor, and SetTile are journaled; anything else must wait until the journal is committed.
+	int32 CreateSavepoint()
+	{
+		bIsJournaling = true;
+		return Journal.Num();
+	}
+
+	// Undoes every journaled write made since the given savepoint, newest first.
+	void RollbackToSavepoint(int32 Savepoint);
+
+	// Keeps everything written so far, and stops journaling.
+	void CommitJournal()
+	{
+		Journal.Empty();
+		JournalRooms.Empty();
+		bIsJournaling = false;
+	}
+
+	bool IsJournaling() const
+	{
+		return bIsJournaling;
+	}
+
+	// Returns true if this space was created with the given floor sizes and room size.
+	bool HasLayout(const TArray<int32>& LevelSizes, int32 MaxRoomSize) const
+	{
+		if (RoomSize != MaxRoomSize || LowResFloors.Num() != LevelSizes.Num())
+		{
+			return false;
+		}
+		for (int i = 0; i < LowResFloors.Num(); i++)
+		{
+			if (LowResFloors[i].XSize() != LevelSizes[i] || LowResFloors[i].YSize() != LevelSizes[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	// Returns true if any room has been placed in this space.
+	bool HasAnyRooms() const
+	{
+		for (int z = 0; z < LowResFloors.Num(); z++)
+		{
+			for (int y = 0; y < LowResFloors[z].YSize(); y++)
+			{
+				for (int x = 0; x < LowResFloors[z].XSize(); x++)
+				{
+					const FFloorRoom& room = LowResFloors[z].Get(y).Get(x);
+					if (room.RoomClass != NULL || room.MaxRoomSize > 0)
+					{
+						return true;
+					}
+				}
+			}
+		}
+		return false;
+	}
+
 	void CopyLosResToHighRes(const UDungeonTile* DefaultTile)
 	{
+		// This writes the high-res floors directly, which can't be rolled back
+		check(!bIsJournaling);
+		uint16 defaultTileIndex = TilePalette.FindOrAdd(DefaultTile);
 		for (int x = 0; x < LowResXSize(); x++)
 		{
 			for (int y = 0; y < LowResYSize(); y++)
@@ -589,40 +1463,19 @@ public:
 				for (int z = 0; z < ZSize(); z++)
 				{
 					FIntVector location = FIntVector(x, y, z);
-					FFloorRoom room = GetLowRes(location);
+					const FFloorRoom& room = GetLowRes(location);
 					if (room.MaxRoomSize <= 0)
 					{
 						continue;
 					}
-					FRoomTile roomTile = FRoomTile(DefaultTile, location, FIntVector(-1, -1, location.Z));
-					HighResFloors[location.Z].Set(roomTile, room.MaxRoomSize);
+					HighResFloors[location.Z].Set(location, defaultTileIndex, room.MaxRoomSize);
 				}
 			}
 		}
+		RebuildTileIndex();
 	}
 
-	TSet<const UDungeonTile*> FindAllTiles(ADungeonRoom* Room = NULL)
-	{
-		TSet<const UDungeonTile*> tiles;
-		for (int i = 0; i < HighResFloors.Num(); i++)
-		{
-			tiles.Append(HighResFloors[i].FindAllTiles(LowResFloors, Room));
-		}
-		return tiles;
-	}
-
-	TSet<FIntVector>& GetNeighbors(const FIntVector& Location, bool bGetTightlyCoupled)
-	{
-		FFloorRoom& room = GetLowRes(Location);
-		if (bGetTightlyCoupled)
-		{
-			return room.NeighboringTightlyCoupledRooms;
-		}
-		else
-		{
-			return room.NeighboringRooms;
-		}
-	}
+	TSet<const UDungeonTile*> FindAllTiles(ADungeonRoom* Room = NULL) const;
 
 	FIntVector ConvertHighResLocationToLowRes(const FIntVector& TileSpaceVector) const
 	{
@@ -652,9 +1505,14 @@ public:
 		}
 	}
 
-	FString RoomToString(ADungeonRoom* Room);
+	FString FloorToString(int32 Z) const
+	{
+		return HighResFloors[Z].ToString(TilePalette);
+	}
 
-	void DrawDungeon(AActor* ContextObject)
+	FString RoomToString(ADungeonRoom* Room) const;
+
+	void DrawDungeon(AActor* ContextObject) const
 	{
 		for (int i = 0; i < HighResFloors.Num(); i++)
 		{
@@ -669,4 +1527,13 @@ public:
 		}
 		return FIntVector(HighResFloors[0].XSize(), HighResFloors[0].YSize(), ZSize());
 	}
+};
+
+template<>
+struct TStructOpsTypeTraits<FDungeonSpace> : public TStructOpsTypeTraitsBase2<FDungeonSpace>
+{
+	enum
+	{
+		WithPostSerialize = true,
+	};
 };
\ No newline at end of file
@@ -27,9 +27,9 @@ public:
 	static FIntVector GetRoomTileSpacePosition(ADungeonRoom* Room);
 
 	// Gets the tile at a particular location inside of a room.
-	// Location should be given in tile space. Will return a reference to that tile.
+	// Location should be given in tile space. Will return a copy of that tile.
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
-	static FRoomTile& GetTileAtLocation(ADungeonRoom* Room, const FIntVector& Location);
+	static FRoomTile GetTileAtLocation(ADungeonRoom* Room, const FIntVector& Location);
 
 	// Get the location of all tiles of a certain type.
 	// This can optionally be limited to just grabbing the location of tiles inside of a particular room.
@@ -68,17 +68,17 @@ public:
 
 	// Draws a debug version of the dungeon. Allows you to see where tiles will be placed and how rooms are set up.
 	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeon Generation|Debug")
-	static void DrawDungeon(AActor* ContextObject, FDungeonSpace DungeonSpace);
+	static void DrawDungeon(AActor* ContextObject, const FDungeonSpace& DungeonSpace);
 
 	// Converts a given floor on the dungeon to a string. This will be a text representation of all tiles and rooms
 	// on that floor.
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Debug")
-	static FString FloorToTileString(FDungeonSpace DungeonSpace, uint8 FloorNum);
+	static FString FloorToTileString(const FDungeonSpace& DungeonSpace, uint8 FloorNum);
 
 	// Converts a given room in the dungeon to a string. This will be a text representation of all tiles inside of
 	// that room.
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Debug")
-	static FString RoomToTileString(FDungeonSpace DungeonSpace, ADungeonRoom* Room);
+	static FString RoomToTileString(const FDungeonSpace& DungeonSpace, ADungeonRoom* Room);
 
 	// Do these rooms directly border each other east-west?
 	// Note that this only return true if you can make the rooms border each other by replacing 2 or fewer walls
@@ -101,4 +101,17 @@ public:
 
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
 	static bool AreFloorRoomsAdjacent(const FFloorRoom& First, const FFloorRoom& Second);
+
+	// Gets the floor-space location of every room neighboring this one.
+	// These are built on demand, so avoid calling them every frame.
+	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
+	static TSet<FIntVector> GetNeighboringRooms(const FFloorRoom& Room);
+	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
+	static TSet<FIntVector> GetNeighboringTightlyCoupledRooms(const FFloorRoom& Room);
+	// Gets every neighbor of the room, except for the room we came from.
+	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
+	static TSet<FIntVector> GetOutgoingRooms(const FFloorRoom& Room);
+	// Will return (-1, -1, -1) if the room has no incoming room.
+	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
+	static FIntVector GetIncomingRoom(const FFloorRoom& Room);
 };
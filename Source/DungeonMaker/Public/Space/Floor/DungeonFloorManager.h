@@ -63,6 +63,12 @@ public:
 public:
 	void InitializeFloorManager(UDungeonSpaceGenerator* SpaceGenerator, int32 Level);
 	void CreateRoomTiles(FRandomStream& Rng, const FGroundScatterPairing& GlobalGroundScatter);
+	// Spawns every room on this floor from a saved dungeon, at the size it was saved at.
+	// No entrances are carved and no tiles are replaced; the saved tiles get copied in afterwards.
+	void RestoreRooms(const TMap<FIntVector, FIntVector>& RoomTileSizes, FRandomStream& Rng,
+		const FGroundScatterPairing& GlobalGroundScatter);
+	// Called once the saved tiles are in place.
+	void RestoreRoomInterfaces(FRandomStream& Rng);
 	void DrawDebugSpace();
 	// Gets a room based on tile space coordinates.
 
@@ -71,6 +77,11 @@ public:
 	void SpawnRoomMeshes(TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
 		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
 		FRandomStream& Rng);
+	// Rebuilds the meshes of every tile in a region that changed after the meshes were spawned.
+	void RebuildDirtyRegion(const FDungeonDirtyRegion& Region,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
+		FRandomStream& Rng);
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
 	int XSize() const;
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
@@ -78,12 +89,17 @@ public:
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
 	TSet<FIntVector> GetAllTilesOfType(ETileType Type);
 
-	FFloorRoom GetRoomFromTileSpace(const FIntVector& TileSpaceLocation);
+	const FFloorRoom& GetRoomFromTileSpace(const FIntVector& TileSpaceLocation);
 private:
 	ADungeonRoom* CreateRoom(const FFloorRoom& Room, FRandomStream& Rng, 
 		const FGroundScatterPairing& GlobalGroundScatter);
-	// Returns a COPY of the DungeonFloor we represent.
-	FLowResDungeonFloor GetDungeonFloor() const;
+	ADungeonRoom* SpawnRoom(const FFloorRoom& Room, TSubclassOf<ADungeonRoom> RoomClass, const FIntVector& RoomDimensions,
+		bool bAllowRandomSize, FRandomStream& Rng, const FGroundScatterPairing& GlobalGroundScatter);
+	// Returns the DungeonFloor we represent.
+	const FLowResDungeonFloor& GetDungeonFloor() const;
+	// Returns the room responsible for placing meshes in a low-res cell.
+	// Empty cells belong to the closest room; returns NULL if the floor has no rooms.
+	ADungeonRoom* FindRoomForCell(int32 X, int32 Y) const;
 	void CreateEntrances(ADungeonRoom* Room, FRandomStream& Rng);
 	void DoTileReplacement(ADungeonRoom* Room, FRandomStream& Rng);
 	void DoFloorWideTileReplacement(TArray<FRoomReplacements> ReplacementPhases, FRandomStream &Rng);
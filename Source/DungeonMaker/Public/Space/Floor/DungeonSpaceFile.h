@@ -0,0 +1,228 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "CoreMinimal.h"
+
+#include "DungeonFloor.h"
+
+class IMappedFileHandle;
+class IMappedFileRegion;
+
+/*
+* The on-disk layout of a generated dungeon.
+*
+* Everything is little-endian, 4-byte aligned, and addressed by byte offsets
+* from the start of the file, so a file can be mapped into memory and read in
+* place without deserializing anything first.
+*
+* Layout:
+*   Header
+*   String table (StringCount offsets, followed by null-terminated UTF-8 strings)
+*   Palette (PaletteCount string indices; entry 0 is always the empty tile)
+*   Tile indices (one uint16 palette index per tile, for every floor)
+*   Floors (FloorCount floor records)
+*   Rooms (RoomCount room records)
+*   Neighbors (NeighborCount neighbor records)
+*
+* Any asset references are stored as object paths in the string table.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceFileHeader
+{
+	// String index used for references to nothing.
+	static const uint32 NO_STRING = MAX_uint32;
+
+	uint32 Magic;
+	uint32 Version;
+	uint32 FileSize;
+	int32 RoomSize;
+	uint32 FloorCount;
+	uint32 FloorOffset;
+	uint32 StringCount;
+	uint32 StringOffset;
+	uint32 PaletteCount;
+	uint32 PaletteOffset;
+	uint32 RoomCount;
+	uint32 RoomOffset;
+	uint32 NeighborCount;
+	uint32 NeighborOffset;
+};
+
+struct DUNGEONMAKER_API FDungeonSpaceFileFloor
+{
+	int32 LowResXSize;
+	int32 LowResYSize;
+	int32 HighResXSize;
+	int32 HighResYSize;
+	// Points at HighResXSize * HighResYSize palette indices, stored row by row.
+	uint32 TileOffset;
+	uint32 FirstRoom;
+	uint32 RoomCount;
+};
+
+/*
+* One low-res room which had something placed in it.
+* The neighbors of this room start at FirstNeighbor; the first NeighborCount are
+* regular neighbors, and the TightlyCoupledNeighborCount after that are tightly coupled.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceFileRoom
+{
+	FIntVector Location;
+	// (-1, -1, -1) if the room has no incoming room.
+	FIntVector IncomingRoom;
+	int32 MaxRoomSize;
+	float Difficulty;
+	// String index of the room class which was actually spawned.
+	uint32 RoomClass;
+	// String index of the mission symbol this room was made from.
+	uint32 Symbol;
+	int32 SymbolID;
+	// How large the spawned room ended up being, in tiles.
+	FIntVector TileSize;
+	uint32 FirstNeighbor;
+	uint32 NeighborCount;
+	uint32 TightlyCoupledNeighborCount;
+};
+
+struct DUNGEONMAKER_API FDungeonSpaceFileNeighbor
+{
+	FIntVector Location;
+};
+
+/*
+* Reads a dungeon file straight out of a block of memory.
+* The view doesn't own the memory, which has to outlive it.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceFileView
+{
+private:
+	const uint8* Data;
+	int64 Size;
+
+	// Returns true if Count elements of ElementSize bytes fit at Offset.
+	bool IsValidRange(uint32 Offset, int64 Count, uint32 ElementSize) const
+	{
+		return Offset % 4 == 0 && Count >= 0 && (int64)Offset + Count * (int64)ElementSize <= Size;
+	}
+
+	template<typename T>
+	const T* GetAt(uint32 Offset) const
+	{
+		return reinterpret_cast<const T*>(Data + Offset);
+	}
+
+	// Returns true if the low-res location is inside one of the floors.
+	// Only safe to call once the floor table itself has been validated.
+	bool IsValidRoomLocation(const FIntVector& Location) const;
+
+public:
+	FDungeonSpaceFileView()
+	{
+		Data = NULL;
+		Size = 0;
+	}
+
+	FDungeonSpaceFileView(const uint8* FileData, int64 FileSize)
+	{
+		Data = FileData;
+		Size = FileSize;
+	}
+
+	// Makes sure the header, version, every table, and every index in the file are in bounds.
+	// Nothing else on the view should be used unless this returns true.
+	bool Validate(FString& OutError) const;
+
+	const FDungeonSpaceFileHeader& GetHeader() const
+	{
+		return *GetAt<FDungeonSpaceFileHeader>(0);
+	}
+
+	const FDungeonSpaceFileFloor& GetFloor(int32 Index) const
+	{
+		check((uint32)Index < GetHeader().FloorCount);
+		return GetAt<FDungeonSpaceFileFloor>(GetHeader().FloorOffset)[Index];
+	}
+
+	const uint16* GetTileIndices(const FDungeonSpaceFileFloor& Floor) const
+	{
+		return GetAt<uint16>(Floor.TileOffset);
+	}
+
+	const FDungeonSpaceFileRoom& GetRoom(int32 Index) const
+	{
+		check((uint32)Index < GetHeader().RoomCount);
+		return GetAt<FDungeonSpaceFileRoom>(GetHeader().RoomOffset)[Index];
+	}
+
+	const FDungeonSpaceFileNeighbor& GetNeighbor(int32 Index) const
+	{
+		check((uint32)Index < GetHeader().NeighborCount);
+		return GetAt<FDungeonSpaceFileNeighbor>(GetHeader().NeighborOffset)[Index];
+	}
+
+	// Gets the string index of a palette entry, or NO_STRING for the empty tile.
+	uint32 GetPaletteEntry(int32 Index) const
+	{
+		check((uint32)Index < GetHeader().PaletteCount);
+		return GetAt<uint32>(GetHeader().PaletteOffset)[Index];
+	}
+
+	// Returns an empty string for NO_STRING.
+	FString GetString(uint32 Index) const;
+};
+
+/*
+* Keeps a dungeon file in memory for as long as it's needed.
+* The file is memory-mapped where the platform supports it, and read into
+* a buffer otherwise.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceFileReader
+{
+private:
+	TUniquePtr<IMappedFileHandle> MappedFile;
+	TUniquePtr<IMappedFileRegion> MappedRegion;
+	TArray<uint8> Buffer;
+	FDungeonSpaceFileView View;
+
+public:
+	FDungeonSpaceFileReader();
+	~FDungeonSpaceFileReader();
+
+	bool Open(const FString& FilePath);
+
+	const FDungeonSpaceFileView& GetView() const
+	{
+		return View;
+	}
+};
+
+/*
+* Writes dungeon spaces out to the binary dungeon format, and reads them back in.
+*/
+struct DUNGEONMAKER_API FDungeonSpaceFile
+{
+public:
+	// 'DMSP'
+	static const uint32 MAGIC = 0x50534D44;
+	// Bump this whenever the layout changes; older files are rejected rather than converted.
+	static const uint32 VERSION = 1;
+	// The largest room size a file can have, in tiles along each side.
+	static const int32 MAX_ROOM_SIZE = 256;
+	// The largest floor a file can have, in rooms along each side.
+	// Every room on a floor needs its own uint16 room index, so this can't go much higher.
+	static const int32 MAX_FLOOR_SIZE = 255;
+
+	// Serializes the dungeon space, including which rooms were spawned where.
+	static void Write(const FDungeonSpace& DungeonSpace, TArray<uint8>& OutData);
+	static bool SaveToFile(const FDungeonSpace& DungeonSpace, const FString& FilePath);
+
+	// Rebuilds the rooms and neighbors of a validated file, leaving every room's tiles as the default tile.
+	// The spawned room class of each room goes in RoomClass, and how large it was goes in OutRoomTileSizes.
+	static bool ReadLayout(const FDungeonSpaceFileView& View, const UDungeonTile* DefaultTile, FDungeonSpace& OutDungeonSpace,
+		TMap<FIntVector, FIntVector>& OutRoomTileSizes);
+	// Loads every tile referenced by a validated file, indexed the same way as the file's palette.
+	static bool ReadPalette(const FDungeonSpaceFileView& View, TArray<const UDungeonTile*>& OutPalette);
+	// Overwrites every tile in the dungeon space with the tiles stored in the file.
+	// The dungeon space must have been created by ReadLayout from the same file.
+	static void ReadTiles(const FDungeonSpaceFileView& View, const TArray<const UDungeonTile*>& Palette, FDungeonSpace& DungeonSpace);
+};
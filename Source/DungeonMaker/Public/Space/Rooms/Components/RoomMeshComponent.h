@@ -12,6 +12,17 @@
 
 #include "RoomMeshComponent.generated.h"
 
+/*
+* A single mesh instance that was placed for a tile.
+* We keep track of these so the tile can be rebuilt if it changes later on.
+*/
+struct FPlacedTileInstance
+{
+	TWeakObjectPtr<ASpaceMeshActor> MeshActor;
+	int32 MeshID;
+	int32 InstanceIndex;
+};
+
 UCLASS( ClassGroup=(Custom), meta=(BlueprintSpawnableComponent) )
 class DUNGEONMAKER_API URoomMeshComponent : public UActorComponent
 {
@@ -19,6 +30,10 @@ class DUNGEONMAKER_API URoomMeshComponent : public UActorComponent
 
 private:
 	TArray<TPair<const UDungeonTile*, FTransform>> TileBacklog;
+	// Every mesh instance we've placed, keyed by the tile it was placed for
+	TMap<FIntVector, TArray<FPlacedTileInstance>> PlacedInstances;
+	// Every interaction actor we've spawned, keyed by the tile it was spawned on
+	TMap<FIntVector, TArray<TWeakObjectPtr<AActor>>> SpawnedInteractions;
 
 protected:
 	UPROPERTY()
@@ -54,11 +69,17 @@ public:
 
 private:
 	void ClearTileBacklog();
+	// Removes every mesh and interaction placed for tiles from Min (inclusive) to Max (exclusive).
+	void ClearPlacedTiles(const FIntVector& Min, const FIntVector& Max);
 
 protected:
 	void PlaceTile(TMap<const UDungeonTile*, ASpaceMeshActor*>& ComponentLookup,
 		const UDungeonTile* Tile, int32 MeshID, const FTransform& MeshTransformOffset, const FIntVector& Location);
-	void CreateAllRoomTiles(TMap<const UDungeonTile*, TArray<FIntVector>>& TileLocations,
+	void PlaceTilesInView(const FRoomTileView& RoomTiles,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
+		FRandomStream& Rng);
+	void CreateAllRoomTiles(const FRoomTileView& RoomTiles, TMap<const UDungeonTile*, TArray<FIntVector>>& TileLocations,
 		TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
 		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
 		FRandomStream& Rng);
@@ -72,6 +93,14 @@ public:
 		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
 		FRandomStream& Rng);
 
+	// Tears down and re-places everything for the tiles from Min (inclusive) to Max (exclusive).
+	// Used when tiles change after the room has already been built.
+	// The region may extend past the room itself, for tiles which don't belong to any room.
+	void RebuildRoomTiles(const FIntVector& Min, const FIntVector& Max,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& FloorComponentLookup,
+		TMap<const UDungeonTile*, ASpaceMeshActor*>& CeilingComponentLookup,
+		FRandomStream& Rng);
+
 	void DetermineGroundScatter(TMap<const UDungeonTile*, TArray<FIntVector>> TileLocations,
 		FRandomStream& Rng);
 
@@ -158,6 +158,10 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeon Generation|Rooms|Tiles")
 	void DoTileReplacement(FRandomStream &Rng);
 
+	// Finishes a room whose tiles were loaded from a saved dungeon instead of generated.
+	// Links the room to its neighbors and spawns its interfaces, without touching any tiles.
+	void RestoreRoom(FRandomStream& Rng);
+
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms|Ground Scatter")
 	UGroundScatterManager* GetGroundScatter() const
 	{
@@ -210,6 +214,9 @@ public:
 
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
 	FDungeonSpace& GetDungeon() const;
+
+	// Gets a view of only the tiles inside this room.
+	FRoomTileView GetTileView() const;
 	
 	UFUNCTION(BlueprintPure, Category = "World Generation|Dungeon Generation|Rooms")
 	bool IsChangedAtRuntime() const;
@@ -236,4 +243,8 @@ public:
 protected:
 	virtual void DoTileReplacementPreprocessing(FRandomStream& Rng);
 	virtual void SpawnInterfaces(FRandomStream &Rng);
+
+private:
+	// Spawns interfaces unless they've been turned off for debugging.
+	void TrySpawnInterfaces(FRandomStream& Rng);
 };
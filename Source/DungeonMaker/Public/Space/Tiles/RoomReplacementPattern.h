@@ -248,7 +248,7 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeon Generation|Rooms|Tiles|Replacement")
 	bool FindAndReplace(FDungeonSpace& DungeonSpace, ADungeonRoom* Room, FRandomStream& Rng);
 
-	TArray<FIntVector> FindPossibleReplacements(FDungeonSpace &DungeonSpace, int32 StartX, int32 StartY, int32 StartZ, int32 XSize, int32 YSize) const;
+	TArray<FIntVector> FindPossibleReplacements(const FDungeonSpace& DungeonSpace, int32 StartX, int32 StartY, int32 StartZ, int32 XSize, int32 YSize) const;
 
 	UFUNCTION(BlueprintCallable, Category = "World Generation|Dungeon Generation|Rooms|Tiles|Replacement")
 	bool FindAndReplaceFloor(FDungeonSpace& DungeonSpace, int32 DungeonLevel, FRandomStream& Rng);
@@ -22,13 +22,38 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "State Machine")
 	virtual UStateMachineState* TryBranch(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
 	int32 DataIndex, int32& OutDataIndex);
+	// Returns true if Input is on our list of acceptable inputs. Doesn't take bReverseInputTest into account.
+	bool AcceptsInput(const UStateMachineSymbol* Input) const;
+	// Replaces AcceptableInputs and rebuilds the set AcceptsInput uses.
+	void SetAcceptableInputs(const TArray<UStateMachineSymbol*>& Inputs);
+	const TArray<UStateMachineSymbol*>& GetAcceptableInputs() const
+	{
+		return AcceptableInputs;
+	}
 	// Where we will go if this branch is taken. If this is null, the branch is ignored.
 	UPROPERTY(EditAnywhere)
 	UStateMachineState* DestinationState;
 	// This inverts the branch -- instead of looking FOR something, it's looking for anything BUT something.
 	UPROPERTY(EditAnywhere)
 	bool bReverseInputTest;
+
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+	virtual void PostEditUndo() override;
+#endif
+
+protected:
+	// Rebuilds the set AcceptsInput uses. Happens automatically on load, edit, and undo.
+	void BuildAcceptableInputSet();
+
+	FStateMachineSymbolSet AcceptableInputSet;
+	// Branches made at runtime never get loaded, so they check AcceptableInputs directly until the set is built.
+	bool bHasBuiltAcceptableInputSet = false;
+
+private:
 	// All acceptable inputs. The current input atom must be on this list.
-	UPROPERTY(EditAnywhere)
+	// Private so every change goes through SetAcceptableInputs and keeps AcceptableInputSet up to date.
+	UPROPERTY(EditAnywhere, meta = (AllowPrivateAccess = "true"))
 	TArray<UStateMachineSymbol*> AcceptableInputs;
 };
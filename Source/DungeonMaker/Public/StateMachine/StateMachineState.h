@@ -10,6 +10,18 @@
 
 class UStateMachineSymbol;
 
+/**
+ * One input sequence for UStateMachineState::RunStateBatch.
+ */
+USTRUCT(BlueprintType)
+struct DUNGEONMAKER_API FStateMachineInput
+{
+	GENERATED_BODY()
+public:
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "State Machine")
+	TArray<UStateMachineSymbol*> Symbols;
+};
+
 /**
  * 
  */
@@ -29,17 +41,40 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "State Machine")
 	FStateMachineResult RunState(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource, int32 DataIndex = 0, int32 RemainingSteps = -1) const;
 
-	UFUNCTION(BlueprintCallable, Category = "State Machine")
+	FStateMachineResult RunStateWithBranches(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource, const TArray<UStateMachineBranch*>& Branches, int32 DataIndex = 0, int32 RemainingSteps = -1) const;
+
+	// Kept so existing Blueprints still compile. TakenBranches was never read, so it's ignored.
+	UFUNCTION(BlueprintCallable, Category = "State Machine", meta = (DeprecatedFunction, DeprecationMessage = "Taken Branches is ignored and will be removed."))
 	FStateMachineResult RunStateWithBranches(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource, TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex = 0, int32 RemainingSteps = -1) const;
 
+	// Runs each input through this state the same way RunState would, putting the results in OutResults in the same order.
+	// OutResults keeps its memory between calls, so reusing it avoids allocating.
+	UFUNCTION(BlueprintCallable, Category = "State Machine")
+	void RunStateBatch(const UObject* ReferenceObject, const TArray<FStateMachineInput>& Inputs, TArray<FStateMachineResult>& OutResults,
+		int32 RemainingSteps = -1) const;
+
+	// Same as RunStateBatch, but big batches are split across worker threads. Only use this if every branch the machine
+	// can reach is safe to run on any thread; the built-in branches are, since they only read from themselves.
+	// Not exposed to Blueprint, since Blueprint branches never are.
+	void RunStateBatchParallel(const UObject* ReferenceObject, const TArray<FStateMachineInput>& Inputs, TArray<FStateMachineResult>& OutResults,
+		int32 RemainingSteps = -1) const;
 
 	UFUNCTION(BlueprintCallable, Category = "State Machine")
 	bool Contains(const UStateMachineSymbol* Symbol) const;
-protected:
-	// Loop to the next state. Used when the current state isn't recognized for whatever reason.
-	FStateMachineResult LoopStateWithBranches(const UObject* ReferenceObject,
-		const TArray<UStateMachineSymbol*>& DataSource, TArray<UStateMachineBranch*> Branches, TArray<UStateMachineBranch*> TakenBranches, int32 DataIndex, int32 RemainingSteps) const;
 
+	EStateMachineCompletionType GetCompletionType() const
+	{
+		return CompletionType;
+	}
+
+	bool ShouldTerminateImmediately() const
+	{
+		return bTerminateImmediately;
+	}
+protected:
+	// Runs the machine with FirstBranches tried before SecondBranches, without copying either list.
+	FStateMachineResult RunStateWithBranchLists(const UObject* ReferenceObject, const TArray<UStateMachineSymbol*>& DataSource,
+		const TArray<UStateMachineBranch*>& FirstBranches, const TArray<UStateMachineBranch*>& SecondBranches, int32 DataIndex, int32 RemainingSteps) const;
 
 	// If input runs out on this state, this is how that result will be interpreted. 
 	UPROPERTY(EditAnywhere, Category = "State Machine")
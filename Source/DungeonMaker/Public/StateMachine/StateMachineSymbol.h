@@ -5,6 +5,7 @@
 #include "DungeonMaker.h"
 #include "CoreMinimal.h"
 #include "Engine/DataAsset.h"
+#include "Templates/Atomic.h"
 #include "StateMachineSymbol.generated.h"
 
 /**
@@ -15,7 +16,85 @@ class DUNGEONMAKER_API UStateMachineSymbol : public UDataAsset
 {
 	GENERATED_BODY()
 public:
+	UStateMachineSymbol();
+
 	// The display value for this input atom, mainly for debugging purposes
 	UPROPERTY(EditAnywhere)
 	FName Description;
+
+	// A small number unique to this symbol, so sets of symbols can be stored as bits.
+	// Handed out the first time it's asked for, so only symbols which actually get matched against use one up.
+	int32 GetSymbolIndex() const
+	{
+		int32 index = SymbolIndex.Load();
+		if (index == INDEX_NONE)
+		{
+			index = RegisterSymbolIndex();
+		}
+		return index;
+	}
+
+private:
+	int32 RegisterSymbolIndex() const;
+
+	// Not a UPROPERTY, so duplicates and reinstanced symbols get their own index instead of copying ours.
+	mutable TAtomic<int32> SymbolIndex;
+};
+
+/*
+* Hands out a dense index to every UStateMachineSymbol the first time it's matched against.
+* Class defaults and archetypes are never matched against, so they don't take up an index.
+* Indices are never reused, so they stay valid for as long as the symbol does.
+*/
+struct DUNGEONMAKER_API FStateMachineSymbolRegistry
+{
+public:
+	// Safe to call from any thread.
+	static int32 Register();
+	// One more than the highest index handed out so far.
+	static int32 Num();
+
+private:
+	static TAtomic<int32> SymbolCount;
+};
+
+/*
+* A set of symbols, stored as one bit per symbol index.
+*/
+struct DUNGEONMAKER_API FStateMachineSymbolSet
+{
+private:
+	TArray<uint32, TInlineAllocator<2>> Words;
+
+public:
+	void Reset()
+	{
+		Words.Reset();
+	}
+
+	void Add(const UStateMachineSymbol* Symbol)
+	{
+		if (Symbol == NULL)
+		{
+			return;
+		}
+		int32 index = Symbol->GetSymbolIndex();
+		int32 word = index >> 5;
+		if (word >= Words.Num())
+		{
+			Words.AddZeroed(word + 1 - Words.Num());
+		}
+		Words[word] |= 1u << (index & 31);
+	}
+
+	bool Contains(const UStateMachineSymbol* Symbol) const
+	{
+		if (Symbol == NULL)
+		{
+			return false;
+		}
+		int32 index = Symbol->GetSymbolIndex();
+		int32 word = index >> 5;
+		return word < Words.Num() && (Words[word] & (1u << (index & 31))) != 0;
+	}
 };